@@ -1,4 +1,4 @@
-QT += core widgets
+QT += core widgets network
 
 CONFIG += c++11
 
@@ -19,13 +19,56 @@ SOURCES += \
     main.cpp \
     mainwindow.cpp \
     imageviewer.cpp \
-    imageprocessor.cpp
+    imageloader.cpp \
+    orientedimage.cpp \
+    imageexporter.cpp \
+    deflateencoder.cpp \
+    pngwriter.cpp \
+    jpegpadder.cpp \
+    mappedimage.cpp \
+    imageprocessor.cpp \
+    clicommands.cpp \
+    expansionserver.cpp \
+    expansionclient.cpp \
+    batchprocessor.cpp \
+    batchjournal.cpp \
+    hotfolder.cpp \
+    distancetransform.cpp \
+    colorspace.cpp \
+    fillkernels.cpp \
+    gradientprofile.cpp \
+    patchmatchfill.cpp \
+    poissonseam.cpp \
+    resampler.cpp \
+    variantexporter.cpp
 
 # Header files  
 HEADERS += \
     mainwindow.h \
     imageviewer.h \
-    imageprocessor.h
+    imageloader.h \
+    orientedimage.h \
+    imageexporter.h \
+    deflateencoder.h \
+    pngwriter.h \
+    jpegpadder.h \
+    mappedimage.h \
+    imageprocessor.h \
+    clicommands.h \
+    expansionserver.h \
+    expansionclient.h \
+    batchprocessor.h \
+    batchjournal.h \
+    hotfolder.h \
+    distancetransform.h \
+    colorspace.h \
+    fillkernels.h \
+    gradientprofile.h \
+    parallelfor.h \
+    patchmatchfill.h \
+    poissonseam.h \
+    resampler.h \
+    variantexporter.h
 
 # UI files
 FORMS += \
@@ -0,0 +1,191 @@
+#include "batchjournal.h"
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <algorithm>
+
+BatchJournal::BatchJournal(const QString &directory, int shard, int shardCount)
+    : m_directory(directory)
+    , m_shard(shard)
+    , m_shardCount(shardCount)
+{
+}
+
+QString BatchJournal::fileName(int shard, int shardCount)
+{
+    return QString("shard-%1-of-%2.journal").arg(shard).arg(shardCount);
+}
+
+QString BatchJournal::filePath() const
+{
+    return QDir(m_directory).filePath(fileName(m_shard, m_shardCount));
+}
+
+QStringList BatchJournal::selectShard(const QStringList &manifest, int shard, int shardCount)
+{
+    // 各节点对同一清单排序后按下标轮流分配，结果与参数顺序和节点无关
+    QStringList sorted = manifest;
+    sorted.sort();
+    sorted.removeDuplicates();
+
+    QStringList selected;
+    for (int i = shard - 1; i < sorted.size(); i += shardCount) {
+        selected.append(sorted[i]);
+    }
+    return selected;
+}
+
+bool BatchJournal::open(int itemCount, QString *errorString)
+{
+    const auto fail = [errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        return false;
+    };
+
+    if (!QDir().mkpath(m_directory)) {
+        return fail("无法创建日志目录: " + m_directory);
+    }
+    const QString path = filePath();
+    if (QFile::exists(path)) {
+        readJournal(path, &m_completed);
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return fail("无法打开日志: " + m_file.errorString());
+    }
+    // 上次中断时留下的不完整行单独成行，不与新记录连在一起
+    if (m_file.size() > 0) {
+        QFile tail(path);
+        if (tail.open(QIODevice::ReadOnly) && tail.seek(tail.size() - 1) && tail.read(1) != "\n") {
+            m_file.write("\n");
+        }
+    }
+
+    QJsonObject run;
+    run.insert("run", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+    run.insert("host", QSysInfo::machineHostName());
+    run.insert("shard", m_shard);
+    run.insert("of", m_shardCount);
+    run.insert("items", itemCount);
+    m_file.write(QJsonDocument(run).toJson(QJsonDocument::Compact) + '\n');
+    if (!m_file.flush()) {
+        return fail("无法写入日志: " + m_file.errorString());
+    }
+    return true;
+}
+
+bool BatchJournal::append(const BatchProcessor::Result &result)
+{
+    QJsonObject entry;
+    entry.insert("input", result.inputPath);
+    entry.insert("output", result.outputPath);
+    entry.insert("ok", result.success);
+    entry.insert("ms", result.elapsedMs);
+    entry.insert("pixels", result.success ? static_cast<qint64>(result.size.width()) * result.size.height() : 0);
+    entry.insert("time", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+    if (!result.success) {
+        entry.insert("error", result.errorMessage);
+    }
+    // 一次写出整行并立即刷新，进程被终止时最多丢失正在写的这一行
+    m_file.write(QJsonDocument(entry).toJson(QJsonDocument::Compact) + '\n');
+    if (!m_file.flush()) {
+        return false;
+    }
+    if (result.success) {
+        m_completed.insert(result.inputPath);
+    }
+    return true;
+}
+
+BatchJournal::NodeSummary BatchJournal::readJournal(const QString &path, QSet<QString> *completed)
+{
+    NodeSummary summary;
+    summary.shard = 0;
+    summary.shardCount = 0;
+    summary.items = 0;
+    summary.completed = 0;
+    summary.failed = 0;
+    summary.runs = 0;
+    summary.pixels = 0;
+    summary.wallMs = 0;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return summary;
+    }
+
+    QSet<QString> failed;
+    QDateTime runStart;
+    QDateTime lastFinished;
+    const auto closeRun = [&summary, &runStart, &lastFinished]() {
+        if (runStart.isValid() && lastFinished.isValid() && lastFinished > runStart) {
+            summary.wallMs += runStart.msecsTo(lastFinished);
+        }
+        lastFinished = QDateTime();
+    };
+
+    while (!file.atEnd()) {
+        const QJsonDocument document = QJsonDocument::fromJson(file.readLine());
+        if (!document.isObject()) {
+            continue; // 中断时写了一半的行
+        }
+        const QJsonObject object = document.object();
+        if (object.contains("run")) {
+            closeRun();
+            runStart = QDateTime::fromString(object.value("run").toString(), Qt::ISODateWithMs);
+            summary.host = object.value("host").toString();
+            summary.shard = object.value("shard").toInt();
+            summary.shardCount = object.value("of").toInt();
+            summary.items = object.value("items").toInt();
+            ++summary.runs;
+            continue;
+        }
+
+        const QString input = object.value("input").toString();
+        lastFinished = QDateTime::fromString(object.value("time").toString(), Qt::ISODateWithMs);
+        if (object.value("ok").toBool()) {
+            failed.remove(input);
+            if (!completed->contains(input)) {
+                completed->insert(input);
+                summary.pixels += object.value("pixels").toVariant().toLongLong();
+            }
+        } else if (!completed->contains(input)) {
+            failed.insert(input);
+        }
+    }
+    closeRun();
+
+    summary.completed = completed->size();
+    summary.failed = failed.size();
+    return summary;
+}
+
+QVector<BatchJournal::NodeSummary> BatchJournal::summarize(const QString &directory, QString *errorString)
+{
+    QVector<NodeSummary> summaries;
+    const QDir dir(directory);
+    if (!dir.exists()) {
+        if (errorString) {
+            *errorString = "日志目录不存在: " + directory;
+        }
+        return summaries;
+    }
+
+    const QStringList files = dir.entryList(QStringList() << "shard-*.journal", QDir::Files, QDir::Name);
+    for (const QString &file : files) {
+        QSet<QString> completed;
+        const NodeSummary summary = readJournal(dir.filePath(file), &completed);
+        if (summary.runs > 0) {
+            summaries.append(summary);
+        }
+    }
+    std::sort(summaries.begin(), summaries.end(), [](const NodeSummary &a, const NodeSummary &b) {
+        return a.shardCount != b.shardCount ? a.shardCount < b.shardCount : a.shard < b.shard;
+    });
+    return summaries;
+}
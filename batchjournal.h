@@ -0,0 +1,63 @@
+#ifndef BATCHJOURNAL_H
+#define BATCHJOURNAL_H
+
+#include <QFile>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "batchprocessor.h"
+
+// 分片批处理的日志
+// 每个分片只追加写自己的日志文件（<目录>/shard-<i>-of-<N>.journal），多个节点之间
+// 不需要锁，只要共享同一个文件系统。每行一条紧凑 JSON：
+//   运行开始  {"run", "host", "shard", "of", "items"}
+//   处理完成  {"input", "output", "ok", "ms", "pixels", "time"[, "error"]}
+// 结果经原子重命名写出之后才追加日志，重新运行时跳过日志中已成功的项即可精确续跑；
+// 进程中断时最后一行可能不完整，读取时忽略，该项会被重新处理
+class BatchJournal
+{
+public:
+    BatchJournal(const QString &directory, int shard, int shardCount);
+
+    static QString fileName(int shard, int shardCount);
+
+    // 分片 shard（从 1 开始）在排序后的清单中依次取第 shard、shard + N、… 项
+    static QStringList selectShard(const QStringList &manifest, int shard, int shardCount);
+
+    // 读取已有日志并打开追加，写入本次运行的开始记录
+    bool open(int itemCount, QString *errorString = nullptr);
+    QString filePath() const;
+
+    // 日志中已成功完成的输入
+    const QSet<QString> &completedInputs() const { return m_completed; }
+
+    bool append(const BatchProcessor::Result &result);
+
+    // 单个分片（节点）的汇总
+    struct NodeSummary {
+        int shard;
+        int shardCount;
+        QString host;           // 最近一次运行的主机
+        int items;              // 分片的总项数
+        int completed;
+        int failed;             // 最近一次处理失败且尚未成功的项
+        int runs;
+        qint64 pixels;          // 已完成输出的像素总数
+        qint64 wallMs;          // 各次运行从开始到最后一项完成的时长之和
+    };
+
+    // 汇总目录中所有分片的日志
+    static QVector<NodeSummary> summarize(const QString &directory, QString *errorString = nullptr);
+
+private:
+    static NodeSummary readJournal(const QString &path, QSet<QString> *completed);
+
+    QString m_directory;
+    int m_shard;
+    int m_shardCount;
+    QFile m_file;
+    QSet<QString> m_completed;
+};
+
+#endif // BATCHJOURNAL_H
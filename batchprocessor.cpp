@@ -0,0 +1,216 @@
+#include "batchprocessor.h"
+#include "imageprocessor.h"
+#include "mappedimage.h"
+#include "orientedimage.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <cstring>
+
+namespace {
+
+// 逐块转换时每块的最大字节数
+const int COPY_CHUNK_BYTES = 4 << 20;
+
+// 把图像复制到画布的 rect 区域，按行块转换格式，临时内存有上限
+void copyIntoCanvas(QImage &canvas, const QRect &rect, const QImage &image)
+{
+    // RGB32 与 ARGB32 的不透明像素按位相同
+    const bool direct = image.format() == canvas.format() ||
+                        (image.format() == QImage::Format_RGB32 &&
+                         canvas.format() == QImage::Format_ARGB32);
+    // 带调色板的格式无法按行块包装，先整体转换
+    const QImage source = direct || image.colorCount() == 0
+                          ? image : image.convertToFormat(canvas.format());
+    const bool sourceDirect = direct || source.format() == canvas.format();
+    const size_t rowBytes = static_cast<size_t>(rect.width()) * sizeof(QRgb);
+    const int chunkRows = qMax(1, COPY_CHUNK_BYTES / qMax(1, source.bytesPerLine()));
+
+    for (int y = 0; y < rect.height(); y += chunkRows) {
+        const int rows = qMin(chunkRows, rect.height() - y);
+        QImage chunk;
+        int chunkY = y;
+        if (!sourceDirect) {
+            // 只读包装源图的若干行，不复制
+            const QImage view(source.constScanLine(y), source.width(), rows,
+                              source.bytesPerLine(), source.format());
+            chunk = view.convertToFormat(canvas.format());
+            chunkY = 0;
+        }
+        const QImage &rowsSource = sourceDirect ? source : chunk;
+        for (int row = 0; row < rows; ++row) {
+            uchar *dest = canvas.scanLine(rect.top() + y + row) + rect.left() * sizeof(QRgb);
+            std::memcpy(dest, rowsSource.constScanLine(chunkY + row), rowBytes);
+        }
+    }
+}
+
+// 把画布的 rect 区域包装为共享画布内存的图像（行跨度为画布的行跨度）交给解码器。
+// 解码器输出的尺寸与格式与之相同时直接写入该区域；否则（格式不同）
+// 解码器会另行分配，此时退回复制
+bool decodeIntoCanvas(QImageReader &reader, QImage &canvas, const QRect &rect, bool *inPlace)
+{
+    uchar *origin = canvas.scanLine(rect.top()) + rect.left() * sizeof(QRgb);
+    QImage view(origin, rect.width(), rect.height(), canvas.bytesPerLine(), canvas.format());
+    if (!reader.read(&view)) {
+        return false;
+    }
+    *inPlace = view.constBits() == origin;
+    if (!*inPlace) {
+        if (view.size() != rect.size()) {
+            return false;
+        }
+        copyIntoCanvas(canvas, rect, view);
+    }
+    return true;
+}
+
+} // namespace
+
+BatchProcessor::Options BatchProcessor::defaultOptions()
+{
+    Options options;
+    options.top = 0;
+    options.bottom = 0;
+    options.left = 0;
+    options.right = 0;
+    options.distribution = "center";
+    options.backgroundColor = Qt::white;
+    options.nameSuffix = "_expanded";
+    return options;
+}
+
+BatchProcessor::BatchProcessor(const ImageProcessor *processor)
+    : m_processor(processor)
+    , m_options(defaultOptions())
+    , m_encoderSettings(ImageExporter::defaultEncoderSettings())
+{
+}
+
+QString BatchProcessor::outputPathFor(const QString &inputPath) const
+{
+    const QFileInfo info(inputPath);
+    QString suffix = m_options.format.isEmpty() ? info.suffix().toLower() : m_options.format;
+    if (suffix.isEmpty()) {
+        suffix = "png";
+    }
+    const QString directory = m_options.outputDirectory.isEmpty() ? info.absolutePath()
+                                                                  : m_options.outputDirectory;
+    return QDir(directory).filePath(info.completeBaseName() + m_options.nameSuffix + "." + suffix);
+}
+
+QStringList BatchProcessor::inputNameFilters()
+{
+    QStringList nameFilters;
+    const QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    for (const QByteArray &format : formats) {
+        nameFilters.append("*." + QString::fromLatin1(format));
+    }
+    nameFilters << "*.pam";
+    return nameFilters;
+}
+
+BatchProcessor::Result BatchProcessor::processFile(const QString &inputPath) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Result result;
+    result.inputPath = inputPath;
+    result.outputPath = outputPathFor(inputPath);
+    result.success = false;
+    result.decodedInPlace = false;
+    result.elapsedMs = 0;
+    const auto fail = [&result, &timer](const QString &message) {
+        result.errorMessage = message;
+        result.elapsedMs = timer.elapsed();
+        return result;
+    };
+
+    // 一、只读文件头确定源图尺寸。未压缩格式直接映射，之后从映射区复制一次。
+    // EXIF 方向不交给解码器处理，按存储方向解码后在写入画布的同一遍中完成
+    QImage mapped = MappedImage::read(inputPath);
+    QImageReader reader(inputPath);
+    reader.setAutoTransform(false);
+    const QImageIOHandler::Transformations transformation = reader.transformation();
+    QSize sourceSize;
+    if (!mapped.isNull()) {
+        sourceSize = mapped.size();
+    } else {
+        sourceSize = reader.size();
+        // 文件头中的尺寸为存储方向，旋转 90 度后宽高互换
+        if (sourceSize.isValid() && (reader.transformation() & QImageIOHandler::TransformationRotate90)) {
+            sourceSize.transpose();
+        }
+    }
+    // 少数格式无法预先给出尺寸，带方向的源图无法直接解码到画布，这两种情况先完整解码
+    OrientedImage decoded;
+    if (mapped.isNull() && (!sourceSize.isValid() || sourceSize.isEmpty() ||
+                            transformation != QImageIOHandler::TransformationNone)) {
+        decoded = OrientedImage(reader.read(), transformation);
+        if (decoded.isNull()) {
+            return fail("无法读取图像: " + reader.errorString());
+        }
+        sourceSize = decoded.size();
+    }
+
+    // 二、确定扩展量与画布
+    int top = m_options.top;
+    int bottom = m_options.bottom;
+    int left = m_options.left;
+    int right = m_options.right;
+    if (!m_options.ratio.isEmpty()) {
+        const ImageProcessor::ExpansionValues expansion =
+            m_processor->calculateSmartExpansion(sourceSize, m_options.ratio, m_options.distribution);
+        if (!expansion.isValid && !expansion.alreadySatisfied) {
+            return fail(expansion.errorMessage);
+        }
+        top = expansion.top;
+        bottom = expansion.bottom;
+        left = expansion.left;
+        right = expansion.right;
+    }
+    const QRect sourceRect(left, top, sourceSize.width(), sourceSize.height());
+    result.size = QSize(sourceSize.width() + left + right, sourceSize.height() + top + bottom);
+
+    // 画布取解码器的原生格式，解码器才能直接写入；背景色半透明时须带 alpha
+    QImage::Format canvasFormat = QImage::Format_ARGB32;
+    if (mapped.isNull() && decoded.isNull() && reader.imageFormat() == QImage::Format_RGB32 &&
+        m_options.backgroundColor.alpha() == 255) {
+        canvasFormat = QImage::Format_RGB32;
+    }
+    QImage canvas(result.size, canvasFormat);
+    if (canvas.isNull()) {
+        return fail(QString("无法分配 %1x%2 的画布").arg(result.size.width()).arg(result.size.height()));
+    }
+
+    // 三、源图写入画布
+    if (!mapped.isNull()) {
+        copyIntoCanvas(canvas, sourceRect, mapped);
+        mapped = QImage();
+    } else if (decoded.isTransformed()) {
+        // 按显示方向写入画布，不生成旋转后的中间图像
+        decoded.copyTo(canvas, sourceRect.topLeft());
+        decoded = OrientedImage();
+    } else if (!decoded.isNull()) {
+        copyIntoCanvas(canvas, sourceRect, decoded.storedImage());
+        decoded = OrientedImage();
+    } else if (!decodeIntoCanvas(reader, canvas, sourceRect, &result.decodedInPlace)) {
+        return fail("无法读取图像: " + reader.errorString());
+    }
+
+    // 四、就地生成边距并写出
+    if (!m_processor->renderInPlace(canvas, sourceRect, m_options.backgroundColor)) {
+        return fail("渲染失败");
+    }
+    QString writeError;
+    if (!ImageExporter::write(canvas, result.outputPath, m_encoderSettings, &writeError)) {
+        return fail("无法写入文件：" + result.outputPath + "（" + writeError + "）");
+    }
+
+    result.success = true;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
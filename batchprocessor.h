@@ -0,0 +1,66 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QColor>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include "imageexporter.h"
+
+class ImageProcessor;
+
+// 命令行批处理
+// 扩展量在解码前即可确定（固定值，或按目标比例由 QImageReader::size() 计算），
+// 因此先分配最终画布，让解码器把源图逐行直接写入画布中的源图区域，再就地生成边距：
+// 省去一次整图复制，峰值内存也不再同时包含源图与画布两块缓冲
+class BatchProcessor
+{
+public:
+    struct Options {
+        int top;                    // 固定扩展量
+        int bottom;
+        int left;
+        int right;
+        QString ratio;              // 非空时按目标比例计算扩展量，忽略固定值
+        QString distribution;       // 比例扩展的分配方式（center、top、left 等）
+        QColor backgroundColor;
+        QString outputDirectory;
+        QString format;             // 输出后缀，为空时沿用源文件的后缀
+        QString nameSuffix;         // 追加在源文件名之后
+    };
+
+    // 单个文件的处理结果
+    struct Result {
+        QString inputPath;
+        QString outputPath;
+        QSize size;
+        bool success;
+        bool decodedInPlace;        // 源图是否由解码器直接写入画布
+        QString errorMessage;
+        qint64 elapsedMs;
+    };
+
+    explicit BatchProcessor(const ImageProcessor *processor);
+
+    void setOptions(const Options &options) { m_options = options; }
+    Options options() const { return m_options; }
+    static Options defaultOptions();
+
+    void setEncoderSettings(const ImageExporter::EncoderSettings &settings) { m_encoderSettings = settings; }
+    ImageExporter::EncoderSettings encoderSettings() const { return m_encoderSettings; }
+
+    QString outputPathFor(const QString &inputPath) const;
+    // 可作为输入的文件名过滤器（Qt 可读的格式与 PAM）
+    static QStringList inputNameFilters();
+
+    // 解码、扩展并写出一个文件；只读取配置，可在多个线程中同时调用
+    Result processFile(const QString &inputPath) const;
+
+private:
+    const ImageProcessor *m_processor;
+    Options m_options;
+    ImageExporter::EncoderSettings m_encoderSettings;
+};
+
+#endif // BATCHPROCESSOR_H
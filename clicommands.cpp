@@ -0,0 +1,602 @@
+#include "clicommands.h"
+#include "batchjournal.h"
+#include "batchprocessor.h"
+#include "expansionclient.h"
+#include "expansionserver.h"
+#include "hotfolder.h"
+#include "imageprocessor.h"
+#include "resampler.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QVector>
+#include <functional>
+
+namespace {
+
+const char *const BENCHMARK_RESAMPLER_OPTION = "benchmark-resampler";
+const char *const BATCH_OPTION = "batch";
+const char *const WATCH_OPTION = "watch";
+const char *const SERVE_OPTION = "serve";
+const char *const CLIENT_OPTION = "client";
+const char *const SUMMARY_OPTION = "summary";
+const int DEFAULT_BENCHMARK_REPEAT = 5;
+
+// 进入命令行模式的选项
+const char *const COMMAND_OPTIONS[] = {
+    BENCHMARK_RESAMPLER_OPTION,
+    BATCH_OPTION,
+    WATCH_OPTION,
+    SERVE_OPTION,
+    CLIENT_OPTION,
+    SUMMARY_OPTION
+};
+
+QSize parseSize(const QString &text)
+{
+    static const QRegularExpression pattern("^\\s*(\\d+)\\s*[xX×]\\s*(\\d+)\\s*$");
+    const QRegularExpressionMatch match = pattern.match(text);
+    if (!match.hasMatch()) {
+        return QSize();
+    }
+    return QSize(match.captured(1).toInt(), match.captured(2).toInt());
+}
+
+// 重复执行 repeat 次，返回最短与平均耗时（毫秒）
+void measure(const std::function<QImage()> &resize, int repeat, double &best, double &average)
+{
+    best = 0.0;
+    double total = 0.0;
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        const QImage result = resize();
+        const double elapsed = timer.nsecsElapsed() / 1.0e6;
+        Q_UNUSED(result);
+        total += elapsed;
+        best = i == 0 ? elapsed : qMin(best, elapsed);
+    }
+    average = total / repeat;
+}
+
+int benchmarkResampler(const QString &fileName, const QSize &requestedSize, int repeat)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    
+    QImageReader reader(fileName);
+    QImage source = reader.read();
+    if (source.isNull()) {
+        err << "无法读取图像: " << fileName << " (" << reader.errorString() << ")\n";
+        return 1;
+    }
+    
+    // 默认缩小到长边 1080 像素，与常见的交付尺寸一致
+    QSize size = requestedSize;
+    if (!size.isValid() || size.isEmpty()) {
+        size = source.size().scaled(1080, 1080, Qt::KeepAspectRatio);
+    }
+    
+    // 双方使用相同的输入格式，避免把格式转换计入任一方
+    source = source.convertToFormat(source.hasAlphaChannel()
+                                    ? QImage::Format_ARGB32_Premultiplied
+                                    : QImage::Format_RGB32);
+    
+    out << "源图: " << source.width() << "x" << source.height()
+        << "  目标: " << size.width() << "x" << size.height()
+        << "  重复: " << repeat << " 次\n";
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    
+    struct Candidate {
+        QString name;
+        std::function<QImage()> resize;
+    };
+    QVector<Candidate> candidates;
+    candidates.append({"QImage::scaled (Fast)", [&source, size]() {
+        return source.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+    }});
+    candidates.append({"QImage::scaled (Smooth)", [&source, size]() {
+        return source.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }});
+    const Resampler::Filter filters[] = {
+        Resampler::Box, Resampler::Bilinear, Resampler::Bicubic, Resampler::Lanczos3
+    };
+    for (Resampler::Filter filter : filters) {
+        candidates.append({QString("Resampler (%1)").arg(Resampler::filterName(filter)),
+                           [&source, size, filter]() {
+            return Resampler::resize(source, size, filter);
+        }});
+    }
+    
+    for (const Candidate &candidate : candidates) {
+        // 预热一次，排除首次分配与线程启动的开销
+        candidate.resize();
+        double best = 0.0;
+        double average = 0.0;
+        measure(candidate.resize, repeat, best, average);
+        out << qSetFieldWidth(28) << candidate.name << qSetFieldWidth(0)
+            << "最短 " << QString::number(best, 'f', 1) << " ms  "
+            << "平均 " << QString::number(average, 'f', 1) << " ms\n";
+    }
+    return 0;
+}
+
+// 解析扩展量：一个值用于四边，或按 上,下,左,右 给出四个值
+bool parseExpansion(const QString &text, BatchProcessor::Options &options)
+{
+    const QStringList parts = text.split(',');
+    QVector<int> values;
+    for (const QString &part : parts) {
+        bool ok = false;
+        const int value = part.trimmed().toInt(&ok);
+        if (!ok || value < 0) {
+            return false;
+        }
+        values.append(value);
+    }
+    if (values.size() == 1) {
+        values = QVector<int>(4, values.front());
+    }
+    if (values.size() != 4) {
+        return false;
+    }
+    options.top = values[0];
+    options.bottom = values[1];
+    options.left = values[2];
+    options.right = values[3];
+    return true;
+}
+
+// 展开输入：目录取其中 Qt 可读格式的文件（不递归）
+QStringList collectInputs(const QStringList &arguments)
+{
+    const QStringList nameFilters = BatchProcessor::inputNameFilters();
+    QStringList inputs;
+    for (const QString &argument : arguments) {
+        const QFileInfo info(argument);
+        if (info.isDir()) {
+            const QFileInfoList entries = QDir(argument).entryInfoList(nameFilters, QDir::Files, QDir::Name);
+            for (const QFileInfo &entry : entries) {
+                inputs.append(entry.filePath());
+            }
+        } else {
+            inputs.append(argument);
+        }
+    }
+    return inputs;
+}
+
+// 解析分片：i/N，i 从 1 开始
+bool parseShard(const QString &text, int *shard, int *shardCount)
+{
+    static const QRegularExpression pattern("^\\s*(\\d+)\\s*/\\s*(\\d+)\\s*$");
+    const QRegularExpressionMatch match = pattern.match(text);
+    if (!match.hasMatch()) {
+        return false;
+    }
+    *shard = match.captured(1).toInt();
+    *shardCount = match.captured(2).toInt();
+    return *shardCount >= 1 && *shard >= 1 && *shard <= *shardCount;
+}
+
+// journal 非空时跳过日志中已完成的项，并在每项写出后追加日志
+int runBatch(const QStringList &inputs, const BatchProcessor::Options &options,
+             BatchJournal *journal = nullptr)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    
+    // 分片可能恰好分不到任何项
+    if (inputs.isEmpty() && !journal) {
+        err << "没有输入图像\n";
+        return 1;
+    }
+    if (!QDir().mkpath(options.outputDirectory)) {
+        err << "无法创建输出目录: " << options.outputDirectory << "\n";
+        return 1;
+    }
+    
+    ImageProcessor processor;
+    BatchProcessor batch(&processor);
+    batch.setOptions(options);
+    
+    // 逐个处理，峰值内存只有一块画布；填充与编码内部已多线程执行
+    int failures = 0;
+    int skipped = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (const QString &input : inputs) {
+        if (journal && journal->completedInputs().contains(input)) {
+            ++skipped;
+            continue;
+        }
+        const BatchProcessor::Result result = batch.processFile(input);
+        if (journal && !journal->append(result)) {
+            err << "无法写入日志: " << journal->filePath() << "\n";
+            return 1;
+        }
+        if (result.success) {
+            out << input << " -> " << result.outputPath << "  "
+                << result.size.width() << "x" << result.size.height() << "  "
+                << result.elapsedMs << " ms"
+                << (result.decodedInPlace ? "  （直接解码到画布）" : "") << "\n";
+        } else {
+            ++failures;
+            err << input << ": " << result.errorMessage << "\n";
+        }
+        out.flush();
+    }
+    out << "完成 " << inputs.size() - failures << "/" << inputs.size();
+    if (skipped > 0) {
+        out << "（其中 " << skipped << " 项已在日志中完成）";
+    }
+    out << "，耗时 " << timer.elapsed() << " ms\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// 合并各分片的日志，按节点输出吞吐量
+int printSummary(const QString &journalDirectory)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    
+    QString errorString;
+    const QVector<BatchJournal::NodeSummary> summaries =
+        BatchJournal::summarize(journalDirectory, &errorString);
+    if (summaries.isEmpty()) {
+        err << (errorString.isEmpty() ? QString("没有分片日志: ") + journalDirectory : errorString) << "\n";
+        return 1;
+    }
+    
+    int items = 0;
+    int completed = 0;
+    int failed = 0;
+    qint64 pixels = 0;
+    qint64 longestMs = 0;
+    for (const BatchJournal::NodeSummary &node : summaries) {
+        const double seconds = node.wallMs / 1000.0;
+        out << "分片 " << node.shard << "/" << node.shardCount << "  " << node.host
+            << "  完成 " << node.completed << "/" << node.items
+            << "  失败 " << node.failed
+            << "  运行 " << node.runs << " 次"
+            << "  用时 " << QString::number(seconds, 'f', 1) << " s";
+        if (node.wallMs > 0) {
+            out << "  " << QString::number(node.completed / seconds, 'f', 2) << " 张/秒"
+                << "  " << QString::number(node.pixels / 1.0e6 / seconds, 'f', 1) << " MP/s";
+        }
+        out << "\n";
+        items += node.items;
+        completed += node.completed;
+        failed += node.failed;
+        pixels += node.pixels;
+        longestMs = qMax(longestMs, node.wallMs);
+    }
+    
+    // 各节点并行运行，整体用时取最慢的节点
+    out << "合计  完成 " << completed << "/" << items << "  失败 " << failed;
+    if (longestMs > 0) {
+        const double seconds = longestMs / 1000.0;
+        out << "  用时 " << QString::number(seconds, 'f', 1) << " s"
+            << "  " << QString::number(completed / seconds, 'f', 2) << " 张/秒"
+            << "  " << QString::number(pixels / 1.0e6 / seconds, 'f', 1) << " MP/s";
+    }
+    out << "\n";
+    return completed == items && failed == 0 ? 0 : 1;
+}
+
+// 监视输入目录并持续处理，直到进程被终止
+int runWatch(QCoreApplication &app, const QString &inputDirectory,
+             const BatchProcessor::Options &options, int workers, int pollInterval)
+{
+    QTextStream err(stderr);
+    
+    ImageProcessor processor;
+    BatchProcessor batch(&processor);
+    batch.setOptions(options);
+    
+    HotFolder hotFolder(&batch);
+    if (workers > 0) {
+        hotFolder.setWorkerCount(workers);
+    }
+    hotFolder.setPollInterval(pollInterval);
+    
+    QObject::connect(&hotFolder, &HotFolder::fileProcessed,
+                     [&hotFolder](const BatchProcessor::Result &result) {
+        QTextStream out(stdout);
+        QTextStream err(stderr);
+        if (result.success) {
+            out << result.inputPath << " -> " << result.outputPath << "  "
+                << result.size.width() << "x" << result.size.height() << "  "
+                << result.elapsedMs << " ms  （排队 " << hotFolder.pendingCount() << "）\n";
+        } else {
+            err << result.inputPath << ": " << result.errorMessage << "\n";
+        }
+    });
+    
+    QString errorString;
+    if (!hotFolder.start(inputDirectory, &errorString)) {
+        err << errorString << "\n";
+        return 1;
+    }
+    
+    QTextStream out(stdout);
+    out << "正在监视 " << inputDirectory << " -> " << options.outputDirectory
+        << "（" << hotFolder.workerCount() << " 个工作线程"
+        << (hotFolder.isPolling() ? "，定时轮询" : "") << "）\n";
+    out.flush();
+    return app.exec();
+}
+
+// 本机扩展服务，直到进程被终止
+int runServer(QCoreApplication &app, const QString &name, int workers)
+{
+    QTextStream err(stderr);
+    
+    ImageProcessor processor;
+    ExpansionServer server(&processor);
+    if (workers > 0) {
+        server.setWorkerCount(workers);
+    }
+    QString errorString;
+    if (!server.listen(name, &errorString)) {
+        err << "无法启动服务: " << errorString << "\n";
+        return 1;
+    }
+    
+    QTextStream out(stdout);
+    out << "扩展服务已启动: " << server.serverName()
+        << "（" << server.workerCount() << " 个工作线程）\n";
+    out.flush();
+    return app.exec();
+}
+
+// 向本机服务逐个提交图像，报告往返延迟与服务端统计；指定输出目录时保存结果
+int runClient(const QString &name, const QStringList &inputs, const BatchProcessor::Options &options,
+              const QString &outputDirectory, int repeat)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    
+    if (inputs.isEmpty()) {
+        err << "没有输入图像\n";
+        return 1;
+    }
+    ExpansionClient client;
+    if (!client.connectToServer(name)) {
+        err << client.errorString() << "\n";
+        return 1;
+    }
+    if (!outputDirectory.isEmpty() && !QDir().mkpath(outputDirectory)) {
+        err << "无法创建输出目录: " << outputDirectory << "\n";
+        return 1;
+    }
+    BatchProcessor naming(nullptr);
+    BatchProcessor::Options namingOptions = options;
+    namingOptions.outputDirectory = outputDirectory;
+    naming.setOptions(namingOptions);
+    
+    int failures = 0;
+    for (const QString &input : inputs) {
+        QImageReader reader(input);
+        reader.setAutoTransform(true);
+        const QImage image = reader.read();
+        if (image.isNull()) {
+            ++failures;
+            err << input << ": 无法读取图像 (" << reader.errorString() << ")\n";
+            continue;
+        }
+        
+        // 往返延迟包含写入源图段、服务端排队与渲染、映射结果段
+        QImage result;
+        ExpansionClient::Timing timing;
+        double best = 0.0;
+        double total = 0.0;
+        for (int i = 0; i < repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            result = client.expand(image, options, &timing);
+            const double elapsed = timer.nsecsElapsed() / 1.0e6;
+            if (result.isNull()) {
+                break;
+            }
+            total += elapsed;
+            best = i == 0 ? elapsed : qMin(best, elapsed);
+        }
+        if (result.isNull()) {
+            ++failures;
+            err << input << ": " << client.errorString() << "\n";
+            continue;
+        }
+        
+        out << input << "  " << result.width() << "x" << result.height()
+            << "  往返最短 " << QString::number(best, 'f', 2) << " ms"
+            << "  平均 " << QString::number(total / repeat, 'f', 2) << " ms"
+            << "  服务端渲染 " << QString::number(timing.renderUs / 1000.0, 'f', 2) << " ms\n";
+        if (!outputDirectory.isEmpty()) {
+            const QString outputPath = naming.outputPathFor(input);
+            QString writeError;
+            if (!ImageExporter::write(result, outputPath, ImageExporter::defaultEncoderSettings(),
+                                      &writeError)) {
+                ++failures;
+                err << "无法写入文件：" << outputPath << "（" << writeError << "）\n";
+            }
+        }
+        out.flush();
+    }
+    
+    QJsonObject stats;
+    if (client.requestStats(&stats)) {
+        out << "服务端延迟（最近 " << stats.value("count").toInt() << " 个请求）: "
+            << "平均 " << stats.value("meanUs").toInt() << " us  "
+            << "P50 " << stats.value("p50Us").toInt() << " us  "
+            << "P95 " << stats.value("p95Us").toInt() << " us  "
+            << "P99 " << stats.value("p99Us").toInt() << " us  "
+            << "最大 " << stats.value("maxUs").toInt() << " us\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+} // namespace
+
+bool CliCommands::isCommandLineMode(int argc, char *argv[])
+{
+    for (const char *option : COMMAND_OPTIONS) {
+        const QByteArray name = QByteArray("--") + option;
+        for (int i = 1; i < argc; ++i) {
+            const QByteArray argument(argv[i]);
+            if (argument == name || argument.startsWith(name + '=')) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int CliCommands::run(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("图像背景扩展工具（命令行模式）");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    
+    const QCommandLineOption benchmarkOption(BENCHMARK_RESAMPLER_OPTION,
+        "对比重采样器与 QImage::scaled 的缩放耗时。", "image");
+    const QCommandLineOption sizeOption("size",
+        "目标尺寸，如 1920x1080（默认长边 1080 像素）。", "WxH");
+    const QCommandLineOption repeatOption("repeat",
+        "每种方法的重复次数；客户端模式下为每张图像的请求次数。", "count", QString::number(DEFAULT_BENCHMARK_REPEAT));
+    const QCommandLineOption batchOption(BATCH_OPTION,
+        "批量扩展输入的图像（文件或目录），结果写入该目录。", "directory");
+    const QCommandLineOption expandOption("expand",
+        "固定扩展量：一个值用于四边，或 上,下,左,右。", "pixels");
+    const QCommandLineOption ratioOption("ratio",
+        "按目标比例计算扩展量，如 16:9（优先于 --expand）。", "ratio");
+    const QCommandLineOption distributionOption("distribution",
+        "比例扩展的分配方式：center、start、end。", "mode", "center");
+    const QCommandLineOption colorOption("color",
+        "背景色，如 #ffffff。", "color", "#ffffff");
+    const QCommandLineOption formatOption("format",
+        "输出格式后缀（默认沿用源文件）。", "suffix");
+    const QCommandLineOption watchOption(WATCH_OPTION,
+        "监视该目录，新图像写入完成后自动扩展。", "directory");
+    const QCommandLineOption outputOption("output",
+        "监视模式的输出目录（默认为监视目录下的 expanded）；客户端模式下指定时保存结果。", "directory");
+    const QCommandLineOption workersOption("workers",
+        "监视模式或服务同时处理的文件或请求数（默认为 CPU 核心数）。", "count");
+    const QCommandLineOption pollOption("poll",
+        "监视模式定时轮询的间隔，用于不产生文件通知的网络共享。", "ms", "0");
+    const QCommandLineOption serveOption(SERVE_OPTION,
+        "以该名称启动本机扩展服务（QLocalServer，像素经共享内存传递）。", "name");
+    const QCommandLineOption clientOption(CLIENT_OPTION,
+        "把输入图像提交给该名称的本机服务，报告往返延迟。", "name");
+    const QCommandLineOption shardOption("shard",
+        "批处理只处理排序后清单中的第 i 个分片（共 N 个），并记录日志以便续跑。", "i/N");
+    const QCommandLineOption journalOption("journal",
+        "批处理日志目录（默认为输出目录下的 .journal），须为各节点共享的目录。", "directory");
+    const QCommandLineOption summaryOption(SUMMARY_OPTION,
+        "合并该日志目录中各分片的日志，输出每个节点的吞吐量。", "directory");
+    parser.addOption(benchmarkOption);
+    parser.addOption(sizeOption);
+    parser.addOption(repeatOption);
+    parser.addOption(batchOption);
+    parser.addOption(expandOption);
+    parser.addOption(ratioOption);
+    parser.addOption(distributionOption);
+    parser.addOption(colorOption);
+    parser.addOption(formatOption);
+    parser.addOption(watchOption);
+    parser.addOption(outputOption);
+    parser.addOption(workersOption);
+    parser.addOption(pollOption);
+    parser.addOption(serveOption);
+    parser.addOption(clientOption);
+    parser.addOption(shardOption);
+    parser.addOption(journalOption);
+    parser.addOption(summaryOption);
+    parser.addPositionalArgument("images", "批处理的输入图像或目录。", "[images...]");
+    parser.process(app);
+    
+    QTextStream err(stderr);
+    if (parser.isSet(benchmarkOption)) {
+        QSize size;
+        if (parser.isSet(sizeOption)) {
+            size = parseSize(parser.value(sizeOption));
+            if (size.isEmpty()) {
+                err << "无效的尺寸: " << parser.value(sizeOption) << "\n";
+                return 1;
+            }
+        }
+        const int repeat = qMax(1, parser.value(repeatOption).toInt());
+        return benchmarkResampler(parser.value(benchmarkOption), size, repeat);
+    }
+    
+    if (parser.isSet(summaryOption)) {
+        return printSummary(parser.value(summaryOption));
+    }
+    
+    if (parser.isSet(serveOption)) {
+        return runServer(app, parser.value(serveOption), parser.value(workersOption).toInt());
+    }
+    
+    if (parser.isSet(batchOption) || parser.isSet(watchOption) || parser.isSet(clientOption)) {
+        BatchProcessor::Options options = BatchProcessor::defaultOptions();
+        options.ratio = parser.value(ratioOption);
+        options.distribution = parser.value(distributionOption);
+        options.format = parser.value(formatOption).toLower();
+        options.backgroundColor = QColor(parser.value(colorOption));
+        if (!options.backgroundColor.isValid()) {
+            err << "无效的颜色: " << parser.value(colorOption) << "\n";
+            return 1;
+        }
+        if (parser.isSet(expandOption) && !parseExpansion(parser.value(expandOption), options)) {
+            err << "无效的扩展量: " << parser.value(expandOption) << "\n";
+            return 1;
+        }
+        
+        if (parser.isSet(clientOption)) {
+            const int repeat = qMax(1, parser.value(repeatOption).toInt());
+            return runClient(parser.value(clientOption), collectInputs(parser.positionalArguments()),
+                             options, parser.value(outputOption), repeat);
+        }
+        if (parser.isSet(watchOption)) {
+            const QString inputDirectory = parser.value(watchOption);
+            options.outputDirectory = parser.isSet(outputOption)
+                                      ? parser.value(outputOption)
+                                      : QDir(inputDirectory).filePath("expanded");
+            return runWatch(app, inputDirectory, options,
+                            parser.value(workersOption).toInt(), parser.value(pollOption).toInt());
+        }
+        options.outputDirectory = parser.value(batchOption);
+        const QStringList inputs = collectInputs(parser.positionalArguments());
+        if (!parser.isSet(shardOption) && !parser.isSet(journalOption)) {
+            return runBatch(inputs, options);
+        }
+        
+        // 分片或指定日志时按排序后的清单处理，中断后以相同参数重新运行即可续跑
+        int shard = 1;
+        int shardCount = 1;
+        if (parser.isSet(shardOption) && !parseShard(parser.value(shardOption), &shard, &shardCount)) {
+            err << "无效的分片: " << parser.value(shardOption) << "\n";
+            return 1;
+        }
+        const QStringList selected = BatchJournal::selectShard(inputs, shard, shardCount);
+        BatchJournal journal(parser.isSet(journalOption)
+                             ? parser.value(journalOption)
+                             : QDir(options.outputDirectory).filePath(".journal"),
+                             shard, shardCount);
+        QString errorString;
+        if (!journal.open(selected.size(), &errorString)) {
+            err << errorString << "\n";
+            return 1;
+        }
+        return runBatch(selected, options, &journal);
+    }
+    
+    parser.showHelp(1);
+    return 1;
+}
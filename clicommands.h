@@ -0,0 +1,17 @@
+#ifndef CLICOMMANDS_H
+#define CLICOMMANDS_H
+
+class QCoreApplication;
+
+// 命令行模式
+// 不创建图形界面，直接执行基准测试、批处理等无界面任务
+namespace CliCommands
+{
+    // 参数中包含命令行模式的选项时返回 true，须在创建 QApplication 之前调用
+    bool isCommandLineMode(int argc, char *argv[]);
+
+    // 解析参数并执行，返回进程退出码
+    int run(QCoreApplication &app);
+}
+
+#endif // CLICOMMANDS_H
@@ -0,0 +1,52 @@
+#include "colorspace.h"
+#include <cmath>
+
+namespace {
+
+double srgbToLinear(double value)
+{
+    return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+}
+
+double linearToSrgb(double value)
+{
+    return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+}
+
+struct Tables {
+    quint16 toLinear[256];
+    quint8 toSrgb[ColorSpace::LINEAR_TO_SRGB_SIZE];
+    
+    Tables()
+    {
+        for (int i = 0; i < 256; ++i) {
+            toLinear[i] = static_cast<quint16>(qRound(srgbToLinear(i / 255.0) * 65535.0));
+        }
+        // 每项取该区间中点的线性值，使量化误差对称
+        for (int i = 0; i < ColorSpace::LINEAR_TO_SRGB_SIZE; ++i) {
+            const double linear = (i + 0.5) / ColorSpace::LINEAR_TO_SRGB_SIZE;
+            toSrgb[i] = static_cast<quint8>(qBound(0, qRound(linearToSrgb(linear) * 255.0), 255));
+        }
+        toSrgb[0] = 0;
+        toSrgb[ColorSpace::LINEAR_TO_SRGB_SIZE - 1] = 255;
+    }
+};
+
+// 函数内静态对象的初始化是线程安全的
+const Tables &tables()
+{
+    static const Tables instance;
+    return instance;
+}
+
+} // namespace
+
+const quint16 *ColorSpace::srgbToLinearTable()
+{
+    return tables().toLinear;
+}
+
+const quint8 *ColorSpace::linearToSrgbTable()
+{
+    return tables().toSrgb;
+}
@@ -0,0 +1,20 @@
+#ifndef COLORSPACE_H
+#define COLORSPACE_H
+
+#include <QtGlobal>
+
+// sRGB 与线性光之间的转换查找表
+// 线性值使用 16 位定点（0..65535），反向转换表按线性值高 12 位索引
+namespace ColorSpace
+{
+    constexpr int LINEAR_TO_SRGB_BITS = 12;
+    constexpr int LINEAR_TO_SRGB_SIZE = 1 << LINEAR_TO_SRGB_BITS;
+    
+    // 256 项：8 位 sRGB → 16 位线性
+    const quint16 *srgbToLinearTable();
+    
+    // 4096 项：线性值 >> 4 → 8 位 sRGB
+    const quint8 *linearToSrgbTable();
+}
+
+#endif // COLORSPACE_H
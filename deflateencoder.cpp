@@ -0,0 +1,674 @@
+#include "deflateencoder.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cstring>
+
+constexpr int DeflateEncoder::DEFAULT_LEVEL;
+
+namespace {
+
+const int MIN_MATCH = 3;
+const int MAX_MATCH = 258;
+const int WINDOW_SIZE = 32768;
+const int HASH_BITS = 15;
+const int HASH_SIZE = 1 << HASH_BITS;
+// 距离过远的最短匹配不如直接输出字面量
+const int TOO_FAR = 4096;
+// 每个块最多容纳的符号数，块越大哈夫曼表越不贴合局部统计
+const size_t MAX_BLOCK_SYMBOLS = 16384;
+const size_t MAX_STORED_BLOCK = 65535;
+
+const int LITERAL_CODES = 286;
+const int DISTANCE_CODES = 30;
+const int CODE_LENGTH_CODES = 19;
+const int END_OF_BLOCK = 256;
+const int MAX_BITS = 15;
+const int MAX_CODE_LENGTH_BITS = 7;
+
+const int LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const int LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const int DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const int DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+const int CODE_LENGTH_ORDER[CODE_LENGTH_CODES] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// 各级别的匹配参数（与 zlib 的配置表含义相同）
+struct LevelConfig {
+    int goodLength;     // 前一个匹配达到该长度时缩短搜索链
+    int maxLazy;        // 前一个匹配达到该长度时不再尝试惰性匹配
+    int niceLength;     // 找到该长度的匹配即停止搜索
+    int maxChain;       // 最多检查的候选位置数
+};
+
+const LevelConfig LEVEL_CONFIGS[10] = {
+    {0, 0, 0, 0},
+    {4, 4, 8, 4},
+    {4, 5, 16, 8},
+    {4, 6, 32, 32},
+    {4, 4, 16, 16},
+    {8, 16, 32, 32},
+    {8, 16, 128, 128},
+    {8, 32, 128, 256},
+    {32, 128, 258, 1024},
+    {32, 258, 258, 4096}
+};
+
+// 长度与距离到编码下标的查找表
+struct CodeTables {
+    uchar lengthCode[MAX_MATCH + 1];
+    uchar distanceCode[512];
+    quint16 fixedLiteralCodes[288];
+    uchar fixedLiteralLengths[288];
+    quint16 fixedDistanceCodes[DISTANCE_CODES];
+    uchar fixedDistanceLengths[DISTANCE_CODES];
+
+    CodeTables();
+};
+
+quint16 reverseBits(quint32 code, int length)
+{
+    quint32 result = 0;
+    for (int i = 0; i < length; ++i) {
+        result = (result << 1) | (code & 1);
+        code >>= 1;
+    }
+    return static_cast<quint16>(result);
+}
+
+// 由码长生成规范哈夫曼编码（按输出顺序位反转）
+void buildCodes(const uchar *lengths, int count, quint16 *codes)
+{
+    int lengthCount[MAX_BITS + 1] = {0};
+    for (int i = 0; i < count; ++i) {
+        ++lengthCount[lengths[i]];
+    }
+    lengthCount[0] = 0;
+
+    int nextCode[MAX_BITS + 1] = {0};
+    int code = 0;
+    for (int bits = 1; bits <= MAX_BITS; ++bits) {
+        code = (code + lengthCount[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+    for (int i = 0; i < count; ++i) {
+        codes[i] = lengths[i] ? reverseBits(nextCode[lengths[i]]++, lengths[i]) : 0;
+    }
+}
+
+CodeTables::CodeTables()
+{
+    for (int code = 0; code < 29; ++code) {
+        const int end = code == 28 ? MAX_MATCH + 1 : LENGTH_BASE[code + 1];
+        for (int length = LENGTH_BASE[code]; length < end; ++length) {
+            lengthCode[length] = static_cast<uchar>(code);
+        }
+    }
+
+    // 距离 1-256 直接查表，更远的距离按 128 为单位查表
+    for (int code = 0; code < DISTANCE_CODES; ++code) {
+        const int end = code == DISTANCE_CODES - 1 ? WINDOW_SIZE + 1 : DISTANCE_BASE[code + 1];
+        for (int distance = DISTANCE_BASE[code]; distance < end; ++distance) {
+            if (distance <= 256) {
+                distanceCode[distance - 1] = static_cast<uchar>(code);
+            } else {
+                distanceCode[256 + ((distance - 1) >> 7)] = static_cast<uchar>(code);
+            }
+        }
+    }
+
+    for (int i = 0; i < 288; ++i) {
+        fixedLiteralLengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    }
+    buildCodes(fixedLiteralLengths, 288, fixedLiteralCodes);
+    std::fill(fixedDistanceLengths, fixedDistanceLengths + DISTANCE_CODES, 5);
+    buildCodes(fixedDistanceLengths, DISTANCE_CODES, fixedDistanceCodes);
+}
+
+const CodeTables &codeTables()
+{
+    static const CodeTables tables;
+    return tables;
+}
+
+inline int distanceCodeOf(const CodeTables &tables, int distance)
+{
+    return distance <= 256 ? tables.distanceCode[distance - 1]
+                           : tables.distanceCode[256 + ((distance - 1) >> 7)];
+}
+
+// 由符号频率计算限长的哈夫曼码长
+// 先按标准哈夫曼算法求出码长，超长时按 JPEG 附录 K.2 的方法调整各长度的码字数，
+// 再按频率从高到低依次分配最短的码长
+void buildCodeLengths(const quint32 *frequencies, int count, int maxBits, uchar *lengths)
+{
+    std::fill(lengths, lengths + count, 0);
+
+    std::vector<quint64> weights;
+    std::vector<int> symbols;
+    for (int i = 0; i < count; ++i) {
+        if (frequencies[i]) {
+            symbols.push_back(i);
+        }
+    }
+    // 至少两个符号，保证码表完整（只有一个码字时部分解码器会拒绝）
+    for (int i = 0; symbols.size() < 2 && i < count; ++i) {
+        if (!frequencies[i]) {
+            symbols.push_back(i);
+        }
+    }
+    std::sort(symbols.begin(), symbols.end(), [frequencies](int a, int b) {
+        return frequencies[a] != frequencies[b] ? frequencies[a] < frequencies[b] : a < b;
+    });
+
+    // 双队列构造哈夫曼树：叶子已按权重排序，合并出的内部节点权重单调不减
+    const int leaves = static_cast<int>(symbols.size());
+    const int nodes = 2 * leaves - 1;
+    weights.resize(nodes);
+    std::vector<int> parent(nodes, -1);
+    for (int i = 0; i < leaves; ++i) {
+        weights[i] = qMax<quint64>(1, frequencies[symbols[i]]);
+    }
+    int leaf = 0;
+    int inner = leaves;
+    const auto takeSmallest = [&](int next) {
+        if (leaf < leaves && (inner >= next || weights[leaf] <= weights[inner])) {
+            return leaf++;
+        }
+        return inner++;
+    };
+    for (int next = leaves; next < nodes; ++next) {
+        const int first = takeSmallest(next);
+        const int second = takeSmallest(next);
+        weights[next] = weights[first] + weights[second];
+        parent[first] = next;
+        parent[second] = next;
+    }
+
+    // 父节点下标总是大于子节点，倒序即可求深度
+    std::vector<int> depth(nodes, 0);
+    std::vector<int> lengthCount(leaves + 1, 0);
+    int maxLength = 0;
+    for (int node = nodes - 2; node >= 0; --node) {
+        depth[node] = depth[parent[node]] + 1;
+        if (node < leaves) {
+            ++lengthCount[depth[node]];
+            maxLength = qMax(maxLength, depth[node]);
+        }
+    }
+
+    for (int bits = maxLength; bits > maxBits; --bits) {
+        while (lengthCount[bits] > 0) {
+            int shorter = bits - 2;
+            while (lengthCount[shorter] == 0) {
+                --shorter;
+            }
+            lengthCount[bits] -= 2;
+            lengthCount[bits - 1] += 1;
+            lengthCount[shorter + 1] += 2;
+            lengthCount[shorter] -= 1;
+        }
+    }
+
+    // symbols 按频率升序排列，频率最低的符号分配最长的码
+    int index = 0;
+    for (int bits = qMin(maxLength, maxBits); bits >= 1; --bits) {
+        for (int i = 0; i < lengthCount[bits]; ++i) {
+            lengths[symbols[index++]] = static_cast<uchar>(bits);
+        }
+    }
+}
+
+// 低位在前的位输出
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uchar> &out) : m_out(out), m_buffer(0), m_count(0) {}
+
+    void put(quint32 value, int bits)
+    {
+        m_buffer |= static_cast<quint64>(value) << m_count;
+        m_count += bits;
+        while (m_count >= 8) {
+            m_out.push_back(static_cast<uchar>(m_buffer));
+            m_buffer >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    void alignToByte()
+    {
+        if (m_count > 0) {
+            m_out.push_back(static_cast<uchar>(m_buffer));
+            m_buffer = 0;
+            m_count = 0;
+        }
+    }
+
+    // 调用前须已按字节对齐
+    void putBytes(const uchar *data, size_t size)
+    {
+        m_out.insert(m_out.end(), data, data + size);
+    }
+
+private:
+    std::vector<uchar> &m_out;
+    quint64 m_buffer;
+    int m_count;
+};
+
+// LZ77 输出的符号：distance 为 0 时 value 是字面量，否则是匹配长度
+struct Symbol {
+    quint16 value;
+    quint16 distance;
+};
+
+void writeStoredBlocks(BitWriter &writer, const uchar *data, size_t size)
+{
+    do {
+        const size_t length = std::min(size, MAX_STORED_BLOCK);
+        writer.put(0, 3);
+        writer.alignToByte();
+        writer.put(static_cast<quint32>(length), 16);
+        writer.put(static_cast<quint32>(~length & 0xffff), 16);
+        writer.putBytes(data, length);
+        data += length;
+        size -= length;
+    } while (size > 0);
+}
+
+void writeSymbols(BitWriter &writer, const std::vector<Symbol> &symbols,
+                  const quint16 *literalCodes, const uchar *literalLengths,
+                  const quint16 *distanceCodes, const uchar *distanceLengths)
+{
+    const CodeTables &tables = codeTables();
+    for (const Symbol &symbol : symbols) {
+        if (symbol.distance == 0) {
+            writer.put(literalCodes[symbol.value], literalLengths[symbol.value]);
+            continue;
+        }
+        const int lengthCode = tables.lengthCode[symbol.value];
+        writer.put(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+        if (LENGTH_EXTRA[lengthCode]) {
+            writer.put(symbol.value - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+        }
+        const int distanceCode = distanceCodeOf(tables, symbol.distance);
+        writer.put(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+        if (DISTANCE_EXTRA[distanceCode]) {
+            writer.put(symbol.distance - DISTANCE_BASE[distanceCode], DISTANCE_EXTRA[distanceCode]);
+        }
+    }
+    writer.put(literalCodes[END_OF_BLOCK], literalLengths[END_OF_BLOCK]);
+}
+
+// 输出一个非最终块：在动态哈夫曼、固定哈夫曼与存储三种方式中取最短的一种
+void writeBlock(BitWriter &writer, const std::vector<Symbol> &symbols,
+                const uchar *raw, size_t rawSize)
+{
+    const CodeTables &tables = codeTables();
+
+    quint32 literalFrequencies[LITERAL_CODES] = {0};
+    quint32 distanceFrequencies[DISTANCE_CODES] = {0};
+    quint64 extraBits = 0;
+    for (const Symbol &symbol : symbols) {
+        if (symbol.distance == 0) {
+            ++literalFrequencies[symbol.value];
+        } else {
+            const int lengthCode = tables.lengthCode[symbol.value];
+            const int distanceCode = distanceCodeOf(tables, symbol.distance);
+            ++literalFrequencies[257 + lengthCode];
+            ++distanceFrequencies[distanceCode];
+            extraBits += LENGTH_EXTRA[lengthCode] + DISTANCE_EXTRA[distanceCode];
+        }
+    }
+    literalFrequencies[END_OF_BLOCK] = 1;
+
+    uchar literalLengths[LITERAL_CODES];
+    uchar distanceLengths[DISTANCE_CODES];
+    buildCodeLengths(literalFrequencies, LITERAL_CODES, MAX_BITS, literalLengths);
+    buildCodeLengths(distanceFrequencies, DISTANCE_CODES, MAX_BITS, distanceLengths);
+
+    int literalCount = LITERAL_CODES;
+    while (literalCount > 257 && literalLengths[literalCount - 1] == 0) {
+        --literalCount;
+    }
+    int distanceCount = DISTANCE_CODES;
+    while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0) {
+        --distanceCount;
+    }
+
+    // 码长序列的游程编码：16 重复前一个码长 3-6 次，17/18 表示 3-10/11-138 个零
+    std::vector<uchar> allLengths(literalLengths, literalLengths + literalCount);
+    allLengths.insert(allLengths.end(), distanceLengths, distanceLengths + distanceCount);
+    std::vector<std::pair<uchar, uchar> > runs;
+    quint32 codeLengthFrequencies[CODE_LENGTH_CODES] = {0};
+    for (size_t i = 0; i < allLengths.size();) {
+        const uchar length = allLengths[i];
+        size_t run = 1;
+        while (i + run < allLengths.size() && allLengths[i + run] == length) {
+            ++run;
+        }
+        size_t remaining = run;
+        if (length == 0) {
+            while (remaining >= 11) {
+                const size_t count = std::min<size_t>(remaining, 138);
+                runs.push_back(std::make_pair(uchar(18), uchar(count - 11)));
+                remaining -= count;
+            }
+            if (remaining >= 3) {
+                runs.push_back(std::make_pair(uchar(17), uchar(remaining - 3)));
+                remaining = 0;
+            }
+        } else {
+            runs.push_back(std::make_pair(length, uchar(0)));
+            --remaining;
+            while (remaining >= 3) {
+                const size_t count = std::min<size_t>(remaining, 6);
+                runs.push_back(std::make_pair(uchar(16), uchar(count - 3)));
+                remaining -= count;
+            }
+        }
+        while (remaining > 0) {
+            runs.push_back(std::make_pair(length, uchar(0)));
+            --remaining;
+        }
+        i += run;
+    }
+    for (const auto &run : runs) {
+        ++codeLengthFrequencies[run.first];
+    }
+
+    uchar codeLengthLengths[CODE_LENGTH_CODES];
+    buildCodeLengths(codeLengthFrequencies, CODE_LENGTH_CODES, MAX_CODE_LENGTH_BITS, codeLengthLengths);
+    int codeLengthCount = CODE_LENGTH_CODES;
+    while (codeLengthCount > 4 && codeLengthLengths[CODE_LENGTH_ORDER[codeLengthCount - 1]] == 0) {
+        --codeLengthCount;
+    }
+
+    // 三种方式的位数
+    quint64 dynamicBits = 3 + 5 + 5 + 4 + 3 * codeLengthCount + extraBits;
+    for (int i = 0; i < CODE_LENGTH_CODES; ++i) {
+        dynamicBits += static_cast<quint64>(codeLengthFrequencies[i]) * codeLengthLengths[i];
+    }
+    dynamicBits += codeLengthFrequencies[16] * 2 + codeLengthFrequencies[17] * 3 +
+                   codeLengthFrequencies[18] * 7;
+    quint64 fixedBits = 3 + extraBits;
+    for (int i = 0; i < LITERAL_CODES; ++i) {
+        dynamicBits += static_cast<quint64>(literalFrequencies[i]) * literalLengths[i];
+        fixedBits += static_cast<quint64>(literalFrequencies[i]) * tables.fixedLiteralLengths[i];
+    }
+    for (int i = 0; i < DISTANCE_CODES; ++i) {
+        dynamicBits += static_cast<quint64>(distanceFrequencies[i]) * distanceLengths[i];
+        fixedBits += static_cast<quint64>(distanceFrequencies[i]) * tables.fixedDistanceLengths[i];
+    }
+    const quint64 storedBlocks = rawSize / MAX_STORED_BLOCK + 1;
+    const quint64 storedBits = storedBlocks * (3 + 7 + 32) + static_cast<quint64>(rawSize) * 8;
+
+    if (storedBits < dynamicBits && storedBits < fixedBits) {
+        writeStoredBlocks(writer, raw, rawSize);
+        return;
+    }
+
+    if (fixedBits <= dynamicBits) {
+        writer.put(1 << 1, 3);
+        writeSymbols(writer, symbols, tables.fixedLiteralCodes, tables.fixedLiteralLengths,
+                     tables.fixedDistanceCodes, tables.fixedDistanceLengths);
+        return;
+    }
+
+    quint16 literalCodes[LITERAL_CODES];
+    quint16 distanceCodes[DISTANCE_CODES];
+    quint16 codeLengthCodes[CODE_LENGTH_CODES];
+    buildCodes(literalLengths, LITERAL_CODES, literalCodes);
+    buildCodes(distanceLengths, DISTANCE_CODES, distanceCodes);
+    buildCodes(codeLengthLengths, CODE_LENGTH_CODES, codeLengthCodes);
+
+    writer.put(2 << 1, 3);
+    writer.put(literalCount - 257, 5);
+    writer.put(distanceCount - 1, 5);
+    writer.put(codeLengthCount - 4, 4);
+    for (int i = 0; i < codeLengthCount; ++i) {
+        writer.put(codeLengthLengths[CODE_LENGTH_ORDER[i]], 3);
+    }
+    for (const auto &run : runs) {
+        writer.put(codeLengthCodes[run.first], codeLengthLengths[run.first]);
+        if (run.first == 16) {
+            writer.put(run.second, 2);
+        } else if (run.first == 17) {
+            writer.put(run.second, 3);
+        } else if (run.first == 18) {
+            writer.put(run.second, 7);
+        }
+    }
+    writeSymbols(writer, symbols, literalCodes, literalLengths, distanceCodes, distanceLengths);
+}
+
+// 两段数据相同前缀的长度，小端平台上每次比较 8 个字节
+inline int commonLength(const uchar *a, const uchar *b, int maxLength)
+{
+    int length = 0;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    while (length + 8 <= maxLength) {
+        quint64 x;
+        quint64 y;
+        std::memcpy(&x, a + length, 8);
+        std::memcpy(&y, b + length, 8);
+        if (x != y) {
+            return length + static_cast<int>(qCountTrailingZeroBits(x ^ y) >> 3);
+        }
+        length += 8;
+    }
+#endif
+    while (length < maxLength && a[length] == b[length]) {
+        ++length;
+    }
+    return length;
+}
+
+inline quint32 hashAt(const uchar *data)
+{
+    const quint32 value = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+} // namespace
+
+DeflateEncoder::DeflateEncoder(int level)
+    : m_level(qBound(0, level, 9))
+{
+}
+
+void DeflateEncoder::compressSegment(const uchar *data, size_t size, std::vector<uchar> &out) const
+{
+    BitWriter writer(out);
+
+    if (m_level == 0 || size < static_cast<size_t>(MIN_MATCH)) {
+        if (size > 0) {
+            writeStoredBlocks(writer, data, size);
+        }
+    } else {
+        const LevelConfig &config = LEVEL_CONFIGS[m_level];
+        const int length = static_cast<int>(size);
+        std::vector<int> head(HASH_SIZE, -1);
+        std::vector<int> previous(size);
+
+        std::vector<Symbol> symbols;
+        symbols.reserve(MAX_BLOCK_SYMBOLS + 2);
+        int blockStart = 0;
+
+        const auto insert = [&](int position) {
+            const quint32 hash = hashAt(data + position);
+            const int candidate = head[hash];
+            previous[position] = candidate;
+            head[hash] = position;
+            return candidate;
+        };
+
+        // 从候选位置沿哈希链寻找比 minimum 更长的匹配
+        const auto findMatch = [&](int position, int candidate, int minimum,
+                                   int &bestLength, int &bestDistance) {
+            const int maxLength = std::min(MAX_MATCH, length - position);
+            int chain = minimum >= config.goodLength ? config.maxChain >> 2 : config.maxChain;
+            bestLength = minimum;
+            bestDistance = 0;
+            const uchar *current = data + position;
+            while (candidate >= 0 && position - candidate <= WINDOW_SIZE && chain-- > 0) {
+                const uchar *match = data + candidate;
+                if (match[bestLength < maxLength ? bestLength : 0] ==
+                        current[bestLength < maxLength ? bestLength : 0] &&
+                    match[0] == current[0] && match[1] == current[1]) {
+                    const int matched = 2 + commonLength(match + 2, current + 2, maxLength - 2);
+                    if (matched > bestLength &&
+                        (matched > MIN_MATCH || position - candidate <= TOO_FAR)) {
+                        bestLength = matched;
+                        bestDistance = position - candidate;
+                        if (matched >= config.niceLength || matched == maxLength) {
+                            break;
+                        }
+                    }
+                }
+                candidate = previous[candidate];
+            }
+            if (bestDistance == 0) {
+                bestLength = 0;
+            }
+        };
+
+        const auto flushBlock = [&](int end) {
+            writeBlock(writer, symbols, data + blockStart, end - blockStart);
+            symbols.clear();
+            blockStart = end;
+        };
+
+        // 惰性匹配：当前位置的匹配若比前一位置的更长，前一位置只输出字面量
+        int position = 0;
+        int previousLength = 0;
+        int previousDistance = 0;
+        bool pending = false;
+        while (position < length) {
+            if (symbols.size() >= MAX_BLOCK_SYMBOLS) {
+                flushBlock(pending ? position - 1 : position);
+            }
+
+            int matchLength = 0;
+            int matchDistance = 0;
+            if (position + MIN_MATCH <= length) {
+                const int candidate = insert(position);
+                if (candidate >= 0 && previousLength < config.maxLazy) {
+                    findMatch(position, candidate, qMax(previousLength, MIN_MATCH - 1),
+                              matchLength, matchDistance);
+                }
+            }
+
+            if (pending && previousLength >= MIN_MATCH && matchLength <= previousLength) {
+                const Symbol symbol = {static_cast<quint16>(previousLength),
+                                       static_cast<quint16>(previousDistance)};
+                symbols.push_back(symbol);
+                const int end = position - 1 + previousLength;
+                for (int next = position + 1; next < end; ++next) {
+                    if (next + MIN_MATCH <= length) {
+                        insert(next);
+                    }
+                }
+                position = end;
+                pending = false;
+                previousLength = 0;
+                continue;
+            }
+
+            if (pending) {
+                const Symbol symbol = {data[position - 1], 0};
+                symbols.push_back(symbol);
+            }
+            pending = true;
+            previousLength = matchLength;
+            previousDistance = matchDistance;
+            ++position;
+        }
+        if (pending) {
+            const Symbol symbol = {data[length - 1], 0};
+            symbols.push_back(symbol);
+        }
+        if (!symbols.empty() || blockStart < length) {
+            flushBlock(length);
+        }
+    }
+
+    // 空的存储块使输出按字节对齐，以便与下一段直接拼接
+    writer.put(0, 3);
+    writer.alignToByte();
+    writer.put(0, 16);
+    writer.put(0xffff, 16);
+}
+
+void DeflateEncoder::appendFinalBlock(std::vector<uchar> &out)
+{
+    // BFINAL = 1、固定哈夫曼、只有块结束码
+    out.push_back(0x03);
+    out.push_back(0x00);
+}
+
+quint16 DeflateEncoder::zlibHeader(int level)
+{
+    const int cmf = 0x78;   // deflate，32K 窗口
+    const int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    int flg = flevel << 6;
+    flg += 31 - ((cmf << 8) + flg) % 31;
+    return static_cast<quint16>((cmf << 8) | flg);
+}
+
+quint32 DeflateEncoder::adler32(const uchar *data, size_t size, quint32 adler)
+{
+    const quint32 base = 65521;
+    // 5552 为累加不溢出 32 位的最大长度
+    const size_t chunk = 5552;
+    quint32 a = adler & 0xffff;
+    quint32 b = adler >> 16;
+    while (size > 0) {
+        const size_t count = std::min(size, chunk);
+        for (size_t i = 0; i < count; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= base;
+        b %= base;
+        data += count;
+        size -= count;
+    }
+    return (b << 16) | a;
+}
+
+quint32 DeflateEncoder::adler32Combine(quint32 first, quint32 second, quint64 secondLength)
+{
+    const quint32 base = 65521;
+    const quint32 remainder = static_cast<quint32>(secondLength % base);
+    quint32 sum1 = first & 0xffff;
+    quint32 sum2 = static_cast<quint32>((static_cast<quint64>(remainder) * sum1) % base);
+    sum1 += (second & 0xffff) + base - 1;
+    sum2 += ((first >> 16) & 0xffff) + ((second >> 16) & 0xffff) + base - remainder;
+    if (sum1 >= base) {
+        sum1 -= base;
+    }
+    if (sum1 >= base) {
+        sum1 -= base;
+    }
+    if (sum2 >= (base << 1)) {
+        sum2 -= (base << 1);
+    }
+    if (sum2 >= base) {
+        sum2 -= base;
+    }
+    return sum1 | (sum2 << 16);
+}
@@ -0,0 +1,37 @@
+#ifndef DEFLATEENCODER_H
+#define DEFLATEENCODER_H
+
+#include <QtGlobal>
+#include <vector>
+
+// Deflate 压缩（RFC 1951）
+// 带惰性匹配的 LZ77 加动态哈夫曼编码。数据按段独立压缩：每段输出若干非最终块，
+// 并以空的存储块结束、按字节对齐，因此各段可在不同线程中压缩后直接首尾拼接，
+// 最后追加 appendFinalBlock() 即得到完整的 deflate 流（与 pigz 的做法相同）
+class DeflateEncoder
+{
+public:
+    static constexpr int DEFAULT_LEVEL = 6;
+
+    // level 为 0-9：0 只输出存储块，级别越高匹配搜索越充分
+    explicit DeflateEncoder(int level = DEFAULT_LEVEL);
+
+    int level() const { return m_level; }
+
+    // 压缩一段数据并追加到 out
+    void compressSegment(const uchar *data, size_t size, std::vector<uchar> &out) const;
+
+    // 拼接流的结尾：一个空的最终块
+    static void appendFinalBlock(std::vector<uchar> &out);
+
+    // zlib 封装（RFC 1950）使用的流头与校验和
+    static quint16 zlibHeader(int level);
+    static quint32 adler32(const uchar *data, size_t size, quint32 adler = 1);
+    // 由两段数据各自的校验和得到拼接后的校验和
+    static quint32 adler32Combine(quint32 first, quint32 second, quint64 secondLength);
+
+private:
+    int m_level;
+};
+
+#endif // DEFLATEENCODER_H
@@ -0,0 +1,90 @@
+#include "distancetransform.h"
+#include <limits>
+
+constexpr qint32 DistanceTransform::NO_FEATURE;
+
+void DistanceTransform::compute(const std::vector<uchar> &mask, int width, int height,
+                                std::vector<qint32> &squaredDistance,
+                                std::vector<qint32> &nearest)
+{
+    const size_t count = static_cast<size_t>(width) * height;
+    squaredDistance.assign(count, std::numeric_limits<qint32>::max());
+    nearest.assign(count, NO_FEATURE);
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    // 第一遍：逐列的最近特征行，按行顺序扫描以保持内存连续访问
+    std::vector<qint32> columnFeature(count, NO_FEATURE);
+    std::vector<qint32> last(width, NO_FEATURE);
+    for (int y = 0; y < height; ++y) {
+        const uchar *maskRow = mask.data() + static_cast<size_t>(y) * width;
+        qint32 *featureRow = columnFeature.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            if (maskRow[x]) {
+                last[x] = y;
+            }
+            featureRow[x] = last[x];
+        }
+    }
+    last.assign(width, NO_FEATURE);
+    for (int y = height - 1; y >= 0; --y) {
+        const uchar *maskRow = mask.data() + static_cast<size_t>(y) * width;
+        qint32 *featureRow = columnFeature.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            if (maskRow[x]) {
+                last[x] = y;
+            }
+            if (last[x] != NO_FEATURE &&
+                (featureRow[x] == NO_FEATURE || last[x] - y < y - featureRow[x])) {
+                featureRow[x] = last[x];
+            }
+        }
+    }
+
+    // 第二遍：逐行求抛物线 (q - x)² + g(x) 的下包络
+    std::vector<qint32> g(width);
+    std::vector<int> vertices(width);
+    std::vector<double> boundaries(width + 1);
+    for (int y = 0; y < height; ++y) {
+        const qint32 *featureRow = columnFeature.data() + static_cast<size_t>(y) * width;
+        int k = -1;
+        for (int x = 0; x < width; ++x) {
+            if (featureRow[x] == NO_FEATURE) {
+                continue;
+            }
+            const qint32 dy = featureRow[x] - y;
+            g[x] = dy * dy;
+
+            double s = 0.0;
+            while (k >= 0) {
+                const int v = vertices[k];
+                s = (static_cast<double>(g[x]) + static_cast<double>(x) * x -
+                     static_cast<double>(g[v]) - static_cast<double>(v) * v) / (2.0 * (x - v));
+                if (s > boundaries[k]) {
+                    break;
+                }
+                --k;
+            }
+            ++k;
+            vertices[k] = x;
+            boundaries[k] = k == 0 ? -std::numeric_limits<double>::infinity() : s;
+            boundaries[k + 1] = std::numeric_limits<double>::infinity();
+        }
+        if (k < 0) {
+            continue;
+        }
+
+        qint32 *distanceRow = squaredDistance.data() + static_cast<size_t>(y) * width;
+        qint32 *nearestRow = nearest.data() + static_cast<size_t>(y) * width;
+        int j = 0;
+        for (int q = 0; q < width; ++q) {
+            while (boundaries[j + 1] < q) {
+                ++j;
+            }
+            const int v = vertices[j];
+            distanceRow[q] = (q - v) * (q - v) + g[v];
+            nearestRow[q] = featureRow[v] * width + v;
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef DISTANCETRANSFORM_H
+#define DISTANCETRANSFORM_H
+
+#include <QtGlobal>
+#include <vector>
+
+// 欧氏距离变换（Felzenszwalb–Huttenlocher 线性时间算法）
+// 先逐列求到最近特征像素的一维距离，再逐行求抛物线下包络，
+// 同时记录每个像素最近的特征像素，用于取其颜色与方向。
+class DistanceTransform
+{
+public:
+    static constexpr qint32 NO_FEATURE = -1;
+
+    // mask 为 width × height 的行优先数组，非零表示特征像素。
+    // squaredDistance 输出到最近特征像素的距离平方，
+    // nearest 输出最近特征像素的下标（y * width + x），无特征时为 NO_FEATURE
+    static void compute(const std::vector<uchar> &mask, int width, int height,
+                        std::vector<qint32> &squaredDistance,
+                        std::vector<qint32> &nearest);
+};
+
+#endif // DISTANCETRANSFORM_H
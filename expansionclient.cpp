@@ -0,0 +1,185 @@
+#include "expansionclient.h"
+#include "expansionserver.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// 结果图像的最后一个副本释放时解除输出段的映射
+void releaseSegment(void *info)
+{
+    delete static_cast<QSharedMemory*>(info);
+}
+
+} // namespace
+
+ExpansionClient::ExpansionClient()
+    : m_inputCounter(0)
+    , m_requestId(0)
+{
+}
+
+bool ExpansionClient::connectToServer(const QString &name, int timeoutMs)
+{
+    m_socket.connectToServer(name);
+    if (!m_socket.waitForConnected(timeoutMs)) {
+        m_errorString = "无法连接服务: " + m_socket.errorString();
+        return false;
+    }
+    return true;
+}
+
+QImage ExpansionClient::expand(const QImage &image, const BatchProcessor::Options &recipe,
+                               Timing *timing, int timeoutMs)
+{
+    // 服务端只接受 32 位非预乘格式
+    const QImage source = image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_RGB32
+                          ? image
+                          : image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32
+                                                                          : QImage::Format_RGB32);
+    if (source.isNull() || !writeInput(source)) {
+        if (source.isNull()) {
+            m_errorString = "没有可扩展的图像";
+        }
+        return QImage();
+    }
+
+    QJsonObject request = ExpansionServer::recipeToJson(recipe);
+    request.insert("id", ++m_requestId);
+    request.insert("key", m_input->key());
+    request.insert("width", source.width());
+    request.insert("height", source.height());
+    request.insert("stride", static_cast<qint64>(source.bytesPerLine()));
+    request.insert("format", source.format() == QImage::Format_RGB32 ? "rgb32" : "argb32");
+    if (!sendMessage(request)) {
+        return QImage();
+    }
+
+    QJsonObject reply;
+    if (!readReply(m_requestId, &reply, timeoutMs)) {
+        // 服务端可能仍在读取源图段，下次请求改用新的段，不覆盖正在读取的数据
+        m_input.reset();
+        return QImage();
+    }
+    if (!reply.value("ok").toBool()) {
+        m_errorString = reply.value("error").toString();
+        return QImage();
+    }
+
+    // 映射输出段后通知服务端释放；段在本进程解除映射前一直有效
+    const QString key = reply.value("key").toString();
+    QSharedMemory *output = new QSharedMemory(key);
+    const bool attached = output->attach(QSharedMemory::ReadOnly);
+    releaseOutput(key);
+    if (!attached) {
+        m_errorString = "无法映射结果共享内存: " + output->errorString();
+        delete output;
+        return QImage();
+    }
+
+    const int width = reply.value("width").toInt();
+    const int height = reply.value("height").toInt();
+    const qint64 stride = reply.value("stride").toVariant().toLongLong();
+    const QImage::Format format = reply.value("format").toString() == "rgb32" ? QImage::Format_RGB32
+                                                                            : QImage::Format_ARGB32;
+    if (width <= 0 || height <= 0 || static_cast<qint64>(output->size()) < stride * height) {
+        m_errorString = "结果共享内存与应答不符";
+        delete output;
+        return QImage();
+    }
+    if (timing) {
+        timing->queueUs = reply.value("queueUs").toVariant().toLongLong();
+        timing->renderUs = reply.value("renderUs").toVariant().toLongLong();
+    }
+    return QImage(static_cast<const uchar*>(output->constData()), width, height,
+                  static_cast<qsizetype>(stride), format, releaseSegment, output);
+}
+
+bool ExpansionClient::requestStats(QJsonObject *stats, int timeoutMs)
+{
+    QJsonObject request;
+    request.insert("id", ++m_requestId);
+    request.insert("stats", true);
+    return sendMessage(request) && readReply(m_requestId, stats, timeoutMs);
+}
+
+void ExpansionClient::releaseOutput(const QString &key)
+{
+    QJsonObject release;
+    release.insert("release", key);
+    sendMessage(release);
+}
+
+bool ExpansionClient::writeInput(const QImage &image)
+{
+    // 段足够大时复用，重复请求不再创建共享内存
+    const qint64 bytes = static_cast<qint64>(image.bytesPerLine()) * image.height();
+    if (!m_input || m_input->size() < bytes) {
+        m_input.reset(new QSharedMemory(QString("ImageBackgroundExpander-client-%1-%2")
+                                        .arg(QCoreApplication::applicationPid())
+                                        .arg(++m_inputCounter)));
+        if (bytes > std::numeric_limits<int>::max() || !m_input->create(static_cast<int>(bytes))) {
+            m_errorString = "无法创建源图共享内存: " + m_input->errorString();
+            m_input.reset();
+            return false;
+        }
+    }
+    std::memcpy(m_input->data(), image.constBits(), static_cast<size_t>(bytes));
+    return true;
+}
+
+bool ExpansionClient::sendMessage(const QJsonObject &message)
+{
+    if (m_socket.write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n') < 0) {
+        m_errorString = "发送请求失败: " + m_socket.errorString();
+        return false;
+    }
+    while (m_socket.bytesToWrite() > 0) {
+        if (!m_socket.waitForBytesWritten(DEFAULT_TIMEOUT)) {
+            m_errorString = "发送请求失败: " + m_socket.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ExpansionClient::readReply(int id, QJsonObject *reply, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (;;) {
+        QJsonObject message;
+        const int remaining = static_cast<int>(qMax<qint64>(0, timeoutMs - timer.elapsed()));
+        if (!readMessage(&message, remaining)) {
+            return false;
+        }
+        if (message.value("id").toInt() == id) {
+            *reply = message;
+            return true;
+        }
+        // 此前超时的请求迟到的应答：释放其输出段后丢弃
+        if (message.value("ok").toBool() && message.contains("key")) {
+            releaseOutput(message.value("key").toString());
+        }
+    }
+}
+
+bool ExpansionClient::readMessage(QJsonObject *message, int timeoutMs)
+{
+    while (!m_socket.canReadLine()) {
+        if (!m_socket.waitForReadyRead(timeoutMs)) {
+            m_errorString = "等待应答超时: " + m_socket.errorString();
+            return false;
+        }
+    }
+    const QJsonDocument document = QJsonDocument::fromJson(m_socket.readLine());
+    if (!document.isObject()) {
+        m_errorString = "无效的应答";
+        return false;
+    }
+    *message = document.object();
+    return true;
+}
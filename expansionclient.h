@@ -0,0 +1,53 @@
+#ifndef EXPANSIONCLIENT_H
+#define EXPANSIONCLIENT_H
+
+#include <QImage>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QString>
+#include <memory>
+#include "batchprocessor.h"
+
+// 本机扩展服务的同步客户端（协议见 ExpansionServer）
+// 源图写入客户端持有的共享内存段，尺寸不变时在多次请求间复用；
+// 返回的结果图像直接映射服务端的输出段，最后一个副本释放时解除映射
+class ExpansionClient
+{
+public:
+    ExpansionClient();
+
+    bool connectToServer(const QString &name, int timeoutMs = DEFAULT_TIMEOUT);
+    QString errorString() const { return m_errorString; }
+
+    // 服务端在本次请求中的排队与渲染耗时（微秒）
+    struct Timing {
+        qint64 queueUs;
+        qint64 renderUs;
+    };
+
+    // 失败时返回空图像，原因见 errorString()
+    QImage expand(const QImage &image, const BatchProcessor::Options &recipe,
+                  Timing *timing = nullptr, int timeoutMs = DEFAULT_TIMEOUT);
+
+    // 服务端的延迟统计
+    bool requestStats(QJsonObject *stats, int timeoutMs = DEFAULT_TIMEOUT);
+
+private:
+    bool writeInput(const QImage &image);
+    void releaseOutput(const QString &key);
+    bool sendMessage(const QJsonObject &message);
+    // 读取编号为 id 的应答，丢弃之前超时请求迟到的应答
+    bool readReply(int id, QJsonObject *reply, int timeoutMs);
+    bool readMessage(QJsonObject *message, int timeoutMs);
+
+    QLocalSocket m_socket;
+    std::unique_ptr<QSharedMemory> m_input;
+    int m_inputCounter;
+    int m_requestId;
+    QString m_errorString;
+
+    static constexpr int DEFAULT_TIMEOUT = 30000;  // 毫秒
+};
+
+#endif // EXPANSIONCLIENT_H
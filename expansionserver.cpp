@@ -0,0 +1,347 @@
+#include "expansionserver.h"
+#include "imageprocessor.h"
+#include "orientedimage.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QThread>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// 共享内存中的行跨度按 16 字节对齐，段的起始地址按页对齐，每行都满足向量化读写的对齐要求
+qsizetype alignedStride(int width)
+{
+    return (static_cast<qsizetype>(width) * 4 + 15) & ~static_cast<qsizetype>(15);
+}
+
+bool formatFromName(const QString &name, QImage::Format *format)
+{
+    if (name == "argb32") {
+        *format = QImage::Format_ARGB32;
+    } else if (name == "rgb32") {
+        *format = QImage::Format_RGB32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString formatName(QImage::Format format)
+{
+    return format == QImage::Format_RGB32 ? "rgb32" : "argb32";
+}
+
+} // namespace
+
+ExpansionServer::ExpansionServer(const ImageProcessor *processor, QObject *parent)
+    : QObject(parent)
+    , m_processor(processor)
+    , m_server(new QLocalServer(this))
+    , m_segmentCounter(0)
+    , m_latencyCursor(0)
+{
+    // 线程常驻，请求到达时不再创建线程
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+    m_pool.setExpiryTimeout(-1);
+    m_latencies.reserve(LATENCY_SAMPLES);
+    connect(m_server, &QLocalServer::newConnection, this, &ExpansionServer::onNewConnection);
+}
+
+ExpansionServer::~ExpansionServer()
+{
+    // 任务会向本对象投递结果，必须在析构前结束
+    m_pool.waitForDone();
+}
+
+bool ExpansionServer::listen(const QString &name, QString *errorString)
+{
+    // 上次异常退出可能留下同名的套接字文件
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        if (errorString) {
+            *errorString = m_server->errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+void ExpansionServer::setWorkerCount(int count)
+{
+    m_pool.setMaxThreadCount(qMax(1, count));
+}
+
+QJsonObject ExpansionServer::recipeToJson(const BatchProcessor::Options &recipe)
+{
+    QJsonObject json;
+    json.insert("top", recipe.top);
+    json.insert("bottom", recipe.bottom);
+    json.insert("left", recipe.left);
+    json.insert("right", recipe.right);
+    json.insert("ratio", recipe.ratio);
+    json.insert("distribution", recipe.distribution);
+    json.insert("color", recipe.backgroundColor.name(QColor::HexArgb));
+    return json;
+}
+
+BatchProcessor::Options ExpansionServer::recipeFromJson(const QJsonObject &json)
+{
+    BatchProcessor::Options recipe = BatchProcessor::defaultOptions();
+    recipe.top = qMax(0, json.value("top").toInt());
+    recipe.bottom = qMax(0, json.value("bottom").toInt());
+    recipe.left = qMax(0, json.value("left").toInt());
+    recipe.right = qMax(0, json.value("right").toInt());
+    recipe.ratio = json.value("ratio").toString();
+    recipe.distribution = json.value("distribution").toString(recipe.distribution);
+    if (json.contains("color")) {
+        recipe.backgroundColor = QColor(json.value("color").toString());
+    }
+    return recipe;
+}
+
+void ExpansionServer::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, &ExpansionServer::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, this, &ExpansionServer::onDisconnected);
+    }
+}
+
+void ExpansionServer::onReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) {
+        return;
+    }
+    while (socket->canReadLine()) {
+        const QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        if (!document.isObject()) {
+            QJsonObject reply;
+            reply.insert("ok", false);
+            reply.insert("error", "无效的请求: " + parseError.errorString());
+            sendMessage(socket, reply);
+            continue;
+        }
+        handleMessage(socket, document.object());
+    }
+}
+
+void ExpansionServer::onDisconnected()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) {
+        return;
+    }
+    // 客户端未释放的输出段随连接一起释放
+    m_outputs.remove(socket);
+    socket->deleteLater();
+}
+
+void ExpansionServer::handleMessage(QLocalSocket *socket, const QJsonObject &message)
+{
+    if (message.contains("release")) {
+        m_outputs[socket].remove(message.value("release").toString());
+        return;
+    }
+    if (message.value("stats").toBool()) {
+        const LatencyStats stats = latencyStats();
+        QJsonObject reply;
+        reply.insert("id", message.value("id"));
+        reply.insert("count", stats.count);
+        reply.insert("meanUs", stats.meanUs);
+        reply.insert("p50Us", stats.p50Us);
+        reply.insert("p95Us", stats.p95Us);
+        reply.insert("p99Us", stats.p99Us);
+        reply.insert("maxUs", stats.maxUs);
+        sendMessage(socket, reply);
+        return;
+    }
+    startExpansion(socket, message);
+}
+
+void ExpansionServer::startExpansion(QLocalSocket *socket, const QJsonObject &request)
+{
+    QElapsedTimer received;
+    received.start();
+    const QString outputKey = nextSegmentKey();
+    const QPointer<QLocalSocket> guard(socket);
+
+    m_pool.start([this, request, outputKey, received, guard]() {
+        const qint64 queueUs = received.nsecsElapsed() / 1000;
+        const Output output = expand(request, outputKey);
+
+        QMetaObject::invokeMethod(this, [this, request, outputKey, output, queueUs, received, guard]() {
+            const bool success = output.errorMessage.isEmpty();
+            // 连接已断开（onDisconnected 已清理登记）时不再登记，输出段随本闭包释放
+            if (guard && guard->state() == QLocalSocket::ConnectedState) {
+                QJsonObject reply;
+                reply.insert("id", request.value("id"));
+                reply.insert("ok", success);
+                if (success) {
+                    // 先登记再应答，客户端映射前输出段一直存在
+                    m_outputs[guard.data()].insert(outputKey, output.memory);
+                    reply.insert("key", outputKey);
+                    reply.insert("width", output.size.width());
+                    reply.insert("height", output.size.height());
+                    reply.insert("stride", static_cast<qint64>(output.stride));
+                    reply.insert("format", formatName(output.format));
+                    reply.insert("queueUs", queueUs);
+                    reply.insert("renderUs", output.renderUs);
+                } else {
+                    reply.insert("error", output.errorMessage);
+                }
+                sendMessage(guard.data(), reply);
+            }
+            const qint64 latencyUs = received.nsecsElapsed() / 1000;
+            recordLatency(latencyUs);
+            emit requestFinished(latencyUs, success);
+        }, Qt::QueuedConnection);
+    });
+}
+
+ExpansionServer::Output ExpansionServer::expand(const QJsonObject &request, const QString &outputKey) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Output output;
+    output.stride = 0;
+    output.format = QImage::Format_ARGB32;
+    output.renderUs = 0;
+    const auto fail = [&output](const QString &message) {
+        output.errorMessage = message;
+        output.memory.reset();
+        return output;
+    };
+
+    // 一、映射客户端的源图段，直接包装为只读图像
+    const int width = request.value("width").toInt();
+    const int height = request.value("height").toInt();
+    const qint64 stride = request.value("stride").toVariant().toLongLong();
+    QImage::Format sourceFormat;
+    if (!formatFromName(request.value("format").toString(), &sourceFormat)) {
+        return fail("不支持的像素格式: " + request.value("format").toString());
+    }
+    if (width <= 0 || height <= 0 || stride < static_cast<qint64>(width) * 4 || stride % 4 != 0) {
+        return fail("无效的源图尺寸");
+    }
+    QSharedMemory input(request.value("key").toString());
+    if (!input.attach(QSharedMemory::ReadOnly)) {
+        return fail("无法映射源图共享内存: " + input.errorString());
+    }
+    if (static_cast<qint64>(input.size()) < stride * height) {
+        return fail("源图共享内存小于图像数据");
+    }
+    const QImage source(static_cast<const uchar*>(input.constData()), width, height,
+                        static_cast<qsizetype>(stride), sourceFormat);
+
+    // 二、确定扩展量
+    const BatchProcessor::Options recipe = recipeFromJson(request);
+    if (!recipe.backgroundColor.isValid()) {
+        return fail("无效的颜色");
+    }
+    int top = recipe.top;
+    int bottom = recipe.bottom;
+    int left = recipe.left;
+    int right = recipe.right;
+    if (!recipe.ratio.isEmpty()) {
+        const ImageProcessor::ExpansionValues expansion =
+            m_processor->calculateSmartExpansion(source.size(), recipe.ratio, recipe.distribution);
+        if (!expansion.isValid && !expansion.alreadySatisfied) {
+            return fail(expansion.errorMessage);
+        }
+        top = expansion.top;
+        bottom = expansion.bottom;
+        left = expansion.left;
+        right = expansion.right;
+    }
+
+    // 三、在输出段中分配画布
+    output.size = QSize(width + left + right, height + top + bottom);
+    output.stride = alignedStride(output.size.width());
+    output.format = sourceFormat == QImage::Format_RGB32 && recipe.backgroundColor.alpha() == 255
+                    ? QImage::Format_RGB32 : QImage::Format_ARGB32;
+    const qint64 bytes = static_cast<qint64>(output.stride) * output.size.height();
+    if (bytes > std::numeric_limits<int>::max()) {
+        return fail(QString("画布 %1x%2 超过共享内存段的上限")
+                    .arg(output.size.width()).arg(output.size.height()));
+    }
+    output.memory = std::make_shared<QSharedMemory>(outputKey);
+    if (!output.memory->create(static_cast<int>(bytes))) {
+        return fail("无法创建输出共享内存: " + output.memory->errorString());
+    }
+    QImage canvas(static_cast<uchar*>(output.memory->data()), output.size.width(),
+                  output.size.height(), output.stride, output.format);
+
+    // 四、源图写入画布后就地生成边距
+    const QRect sourceRect(left, top, width, height);
+    OrientedImage(source).copyTo(canvas, sourceRect.topLeft());
+    input.detach();
+    if (!m_processor->renderInPlace(canvas, sourceRect, recipe.backgroundColor)) {
+        return fail("渲染失败");
+    }
+
+    output.renderUs = timer.nsecsElapsed() / 1000;
+    return output;
+}
+
+void ExpansionServer::sendMessage(QLocalSocket *socket, const QJsonObject &message)
+{
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+    socket->flush();
+}
+
+void ExpansionServer::recordLatency(qint64 latencyUs)
+{
+    if (m_latencies.size() < LATENCY_SAMPLES) {
+        m_latencies.append(latencyUs);
+    } else {
+        m_latencies[m_latencyCursor] = latencyUs;
+        m_latencyCursor = (m_latencyCursor + 1) % LATENCY_SAMPLES;
+    }
+}
+
+ExpansionServer::LatencyStats ExpansionServer::latencyStats() const
+{
+    LatencyStats stats;
+    stats.count = m_latencies.size();
+    stats.meanUs = 0;
+    stats.p50Us = 0;
+    stats.p95Us = 0;
+    stats.p99Us = 0;
+    stats.maxUs = 0;
+    if (m_latencies.isEmpty()) {
+        return stats;
+    }
+
+    QVector<qint64> sorted = m_latencies;
+    std::sort(sorted.begin(), sorted.end());
+    qint64 total = 0;
+    for (qint64 latency : sorted) {
+        total += latency;
+    }
+    const auto percentile = [&sorted](int percent) {
+        return sorted[qMin(sorted.size() - 1, sorted.size() * percent / 100)];
+    };
+    stats.meanUs = total / sorted.size();
+    stats.p50Us = percentile(50);
+    stats.p95Us = percentile(95);
+    stats.p99Us = percentile(99);
+    stats.maxUs = sorted.last();
+    return stats;
+}
+
+QString ExpansionServer::nextSegmentKey()
+{
+    return QString("ImageBackgroundExpander-%1-%2")
+        .arg(QCoreApplication::applicationPid())
+        .arg(++m_segmentCounter);
+}
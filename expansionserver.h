@@ -0,0 +1,103 @@
+#ifndef EXPANSIONSERVER_H
+#define EXPANSIONSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+#include "batchprocessor.h"
+
+class ImageProcessor;
+
+// 本机扩展服务
+// 在 QLocalServer 上接受其他进程的扩展请求，像素不经过套接字：
+// 客户端把源图放入自己创建的共享内存段，服务端映射该段直接读取，
+// 在服务端创建的输出段中就地合成画布，客户端映射输出段即得到结果，两端都不复制像素。
+// 线程池的线程常驻不过期，处理器的权重表等在进程内只初始化一次。
+//
+// 协议：每条消息为一行紧凑 JSON。
+//   扩展请求  {"id", "key", "width", "height", "stride", "format", 扩展配方}
+//            format 为 "argb32" 或 "rgb32"；配方字段见 recipeToJson
+//   扩展应答  {"id", "ok", "key", "width", "height", "stride", "format", "queueUs", "renderUs"}
+//            或 {"id", "ok": false, "error"}
+//   释放输出  {"release": key}，客户端映射输出段后发送；断开连接时释放其全部输出段
+//   延迟统计  {"id", "stats": true} → {"id", "count", "meanUs", "p50Us", "p95Us", "p99Us", "maxUs"}
+// 应答带回请求的 id，客户端据此丢弃超时请求迟到的应答
+class ExpansionServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ExpansionServer(const ImageProcessor *processor, QObject *parent = nullptr);
+    // 等待处理中的请求结束
+    ~ExpansionServer() override;
+
+    bool listen(const QString &name, QString *errorString = nullptr);
+    QString serverName() const { return m_server->serverName(); }
+
+    void setWorkerCount(int count);
+    int workerCount() const { return m_pool.maxThreadCount(); }
+
+    // 请求延迟（自读到请求至写出应答，微秒）的统计，基于最近的 LATENCY_SAMPLES 个请求
+    struct LatencyStats {
+        int count;
+        qint64 meanUs;
+        qint64 p50Us;
+        qint64 p95Us;
+        qint64 p99Us;
+        qint64 maxUs;
+    };
+    LatencyStats latencyStats() const;
+
+    // 扩展配方与 JSON 的转换（客户端与服务端共用）
+    static QJsonObject recipeToJson(const BatchProcessor::Options &recipe);
+    static BatchProcessor::Options recipeFromJson(const QJsonObject &json);
+
+signals:
+    void requestFinished(qint64 latencyUs, bool success);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    // 一次扩展的结果，输出段由服务端持有直到客户端释放
+    struct Output {
+        std::shared_ptr<QSharedMemory> memory;
+        QSize size;
+        qsizetype stride;
+        QImage::Format format;
+        QString errorMessage;
+        qint64 renderUs;
+    };
+
+    void handleMessage(QLocalSocket *socket, const QJsonObject &message);
+    void startExpansion(QLocalSocket *socket, const QJsonObject &request);
+    Output expand(const QJsonObject &request, const QString &outputKey) const;
+    void sendMessage(QLocalSocket *socket, const QJsonObject &message);
+    void recordLatency(qint64 latencyUs);
+    QString nextSegmentKey();
+
+    const ImageProcessor *m_processor;
+    QLocalServer *m_server;
+    QThreadPool m_pool;
+
+    // 每个连接持有的输出段
+    QHash<QLocalSocket*, QHash<QString, std::shared_ptr<QSharedMemory> > > m_outputs;
+    quint64 m_segmentCounter;
+
+    QVector<qint64> m_latencies;    // 最近请求的延迟，环形缓冲
+    int m_latencyCursor;
+
+    static constexpr int LATENCY_SAMPLES = 4096;
+};
+
+#endif // EXPANSIONSERVER_H
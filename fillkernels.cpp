@@ -0,0 +1,514 @@
+#include "fillkernels.h"
+#include "parallelfor.h"
+#include <QThread>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FILLKERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+inline QRgb *canvasLine(QImage &canvas, int y)
+{
+    return reinterpret_cast<QRgb*>(canvas.scanLine(y));
+}
+
+// 上下边距的每一行都是同一行的拷贝，整行 memcpy 即可
+void replicateRow(QImage &canvas, int sourceRow, int firstRow, int rowCount)
+{
+    const size_t rowBytes = static_cast<size_t>(canvas.width()) * sizeof(QRgb);
+    const uchar *source = canvas.constScanLine(sourceRow);
+    
+    for (int y = firstRow; y < firstRow + rowCount; ++y) {
+        std::memcpy(canvas.scanLine(y), source, rowBytes);
+    }
+}
+
+// 将相对源图起点的坐标 p（可为负或越界）映射为源图索引，
+// step 返回该片段的走向：+1 正向，-1 反向
+inline int mapPadIndex(int p, int n, FillKernels::PadMode mode, int *step)
+{
+    *step = 1;
+    if (n <= 1) {
+        return 0;
+    }
+    
+    int period = n;
+    if (mode == FillKernels::PadReflect) {
+        period = 2 * n;
+    } else if (mode == FillKernels::PadReflect101) {
+        period = 2 * n - 2;
+    }
+    
+    int m = p % period;
+    if (m < 0) {
+        m += period;
+    }
+    
+    if (m < n) {
+        return m;
+    }
+    
+    *step = -1;
+    return mode == FillKernels::PadReflect ? period - 1 - m : period - m;
+}
+
+// dst[k] = last[-k]，k ∈ [0, count)
+void copyReversed(QRgb *dst, const QRgb *last, int count)
+{
+    int k = 0;
+    
+#ifdef FILLKERNELS_SSE2
+    for (; k + 4 <= count; k += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last - k - 3));
+        pixels = _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + k), pixels);
+    }
+#endif
+    
+    for (; k < count; ++k) {
+        dst[k] = last[-k];
+    }
+}
+
+// 以周期方式填充 count 个像素，起始坐标为 p（相对源行起点）
+void padSpan(QRgb *dst, const QRgb *source, int n, int p, int count,
+             FillKernels::PadMode mode)
+{
+    if (n == 1) {
+        FillKernels::fillSpan(dst, source[0], count);
+        return;
+    }
+    
+    while (count > 0) {
+        int step;
+        const int index = mapPadIndex(p, n, mode, &step);
+        int length;
+        
+        if (step > 0) {
+            length = qMin(count, n - index);
+            std::memcpy(dst, source + index, static_cast<size_t>(length) * sizeof(QRgb));
+        } else {
+            // reflect-101 的反向片段不包含索引 0（边缘像素不重复）
+            const int available = mode == FillKernels::PadReflect ? index + 1 : index;
+            length = qMin(count, available);
+            copyReversed(dst, source + index, length);
+        }
+        
+        dst += length;
+        p += length;
+        count -= length;
+    }
+}
+
+// 边带描述：d 为向外的距离（0 为紧邻源图的一行/列），t 为沿边缘的位置
+struct EdgeBand {
+    QRgb *origin;           // (d = 0, t = 0) 处的像素
+    ptrdiff_t outward;      // d 增加一步的指针偏移
+    ptrdiff_t along;        // t 增加一步的指针偏移
+    int depth;              // 边距宽度
+    int length;             // 沿边缘的长度
+    int sourceDepth;        // 源图在向内方向上的尺寸（镜像周期）
+};
+
+// 模糊半径随距离线性增长：r(d) = d / BLUR_GROWTH_DIVISOR
+// 增长率小于 1 时滑动窗口 [d - r, d + r] 的两端都单调不减
+constexpr int BLUR_GROWTH_DIVISOR = 2;
+
+// 每条边带沿边缘切成若干段并行模糊，单段的最小长度
+constexpr int BLUR_MIN_CHUNK = 64;
+
+// 深度 d 处的窗口最远读到镜像行 d + r(d)，该行的沿边缘模糊半径即整条边带的最大半径
+inline int maxBlurRadius(int depth)
+{
+    const int lastRow = (depth - 1) + (depth - 1) / BLUR_GROWTH_DIVISOR;
+    return lastRow / BLUR_GROWTH_DIVISOR;
+}
+
+// 只写出 [begin, end) 段；前缀和向两侧多取最大半径，结果与整条边带一次处理相同
+class BandBlur
+{
+public:
+    BandBlur(const EdgeBand &band, int begin, int end)
+        : m_band(band)
+        , m_begin(begin)
+        , m_end(end)
+        , m_prefixBegin(qMax(0, begin - maxBlurRadius(band.depth)))
+        , m_prefixEnd(qMin(band.length, end + maxBlurRadius(band.depth)))
+        , m_prefix(static_cast<size_t>(m_prefixEnd - m_prefixBegin + 1) * 4, 0)
+        , m_columnSums(static_cast<size_t>(end - begin) * 4, 0)
+    {
+    }
+    
+    void run()
+    {
+        int addedUntil = -1;    // 已累加的最大行号
+        int removedUntil = 0;   // 窗口当前的最小行号
+        
+        for (int d = 0; d < m_band.depth; ++d) {
+            const int radius = d / BLUR_GROWTH_DIVISOR;
+            const int low = d - radius;
+            const int high = d + radius;
+            
+            while (addedUntil < high) {
+                accumulateRow(++addedUntil, 1);
+            }
+            while (removedUntil < low) {
+                accumulateRow(removedUntil++, -1);
+            }
+            
+            writeRow(d, high - low + 1);
+        }
+    }
+    
+private:
+    // 对镜像行 j 做沿边缘方向的盒式模糊（前缀和，半径 r(j)），并累加到列和
+    void accumulateRow(int j, int sign)
+    {
+        int step;
+        const int depth = mapPadIndex(j, m_band.sourceDepth, FillKernels::PadReflect, &step);
+        const QRgb *line = m_band.origin - (depth + 1) * m_band.outward;
+        const int length = m_band.length;
+        
+        // prefix 以 m_prefixBegin 为起点
+        quint32 *prefix = m_prefix.data() - static_cast<ptrdiff_t>(m_prefixBegin) * 4;
+        for (int t = m_prefixBegin; t < m_prefixEnd; ++t) {
+            const QRgb pixel = line[t * m_band.along];
+            quint32 *current = prefix + (t + 1) * 4;
+            const quint32 *previous = prefix + t * 4;
+            current[0] = previous[0] + (pixel >> 24);
+            current[1] = previous[1] + ((pixel >> 16) & 0xff);
+            current[2] = previous[2] + ((pixel >> 8) & 0xff);
+            current[3] = previous[3] + (pixel & 0xff);
+        }
+        
+        const int radius = j / BLUR_GROWTH_DIVISOR;
+        qint32 *sums = m_columnSums.data() - static_cast<ptrdiff_t>(m_begin) * 4;
+        for (int t = m_begin; t < m_end; ++t) {
+            const int low = qMax(0, t - radius);
+            const int high = qMin(length - 1, t + radius);
+            const quint64 inverse = (quint64(1) << 32) / static_cast<quint64>(high - low + 1);
+            const quint32 *upper = prefix + (high + 1) * 4;
+            const quint32 *lower = prefix + low * 4;
+            
+            for (int c = 0; c < 4; ++c) {
+                const quint64 sum = upper[c] - lower[c];
+                const qint32 value = static_cast<qint32>((sum * inverse + (quint64(1) << 31)) >> 32);
+                sums[t * 4 + c] += sign * value;
+            }
+        }
+    }
+    
+    void writeRow(int d, int rowCount)
+    {
+        const quint64 inverse = (quint64(1) << 32) / static_cast<quint64>(rowCount);
+        const qint32 *sums = m_columnSums.data() - static_cast<ptrdiff_t>(m_begin) * 4;
+        QRgb *out = m_band.origin + d * m_band.outward;
+        
+        for (int t = m_begin; t < m_end; ++t) {
+            const qint32 *s = sums + t * 4;
+            const quint32 a = static_cast<quint32>((quint64(s[0]) * inverse + (quint64(1) << 31)) >> 32);
+            const quint32 r = static_cast<quint32>((quint64(s[1]) * inverse + (quint64(1) << 31)) >> 32);
+            const quint32 g = static_cast<quint32>((quint64(s[2]) * inverse + (quint64(1) << 31)) >> 32);
+            const quint32 b = static_cast<quint32>((quint64(s[3]) * inverse + (quint64(1) << 31)) >> 32);
+            out[t * m_band.along] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+    
+    const EdgeBand m_band;
+    const int m_begin;
+    const int m_end;
+    const int m_prefixBegin;
+    const int m_prefixEnd;
+    std::vector<quint32> m_prefix;
+    std::vector<qint32> m_columnSums;
+};
+
+void blurBands(const EdgeBand *bands, int count)
+{
+    struct Chunk {
+        int band;
+        int begin;
+        int end;
+    };
+    
+    // 只有一条边需要扩展时也能占满所有核心；段长不小于最大半径，两侧多算的前缀和不超过段长的两倍
+    const int threads = qMax(1, QThread::idealThreadCount());
+    std::vector<Chunk> chunks;
+    for (int i = 0; i < count; ++i) {
+        const EdgeBand &band = bands[i];
+        if (band.depth <= 0 || band.length <= 0) {
+            continue;
+        }
+        const int minChunk = qMax(BLUR_MIN_CHUNK, maxBlurRadius(band.depth));
+        const int chunkCount = qBound(1, band.length / minChunk, threads);
+        for (int c = 0; c < chunkCount; ++c) {
+            const Chunk chunk = { i, band.length * c / chunkCount, band.length * (c + 1) / chunkCount };
+            chunks.push_back(chunk);
+        }
+    }
+    
+    parallelFor(static_cast<int>(chunks.size()), [bands, &chunks](int i) {
+        const Chunk &chunk = chunks[static_cast<size_t>(i)];
+        BandBlur(bands[chunk.band], chunk.begin, chunk.end).run();
+    });
+}
+
+// 色场粗网格的单元边长（2 的幂，便于上采样时用移位计算）
+constexpr int COLOR_FIELD_CELL_SHIFT = 4;
+constexpr int COLOR_FIELD_CELL = 1 << COLOR_FIELD_CELL_SHIFT;
+
+struct ColorSample {
+    float x;
+    float y;
+    float channels[4];      // a, r, g, b
+};
+
+// 沿一条边累加各段颜色；position 为该边上像素的坐标
+void accumulateEdge(const QImage &canvas, const QRect &sourceRect, bool horizontal,
+                    int fixed, int segments, ColorSample *samples)
+{
+    const int begin = horizontal ? sourceRect.left() : sourceRect.top();
+    const int length = horizontal ? sourceRect.width() : sourceRect.height();
+    const ptrdiff_t stride = canvas.bytesPerLine() / static_cast<int>(sizeof(QRgb));
+    const QRgb *first = reinterpret_cast<const QRgb*>(canvas.constScanLine(horizontal ? fixed : begin)) +
+                        (horizontal ? begin : fixed);
+    const ptrdiff_t step = horizontal ? 1 : stride;
+    
+    for (int segment = 0; segment < segments; ++segment) {
+        const int start = segment * length / segments;
+        const int end = qMax(start + 1, (segment + 1) * length / segments);
+        quint64 sums[4] = { 0, 0, 0, 0 };
+        
+        for (int i = start; i < end && i < length; ++i) {
+            const QRgb pixel = first[i * step];
+            sums[0] += pixel >> 24;
+            sums[1] += (pixel >> 16) & 0xff;
+            sums[2] += (pixel >> 8) & 0xff;
+            sums[3] += pixel & 0xff;
+        }
+        
+        ColorSample &sample = samples[segment];
+        const int count = qMax(1, qMin(end, length) - start);
+        const float center = begin + (start + end) * 0.5f;
+        sample.x = horizontal ? center : fixed + 0.5f;
+        sample.y = horizontal ? fixed + 0.5f : center;
+        for (int c = 0; c < 4; ++c) {
+            sample.channels[c] = static_cast<float>(sums[c]) / count;
+        }
+    }
+}
+
+} // namespace
+
+void FillKernels::fillSpan(QRgb *dst, QRgb value, int count)
+{
+    int i = 0;
+    
+#ifdef FILLKERNELS_SSE2
+    const __m128i broadcast = _mm_set1_epi32(static_cast<int>(value));
+    for (; i + 16 <= count; i += 16) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), broadcast);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), broadcast);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), broadcast);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 12), broadcast);
+    }
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), broadcast);
+    }
+#endif
+    
+    for (; i < count; ++i) {
+        dst[i] = value;
+    }
+}
+
+void FillKernels::fillSolid(QImage &canvas, const QRect &sourceRect, QRgb color)
+{
+    const int width = canvas.width();
+    const int rightStart = sourceRect.right() + 1;
+    const int rightCount = width - rightStart;
+    
+    for (int y = 0; y < sourceRect.top(); ++y) {
+        fillSpan(canvasLine(canvas, y), color, width);
+    }
+    
+    for (int y = sourceRect.top(); y <= sourceRect.bottom(); ++y) {
+        QRgb *line = canvasLine(canvas, y);
+        fillSpan(line, color, sourceRect.left());
+        fillSpan(line + rightStart, color, rightCount);
+    }
+    
+    for (int y = sourceRect.bottom() + 1; y < canvas.height(); ++y) {
+        fillSpan(canvasLine(canvas, y), color, width);
+    }
+}
+
+void FillKernels::fillEdgeStretch(QImage &canvas, const QRect &sourceRect)
+{
+    if (sourceRect.isEmpty()) {
+        return;
+    }
+    
+    const int rightStart = sourceRect.right() + 1;
+    const int rightCount = canvas.width() - rightStart;
+    
+    // 左右边距：广播该行的首/末源像素
+    for (int y = sourceRect.top(); y <= sourceRect.bottom(); ++y) {
+        QRgb *line = canvasLine(canvas, y);
+        fillSpan(line, line[sourceRect.left()], sourceRect.left());
+        fillSpan(line + rightStart, line[sourceRect.right()], rightCount);
+    }
+    
+    // 上下边距（含四角）：复制已扩展好的首/末行
+    replicateRow(canvas, sourceRect.top(), 0, sourceRect.top());
+    replicateRow(canvas, sourceRect.bottom(), sourceRect.bottom() + 1,
+                 canvas.height() - sourceRect.bottom() - 1);
+}
+
+void FillKernels::fillPadded(QImage &canvas, const QRect &sourceRect, PadMode mode)
+{
+    if (sourceRect.isEmpty()) {
+        return;
+    }
+    
+    const int sourceWidth = sourceRect.width();
+    const int sourceHeight = sourceRect.height();
+    const int rightStart = sourceRect.right() + 1;
+    const int rightCount = canvas.width() - rightStart;
+    
+    // 左右边距：在每个源行内按片段拷贝
+    for (int y = sourceRect.top(); y <= sourceRect.bottom(); ++y) {
+        QRgb *line = canvasLine(canvas, y);
+        const QRgb *source = line + sourceRect.left();
+        padSpan(line, source, sourceWidth, -sourceRect.left(), sourceRect.left(), mode);
+        padSpan(line + rightStart, source, sourceWidth, sourceWidth, rightCount, mode);
+    }
+    
+    // 上下边距：整行拷贝已扩展好的源行
+    const size_t rowBytes = static_cast<size_t>(canvas.width()) * sizeof(QRgb);
+    for (int y = 0; y < canvas.height(); ++y) {
+        if (y == sourceRect.top()) {
+            y = sourceRect.bottom();
+            continue;
+        }
+        
+        int step;
+        const int index = mapPadIndex(y - sourceRect.top(), sourceHeight, mode, &step);
+        std::memcpy(canvas.scanLine(y), canvas.constScanLine(sourceRect.top() + index), rowBytes);
+    }
+}
+
+void FillKernels::fillBlurredEdge(QImage &canvas, const QRect &sourceRect)
+{
+    if (sourceRect.isEmpty()) {
+        return;
+    }
+    
+    const ptrdiff_t stride = canvas.bytesPerLine() / static_cast<int>(sizeof(QRgb));
+    QRgb *topLine = canvasLine(canvas, sourceRect.top());
+    
+    // 第一阶段：左右边带（仅源图所在行）
+    const EdgeBand sideBands[2] = {
+        { topLine + sourceRect.left() - 1, -1, stride,
+          sourceRect.left(), sourceRect.height(), sourceRect.width() },
+        { topLine + sourceRect.right() + 1, 1, stride,
+          canvas.width() - sourceRect.right() - 1, sourceRect.height(), sourceRect.width() }
+    };
+    blurBands(sideBands, 2);
+    
+    // 第二阶段：上下边带覆盖整行（含四角），以已延伸好的行为源
+    const EdgeBand verticalBands[2] = {
+        { topLine - stride, -stride, 1,
+          sourceRect.top(), canvas.width(), sourceRect.height() },
+        { canvasLine(canvas, sourceRect.bottom()) + stride, stride, 1,
+          canvas.height() - sourceRect.bottom() - 1, canvas.width(), sourceRect.height() }
+    };
+    blurBands(verticalBands, 2);
+}
+
+void FillKernels::fillColorField(QImage &canvas, const QRect &sourceRect, int segments)
+{
+    if (sourceRect.isEmpty()) {
+        return;
+    }
+    
+    // 单次遍历四条边的像素，得到 4 * segments 个颜色采样
+    const int horizontalSegments = qBound(1, segments, sourceRect.width());
+    const int verticalSegments = qBound(1, segments, sourceRect.height());
+    std::vector<ColorSample> samples(2 * horizontalSegments + 2 * verticalSegments);
+    ColorSample *cursor = samples.data();
+    
+    accumulateEdge(canvas, sourceRect, true, sourceRect.top(), horizontalSegments, cursor);
+    cursor += horizontalSegments;
+    accumulateEdge(canvas, sourceRect, true, sourceRect.bottom(), horizontalSegments, cursor);
+    cursor += horizontalSegments;
+    accumulateEdge(canvas, sourceRect, false, sourceRect.left(), verticalSegments, cursor);
+    cursor += verticalSegments;
+    accumulateEdge(canvas, sourceRect, false, sourceRect.right(), verticalSegments, cursor);
+    
+    // 粗网格节点：反距离平方加权插值
+    const int gridWidth = (canvas.width() >> COLOR_FIELD_CELL_SHIFT) + 2;
+    const int gridHeight = (canvas.height() >> COLOR_FIELD_CELL_SHIFT) + 2;
+    std::vector<quint32> grid(static_cast<size_t>(gridWidth) * gridHeight * 4);
+    
+    parallelFor(gridHeight, [&](int gy) {
+        const float y = static_cast<float>(gy * COLOR_FIELD_CELL);
+        for (int gx = 0; gx < gridWidth; ++gx) {
+            const float x = static_cast<float>(gx * COLOR_FIELD_CELL);
+            float weights = 0.0f;
+            float channels[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            
+            for (const ColorSample &sample : samples) {
+                const float dx = x - sample.x;
+                const float dy = y - sample.y;
+                const float weight = 1.0f / (dx * dx + dy * dy + 1.0f);
+                weights += weight;
+                for (int c = 0; c < 4; ++c) {
+                    channels[c] += weight * sample.channels[c];
+                }
+            }
+            
+            // 以 8 位小数的定点数保存，上采样时做整数插值
+            quint32 *node = grid.data() + (static_cast<size_t>(gy) * gridWidth + gx) * 4;
+            for (int c = 0; c < 4; ++c) {
+                node[c] = static_cast<quint32>(channels[c] / weights * 256.0f + 0.5f);
+            }
+        }
+    });
+    
+    // 双线性上采样，只写边距像素：先按行在纵向插值网格，再逐像素横向插值
+    parallelFor(canvas.height(), [&](int y) {
+        QRgb *line = canvasLine(canvas, y);
+        const int gy = y >> COLOR_FIELD_CELL_SHIFT;
+        const quint32 fy = static_cast<quint32>(y & (COLOR_FIELD_CELL - 1));
+        const quint32 *upper = grid.data() + static_cast<size_t>(gy) * gridWidth * 4;
+        const quint32 *lower = upper + gridWidth * 4;
+        
+        std::vector<quint32> row(static_cast<size_t>(gridWidth) * 4);
+        for (int i = 0; i < gridWidth * 4; ++i) {
+            row[i] = upper[i] * (COLOR_FIELD_CELL - fy) + lower[i] * fy;
+        }
+        
+        const bool sourceRow = y >= sourceRect.top() && y <= sourceRect.bottom();
+        for (int x = 0; x < canvas.width(); ++x) {
+            if (sourceRow && x == sourceRect.left()) {
+                x = sourceRect.right();
+                continue;
+            }
+            
+            const quint32 fx = static_cast<quint32>(x & (COLOR_FIELD_CELL - 1));
+            const quint32 *node = row.data() + (x >> COLOR_FIELD_CELL_SHIFT) * 4;
+            QRgb pixel = 0;
+            for (int c = 0; c < 4; ++c) {
+                const quint32 value = (node[c] * (COLOR_FIELD_CELL - fx) + node[c + 4] * fx) >>
+                                      (2 * COLOR_FIELD_CELL_SHIFT + 8);
+                pixel |= qMin<quint32>(value, 255) << (24 - 8 * c);
+            }
+            line[x] = pixel;
+        }
+    });
+}
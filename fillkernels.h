@@ -0,0 +1,42 @@
+#ifndef FILLKERNELS_H
+#define FILLKERNELS_H
+
+#include <QImage>
+#include <QRect>
+#include <QRgb>
+
+// 边距填充内核
+// 画布为 32 位格式（ARGB32 / RGB32），源图已放置在 sourceRect 中，
+// 各函数只写 sourceRect 之外的区域
+namespace FillKernels
+{
+    // 周期性填充方式
+    enum PadMode {
+        PadReflect,         // 镜像，重复边缘像素：cba|abc|cba
+        PadReflect101,      // 镜像，不重复边缘像素：dcb|abcd|cba
+        PadWrap             // 平铺：abc|abc|abc
+    };
+    
+    // 用单一颜色填充一段连续像素（SIMD 宽广播写入）
+    void fillSpan(QRgb *dst, QRgb value, int count);
+    
+    // 纯色填充四周边距
+    void fillSolid(QImage &canvas, const QRect &sourceRect, QRgb color);
+    
+    // 边缘拉伸：每行/列重复最近的源图边缘像素
+    void fillEdgeStretch(QImage &canvas, const QRect &sourceRect);
+    
+    // 镜像/平铺：按行拷贝连续片段，镜像片段使用 SIMD 通道反转；
+    // 边距超过源图尺寸时按周期重复
+    void fillPadded(QImage &canvas, const QRect &sourceRect, PadMode mode);
+    
+    // 模糊边缘延伸：以镜像内容延伸边缘，并随离源图距离增大逐渐模糊
+    // 使用滑动窗口求和的盒式模糊，单像素成本与模糊半径无关；各边带沿边缘分段并行处理
+    void fillBlurredEdge(QImage &canvas, const QRect &sourceRect);
+    
+    // 边缘色场：将每条源图边缘分为 segments 段并单次遍历求各段平均色，
+    // 在粗网格上对这些采样做反距离加权插值，再双线性上采样填充边距
+    void fillColorField(QImage &canvas, const QRect &sourceRect, int segments);
+}
+
+#endif // FILLKERNELS_H
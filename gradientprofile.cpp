@@ -0,0 +1,95 @@
+#include "gradientprofile.h"
+#include <algorithm>
+#include <cmath>
+
+GradientProfile::GradientProfile()
+    : m_curve(Smoothstep)
+    , m_strength(1.0)
+    , m_fingerprint(0)
+{
+    bake();
+}
+
+void GradientProfile::setCurve(Curve curve)
+{
+    if (m_curve != curve) {
+        m_curve = curve;
+        bake();
+    }
+}
+
+void GradientProfile::setCustomPoints(const QVector<QPointF> &points)
+{
+    // 限制到单位方格并按 x 排序，插值时即可顺序查找
+    QVector<QPointF> sorted;
+    sorted.reserve(points.size());
+    for (const QPointF &point : points) {
+        sorted.append(QPointF(qBound(0.0, point.x(), 1.0), qBound(0.0, point.y(), 1.0)));
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const QPointF &a, const QPointF &b) {
+        return a.x() < b.x();
+    });
+
+    m_customPoints = sorted;
+    if (m_curve == Custom) {
+        bake();
+    }
+}
+
+void GradientProfile::setStrength(double strength)
+{
+    strength = qBound(0.0, strength, 1.0);
+    if (m_strength != strength) {
+        m_strength = strength;
+        bake();
+    }
+}
+
+double GradientProfile::evaluate(double t) const
+{
+    switch (m_curve) {
+    case Linear:
+        return t;
+    case Smoothstep:
+        return t * t * (3.0 - 2.0 * t);
+    case Smootherstep:
+        return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+    case Exponential:
+        return (1.0 - std::exp(-EXPONENTIAL_RATE * t)) / (1.0 - std::exp(-EXPONENTIAL_RATE));
+    case Custom:
+        break;
+    }
+
+    // 自定义曲线：隐含端点 (0,0) 与 (1,1)，控制点之间线性插值
+    QPointF previous(0.0, 0.0);
+    for (const QPointF &point : m_customPoints) {
+        if (t <= point.x()) {
+            const double span = point.x() - previous.x();
+            if (span <= 0.0) {
+                return point.y();
+            }
+            return previous.y() + (point.y() - previous.y()) * (t - previous.x()) / span;
+        }
+        previous = point;
+    }
+    const double span = 1.0 - previous.x();
+    if (span <= 0.0) {
+        return previous.y();
+    }
+    return previous.y() + (1.0 - previous.y()) * (t - previous.x()) / span;
+}
+
+void GradientProfile::bake()
+{
+    uint hash = 0;
+    for (int i = 0; i <= LUT_SIZE; ++i) {
+        const double t = static_cast<double>(i) / LUT_SIZE;
+        const double progress = qBound(0.0, evaluate(t), 1.0);
+        const int weight = qRound(m_strength * (1.0 - progress) * WEIGHT_ONE);
+        // 末项固定为 0：过渡带以外与没有源图像素的位置都查到这一项，
+        // 自定义曲线在 x = 1 处未到达 1 时也不能把边缘色带到整个边距
+        m_weights[i] = i == LUT_SIZE ? 0 : qBound(0, weight, static_cast<int>(WEIGHT_ONE));
+        hash = hash * 31u + static_cast<uint>(m_weights[i]);
+    }
+    m_fingerprint = hash;
+}
@@ -0,0 +1,67 @@
+#ifndef GRADIENTPROFILE_H
+#define GRADIENTPROFILE_H
+
+#include <QVector>
+#include <QPointF>
+#include <QtGlobal>
+
+// 渐变混合曲线
+// 每次参数变化时将曲线与强度烘焙为整数权重查找表，混合内核直接按
+// 归一化距离查表，热循环中不再有浮点运算。
+// 权重表示边缘颜色所占比例（0..WEIGHT_ONE），紧邻源图处最大，随距离衰减到 0。
+class GradientProfile
+{
+public:
+    enum Curve {
+        Linear,             // 线性
+        Smoothstep,         // 3t² - 2t³
+        Smootherstep,       // 6t⁵ - 15t⁴ + 10t³
+        Exponential,        // 指数衰减，靠近源图处变化更快
+        Custom              // 自定义控制点，分段线性插值
+    };
+
+    static constexpr int LUT_SIZE = 256;     // 归一化距离的量化级数
+    static constexpr int WEIGHT_SHIFT = 8;
+    static constexpr int WEIGHT_ONE = 1 << WEIGHT_SHIFT;
+
+    GradientProfile();
+
+    void setCurve(Curve curve);
+    Curve curve() const { return m_curve; }
+
+    // 控制点坐标均在 [0,1]：x 为归一化距离，y 为过渡进度（0 为边缘色，1 为背景色）
+    void setCustomPoints(const QVector<QPointF> &points);
+    QVector<QPointF> customPoints() const { return m_customPoints; }
+
+    void setStrength(double strength);
+    double strength() const { return m_strength; }
+
+    // 距源图 distance 像素处（共 maxDistance 像素的过渡带）边缘颜色的权重
+    inline int weightAt(int distance, int maxDistance) const
+    {
+        if (distance >= maxDistance) {
+            return 0;
+        }
+        return m_weights[static_cast<qint64>(distance) * LUT_SIZE / maxDistance];
+    }
+
+    // 查找表本身（LUT_SIZE + 1 项，最后一项对应过渡带末端，恒为 0）
+    const int *weights() const { return m_weights; }
+
+    // 查找表内容的哈希，用作结果缓存键的一部分
+    uint fingerprint() const { return m_fingerprint; }
+
+private:
+    void bake();
+    double evaluate(double t) const;
+
+    Curve m_curve;
+    QVector<QPointF> m_customPoints;
+    double m_strength;
+    int m_weights[LUT_SIZE + 1];
+    uint m_fingerprint;
+
+    static constexpr double EXPONENTIAL_RATE = 4.0;
+};
+
+#endif // GRADIENTPROFILE_H
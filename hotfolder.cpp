@@ -0,0 +1,180 @@
+#include "hotfolder.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+
+HotFolder::HotFolder(const BatchProcessor *processor, QObject *parent)
+    : QObject(parent)
+    , m_processor(processor)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_scanTimer(new QTimer(this))
+    , m_pollTimer(new QTimer(this))
+    , m_nameFilters(BatchProcessor::inputNameFilters())
+    , m_active(0)
+    , m_pollInterval(0)
+    , m_settleInterval(DEFAULT_SETTLE_INTERVAL)
+{
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+
+    // 一次拷入大量文件会连续触发通知，合并为一次扫描
+    m_scanTimer->setSingleShot(true);
+    connect(m_scanTimer, &QTimer::timeout, this, &HotFolder::scan);
+    connect(m_pollTimer, &QTimer::timeout, this, &HotFolder::scan);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &HotFolder::scheduleScan);
+}
+
+HotFolder::~HotFolder()
+{
+    // 任务会向本对象投递结果，必须在析构前结束
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+void HotFolder::setWorkerCount(int count)
+{
+    m_pool.setMaxThreadCount(qMax(1, count));
+}
+
+bool HotFolder::start(const QString &inputDirectory, QString *errorString)
+{
+    const auto fail = [errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        return false;
+    };
+
+    const QFileInfo input(inputDirectory);
+    if (!input.isDir()) {
+        return fail("输入目录不存在: " + inputDirectory);
+    }
+    m_inputDirectory = input.absoluteFilePath();
+
+    // 结果写回输入目录会被当作新文件再次处理
+    const QString outputDirectory = m_processor->options().outputDirectory;
+    if (outputDirectory.isEmpty() ||
+        QFileInfo(outputDirectory).absoluteFilePath() == m_inputDirectory) {
+        return fail("输出目录不能与输入目录相同");
+    }
+    if (!QDir().mkpath(outputDirectory)) {
+        return fail("无法创建输出目录: " + outputDirectory);
+    }
+
+    // 输出已是最新的文件不再处理
+    const QFileInfoList entries = QDir(m_inputDirectory).entryInfoList(m_nameFilters, QDir::Files);
+    for (const QFileInfo &entry : entries) {
+        const QFileInfo output(m_processor->outputPathFor(entry.filePath()));
+        if (output.exists() && output.lastModified() >= entry.lastModified()) {
+            m_handled.insert(entry.filePath(), entry.lastModified());
+        }
+    }
+
+    // 网络共享等文件系统可能不产生通知，此时只能轮询
+    const bool watching = m_watcher->addPath(m_inputDirectory);
+    const int interval = m_pollInterval > 0 ? m_pollInterval : (watching ? 0 : FALLBACK_POLL_INTERVAL);
+    if (interval > 0) {
+        m_pollTimer->start(interval);
+    }
+    scan();
+    return true;
+}
+
+void HotFolder::scheduleScan()
+{
+    if (!m_scanTimer->isActive()) {
+        m_scanTimer->start(COALESCE_INTERVAL);
+    }
+}
+
+void HotFolder::scan()
+{
+    const QFileInfoList entries = QDir(m_inputDirectory).entryInfoList(m_nameFilters, QDir::Files);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QSet<QString> present;
+    present.reserve(entries.size());
+
+    for (const QFileInfo &entry : entries) {
+        const QString path = entry.filePath();
+        const QDateTime modified = entry.lastModified();
+        present.insert(path);
+
+        // 已处理且未再修改
+        const QHash<QString, QDateTime>::const_iterator handled = m_handled.constFind(path);
+        if (handled != m_handled.constEnd() && handled.value() == modified) {
+            continue;
+        }
+
+        // 大小与修改时间在稳定间隔内均未变化，视为写入完成
+        const QHash<QString, Candidate>::iterator candidate = m_candidates.find(path);
+        if (candidate != m_candidates.end() &&
+            candidate->size == entry.size() && candidate->modified == modified) {
+            if (now - candidate->unchangedSince >= m_settleInterval) {
+                m_candidates.erase(candidate);
+                m_handled.insert(path, modified);
+                m_queue.enqueue(path);
+            }
+            continue;
+        }
+        Candidate state;
+        state.size = entry.size();
+        state.modified = modified;
+        state.unchangedSince = now;
+        m_candidates.insert(path, state);
+    }
+
+    // 删除的文件不再跟踪，同名文件再次出现时重新处理
+    for (QHash<QString, Candidate>::iterator it = m_candidates.begin(); it != m_candidates.end();) {
+        if (present.contains(it.key())) {
+            ++it;
+        } else {
+            it = m_candidates.erase(it);
+        }
+    }
+    for (QHash<QString, QDateTime>::iterator it = m_handled.begin(); it != m_handled.end();) {
+        if (present.contains(it.key())) {
+            ++it;
+        } else {
+            it = m_handled.erase(it);
+        }
+    }
+
+    // 仍有未稳定的文件时，稳定间隔后再确认一次
+    if (!m_candidates.isEmpty()) {
+        m_scanTimer->start(m_settleInterval);
+    }
+    dispatch();
+}
+
+void HotFolder::dispatch()
+{
+    // 同时提交的任务数不超过工作线程数，排队的文件只占用一个路径。
+    // 只有扩展名不同的输入（a.jpg 与 a.png）对应同一个输出文件，这样的文件依次处理，
+    // 不会同时写同一目标；后到的文件留在队列中原位，不阻塞其他文件
+    for (int i = 0; i < m_queue.size() && m_active < m_pool.maxThreadCount();) {
+        const QString path = m_queue.at(i);
+        const QString output = m_processor->outputPathFor(path);
+        if (m_busyOutputs.contains(output)) {
+            ++i;
+            continue;
+        }
+        m_queue.removeAt(i);
+        m_busyOutputs.insert(output);
+        ++m_active;
+        const BatchProcessor *processor = m_processor;
+        m_pool.start([this, processor, path]() {
+            const BatchProcessor::Result result = processor->processFile(path);
+            QMetaObject::invokeMethod(this, [this, result]() {
+                onFinished(result);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void HotFolder::onFinished(const BatchProcessor::Result &result)
+{
+    --m_active;
+    m_busyOutputs.remove(result.outputPath);
+    dispatch();
+    emit fileProcessed(result);
+}
@@ -0,0 +1,91 @@
+#ifndef HOTFOLDER_H
+#define HOTFOLDER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QQueue>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include "batchprocessor.h"
+
+// 热文件夹监视
+// 监视输入目录（QFileSystemWatcher，在 Linux 上基于 inotify；无法监视时改为定时轮询），
+// 新文件的大小与修改时间在一个稳定间隔内不再变化后才视为写入完成，交给工作线程
+// 按 BatchProcessor 的配置处理，结果经 ImageExporter 原子写入输出目录。
+// 同时处理的文件数不超过工作线程数，其余文件只以路径排队，突发大量文件时内存有上限；
+// 输出路径相同的文件（仅扩展名不同的输入）依次处理，后处理的结果覆盖先前的结果；
+// 每个文件内部的填充与编码仍借用全局线程池的空闲线程
+class HotFolder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HotFolder(const BatchProcessor *processor, QObject *parent = nullptr);
+    // 等待处理中的文件写完
+    ~HotFolder() override;
+
+    // 同时处理的文件数，默认为 CPU 核心数
+    void setWorkerCount(int count);
+    int workerCount() const { return m_pool.maxThreadCount(); }
+
+    // 定时轮询的间隔（毫秒）；0 表示只依赖文件系统通知（通知不可用时仍会轮询）
+    void setPollInterval(int ms) { m_pollInterval = qMax(0, ms); }
+    int pollInterval() const { return m_pollInterval; }
+
+    // 文件大小与修改时间保持不变多久后开始处理（毫秒）
+    void setSettleInterval(int ms) { m_settleInterval = qMax(0, ms); }
+    int settleInterval() const { return m_settleInterval; }
+
+    // 开始监视；输出已比输入新的文件视为处理过，重启后不会重复处理
+    bool start(const QString &inputDirectory, QString *errorString = nullptr);
+    bool isPolling() const { return m_pollTimer->isActive(); }
+
+    int pendingCount() const { return m_queue.size() + m_candidates.size(); }
+    int activeCount() const { return m_active; }
+
+signals:
+    void fileProcessed(const BatchProcessor::Result &result);
+
+private slots:
+    void scheduleScan();
+    void scan();
+
+private:
+    // 候选文件上一次扫描时的状态
+    struct Candidate {
+        qint64 size;
+        QDateTime modified;
+        qint64 unchangedSince;  // 大小与修改时间最近一次变化的时刻（毫秒）
+    };
+
+    void dispatch();
+    void onFinished(const BatchProcessor::Result &result);
+
+    const BatchProcessor *m_processor;
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_scanTimer;
+    QTimer *m_pollTimer;
+    QThreadPool m_pool;
+
+    QString m_inputDirectory;
+    QStringList m_nameFilters;
+    QHash<QString, Candidate> m_candidates;     // 尚在写入或等待确认稳定的文件
+    QHash<QString, QDateTime> m_handled;        // 已排队或处理过的文件及当时的修改时间
+    QQueue<QString> m_queue;                    // 已稳定、等待空闲工作线程的文件
+    QSet<QString> m_busyOutputs;                // 正在写入的输出文件
+    int m_active;
+
+    int m_pollInterval;
+    int m_settleInterval;
+
+    static constexpr int COALESCE_INTERVAL = 100;       // 合并连续目录通知的等待时间（毫秒）
+    static constexpr int FALLBACK_POLL_INTERVAL = 2000; // 通知不可用时的轮询间隔（毫秒）
+    static constexpr int DEFAULT_SETTLE_INTERVAL = 1000;
+};
+
+#endif // HOTFOLDER_H
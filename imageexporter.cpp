@@ -0,0 +1,338 @@
+#include "imageexporter.h"
+#include "mappedimage.h"
+#include "pngwriter.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QMetaObject>
+#include <QSaveFile>
+
+constexpr int ImageExporter::MAX_CONCURRENT_JOBS;
+
+namespace {
+
+// 包装输出文件：取消后写入失败，使编码器在下一次输出时中止；
+// 同时按已写入的字节数报告编码进度
+class CancellableDevice : public QIODevice
+{
+public:
+    CancellableDevice(QIODevice *target, const std::atomic<bool> *cancelled,
+                      const std::function<void(qint64)> &written)
+        : m_target(target)
+        , m_cancelled(cancelled)
+        , m_written(written)
+        , m_total(0)
+    {
+    }
+    
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(maxSize);
+        return -1;
+    }
+    
+    qint64 writeData(const char *data, qint64 size) override
+    {
+        if (m_cancelled && m_cancelled->load()) {
+            setErrorString("导出已取消");
+            return -1;
+        }
+        const qint64 result = m_target->write(data, size);
+        if (result < 0) {
+            setErrorString(m_target->errorString());
+            return -1;
+        }
+        m_total += result;
+        if (m_written) {
+            m_written(m_total);
+        }
+        return result;
+    }
+
+private:
+    QIODevice *m_target;
+    const std::atomic<bool> *m_cancelled;
+    std::function<void(qint64)> m_written;
+    qint64 m_total;
+};
+
+QByteArray formatForFile(const QString &fileName)
+{
+    QByteArray suffix = QFileInfo(fileName).suffix().toLower().toLatin1();
+    if (suffix == "jpeg") {
+        suffix = "jpg";
+    } else if (suffix == "tif") {
+        suffix = "tiff";
+    }
+    return suffix.isEmpty() ? QByteArray("png") : suffix;
+}
+
+} // namespace
+
+ImageExporter::EncoderSettings ImageExporter::defaultEncoderSettings()
+{
+    EncoderSettings settings;
+    settings.pngCompression = 6;
+    settings.jpegQuality = 90;
+    settings.optimized = true;
+    settings.progressive = false;
+    settings.losslessJpeg = true;
+    return settings;
+}
+
+ImageExporter::ImageExporter(QObject *parent)
+    : QObject(parent)
+    , m_nextJobId(1)
+{
+    m_pool.setMaxThreadCount(MAX_CONCURRENT_JOBS);
+}
+
+ImageExporter::~ImageExporter()
+{
+    // 任务会向本对象投递结果，必须在析构前结束
+    m_pool.waitForDone();
+}
+
+int ImageExporter::exportImage(const QImage &image, const QString &fileName,
+                               const EncoderSettings &settings)
+{
+    // 按值捕获图像即为快照
+    return startJob(fileName, [image, fileName, settings](const std::atomic<bool> *cancelled,
+                                                          const ProgressCallback &progress,
+                                                          QString *errorString) {
+        return write(image, fileName, settings, errorString, cancelled, progress);
+    });
+}
+
+int ImageExporter::exportPaddedJpeg(const JpegPadding &padding, const QImage &fallbackImage,
+                                    const QString &fileName, const EncoderSettings &settings)
+{
+    return startJob(fileName, [padding, fallbackImage, fileName, settings](const std::atomic<bool> *cancelled,
+                                                                           const ProgressCallback &progress,
+                                                                           QString *errorString) {
+        if (writePaddedJpeg(padding, fileName, errorString, cancelled, progress)) {
+            return true;
+        }
+        if (cancelled->load()) {
+            return false;
+        }
+        return write(fallbackImage, fileName, settings, errorString, cancelled, progress);
+    });
+}
+
+int ImageExporter::startJob(const QString &fileName, const Job &job)
+{
+    const int jobId = m_nextJobId++;
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_cancelFlags.insert(jobId, cancelled);
+    
+    m_pool.start([this, jobId, fileName, job, cancelled]() {
+        QElapsedTimer timer;
+        timer.start();
+        
+        const ProgressCallback progress = [this, jobId, fileName](int percent, const QString &stage) {
+            QMetaObject::invokeMethod(this, [this, jobId, fileName, percent, stage]() {
+                if (m_cancelFlags.contains(jobId)) {
+                    emit jobProgress(jobId, fileName, percent, stage);
+                }
+            }, Qt::QueuedConnection);
+        };
+        
+        QString errorString;
+        const bool success = job(cancelled.get(), progress, &errorString);
+        const qint64 elapsedMs = timer.elapsed();
+        QMetaObject::invokeMethod(this, [this, jobId, fileName, success, errorString, elapsedMs]() {
+            finishJob(jobId, fileName, success, errorString, elapsedMs);
+        }, Qt::QueuedConnection);
+    });
+    
+    return jobId;
+}
+
+void ImageExporter::cancel(int jobId)
+{
+    const auto it = m_cancelFlags.constFind(jobId);
+    if (it != m_cancelFlags.constEnd()) {
+        it.value()->store(true);
+    }
+}
+
+void ImageExporter::cancelAll()
+{
+    for (auto it = m_cancelFlags.constBegin(); it != m_cancelFlags.constEnd(); ++it) {
+        it.value()->store(true);
+    }
+}
+
+void ImageExporter::finishJob(int jobId, const QString &fileName, bool success,
+                              const QString &errorString, qint64 elapsedMs)
+{
+    m_cancelFlags.remove(jobId);
+    emit jobFinished(jobId, fileName, success, errorString, elapsedMs);
+}
+
+bool ImageExporter::write(const QImage &image, const QString &fileName,
+                          const EncoderSettings &settings, QString *errorString,
+                          const std::atomic<bool> *cancelled,
+                          const ProgressCallback &progress)
+{
+    const auto report = [&progress](int percent, const QString &stage) {
+        if (progress) {
+            progress(percent, stage);
+        }
+    };
+    const auto fail = [errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        return false;
+    };
+    
+    if (image.isNull()) {
+        return fail("没有可导出的图像");
+    }
+    if (cancelled && cancelled->load()) {
+        return fail("导出已取消");
+    }
+    
+    report(0, "准备");
+    if (MappedImage::canWrite(fileName)) {
+        // 未压缩格式：像素直接写入预先分配大小的映射文件
+        QString writeError;
+        if (!MappedImage::write(image, fileName, &writeError, cancelled, [&report](int percent) {
+                report(5 + percent * 90 / 100, "写入");
+            })) {
+            return fail(cancelled && cancelled->load() ? QString("导出已取消") : writeError);
+        }
+        report(100, "完成");
+        return true;
+    }
+    
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(file.errorString());
+    }
+    
+    const QByteArray format = formatForFile(fileName);
+    report(5, "编码");
+    
+    bool encoded = false;
+    QString encodeError;
+    if (format == "png") {
+        // 项目内的并行 PNG 编码器，按完成的行组报告进度
+        PngWriter writer(settings.pngCompression);
+        encoded = writer.write(image, &file, cancelled, [&report](int done, int total) {
+            report(5 + done * 90 / total, "编码");
+        });
+        encodeError = writer.errorString();
+    } else {
+        // Qt 的编码器不报告进度，按典型的压缩率估计输出大小，由已写入的字节数推算进度
+        qint64 estimate = image.sizeInBytes();
+        if (format == "jpg") {
+            estimate /= 8;
+        }
+        estimate = qMax<qint64>(1, estimate);
+        int lastPercent = -1;
+        CancellableDevice device(&file, cancelled, [&](qint64 written) {
+            const int percent = 5 + static_cast<int>(qMin<qint64>(written * 90 / estimate, 89));
+            if (percent != lastPercent) {
+                lastPercent = percent;
+                report(percent, "编码");
+            }
+        });
+        device.open(QIODevice::WriteOnly);
+        
+        QImageWriter writer(&device, format);
+        if (format == "jpg") {
+            writer.setQuality(qBound(0, settings.jpegQuality, 100));
+            writer.setOptimizedWrite(settings.optimized);
+            writer.setProgressiveScanWrite(settings.progressive);
+        }
+        encoded = writer.write(image);
+        encodeError = writer.errorString();
+    }
+    
+    if (!encoded) {
+        file.cancelWriting();
+        if (cancelled && cancelled->load()) {
+            return fail("导出已取消");
+        }
+        return fail(encodeError);
+    }
+    
+    report(95, "写入");
+    if (cancelled && cancelled->load()) {
+        file.cancelWriting();
+        return fail("导出已取消");
+    }
+    if (!file.commit()) {
+        return fail(file.errorString());
+    }
+    
+    report(100, "完成");
+    return true;
+}
+
+bool ImageExporter::writePaddedJpeg(const JpegPadding &padding, const QString &fileName,
+                                    QString *errorString, const std::atomic<bool> *cancelled,
+                                    const ProgressCallback &progress)
+{
+    const auto report = [&progress](int percent, const QString &stage) {
+        if (progress) {
+            progress(percent, stage);
+        }
+    };
+    const auto fail = [errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        return false;
+    };
+    
+    report(0, "读取");
+    QFile source(padding.sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return fail(source.errorString());
+    }
+    if (QFileInfo(padding.sourcePath).lastModified() != padding.sourceModified) {
+        return fail("源文件已被修改: " + padding.sourcePath);
+    }
+    const QByteArray sourceData = source.readAll();
+    source.close();
+    
+    report(0, "解析");
+    JpegPadder padder;
+    if (!padder.load(sourceData, cancelled, [&report](int percent) {
+            report(percent * 45 / 100, "解析");
+        })) {
+        return fail(padder.errorString());
+    }
+    
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return fail(file.errorString());
+    }
+    if (!padder.pad(padding.margins, padding.color, &file, cancelled, [&report](int percent) {
+            report(45 + percent * 50 / 100, "扩展");
+        })) {
+        file.cancelWriting();
+        return fail(padder.errorString());
+    }
+    
+    report(95, "写入");
+    if (cancelled && cancelled->load()) {
+        file.cancelWriting();
+        return fail("导出已取消");
+    }
+    if (!file.commit()) {
+        return fail(file.errorString());
+    }
+    
+    report(100, "完成");
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef IMAGEEXPORTER_H
+#define IMAGEEXPORTER_H
+
+#include <QObject>
+#include <QImage>
+#include <QByteArray>
+#include <QColor>
+#include <QDateTime>
+#include <QString>
+#include <QHash>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "jpegpadder.h"
+
+// 后台图像编码
+// 每个导出任务持有结果图像的快照（隐式共享，界面继续编辑时写时复制，
+// 不会影响快照），在线程池中编码并经 QSaveFile 原子写入，
+// 取消或失败时不会留下不完整的目标文件
+class ImageExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 编码参数
+    struct EncoderSettings {
+        int pngCompression;     // PNG 压缩级别 0-9
+        int jpegQuality;        // JPEG 质量 0-100
+        bool optimized;         // JPEG 优化哈夫曼表
+        bool progressive;       // JPEG 渐进式扫描
+        bool losslessJpeg;      // JPEG 源图纯色扩展时在 DCT 域无损完成
+    };
+    
+    // JPEG 源图的无损扩展：源文件的 DCT 系数直接放入扩展后的系数网格
+    // 快照只记录源文件路径，文件内容在导出任务中读取
+    struct JpegPadding {
+        QString sourcePath;             // 源 JPEG 文件
+        QDateTime sourceModified;       // 检查边距时源文件的修改时间，之后被改写则不再适用
+        JpegPadder::Margins margins;    // 已按 MCU 对齐的边距
+        QColor color;
+    };
+    
+    static EncoderSettings defaultEncoderSettings();
+    
+    // 进度回调参数：百分比与当前阶段
+    typedef std::function<void(int percent, const QString &stage)> ProgressCallback;
+    // 导出任务：在线程池中执行，cancelled 置位后尽快中止，失败时写入 errorString
+    typedef std::function<bool(const std::atomic<bool> *cancelled, const ProgressCallback &progress,
+                               QString *errorString)> Job;
+    
+    explicit ImageExporter(QObject *parent = nullptr);
+    // 等待未完成的任务写完，不会丢弃用户的导出
+    ~ImageExporter() override;
+    
+    // 提交导出任务，返回任务编号
+    int exportImage(const QImage &image, const QString &fileName, const EncoderSettings &settings);
+    // 提交无损扩展任务；源数据无法在 DCT 域处理时改为编码 fallbackImage
+    int exportPaddedJpeg(const JpegPadding &padding, const QImage &fallbackImage,
+                         const QString &fileName, const EncoderSettings &settings);
+    // 提交自定义任务（如多比例版本导出），与其他导出共享并发上限、进度、取消与完成通知；
+    // fileName 为通知中显示的名称
+    int startJob(const QString &fileName, const Job &job);
+    void cancel(int jobId);
+    void cancelAll();
+    int activeJobCount() const { return m_cancelFlags.size(); }
+    
+    // 在调用线程中同步编码写入；cancelled 置位后尽快中止
+    static bool write(const QImage &image, const QString &fileName,
+                      const EncoderSettings &settings, QString *errorString = nullptr,
+                      const std::atomic<bool> *cancelled = nullptr,
+                      const ProgressCallback &progress = ProgressCallback());
+    static bool writePaddedJpeg(const JpegPadding &padding, const QString &fileName,
+                                QString *errorString = nullptr,
+                                const std::atomic<bool> *cancelled = nullptr,
+                                const ProgressCallback &progress = ProgressCallback());
+
+signals:
+    void jobProgress(int jobId, const QString &fileName, int percent, const QString &stage);
+    void jobFinished(int jobId, const QString &fileName, bool success,
+                     const QString &errorString, qint64 elapsedMs);
+
+private:
+    void finishJob(int jobId, const QString &fileName, bool success,
+                   const QString &errorString, qint64 elapsedMs);
+    
+    QThreadPool m_pool;
+    int m_nextJobId;
+    QHash<int, std::shared_ptr<std::atomic<bool>>> m_cancelFlags;
+    
+    // 同时编码的任务数上限，限制多个大图同时导出时的内存占用
+    static constexpr int MAX_CONCURRENT_JOBS = 2;
+};
+
+#endif // IMAGEEXPORTER_H
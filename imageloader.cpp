@@ -0,0 +1,143 @@
+#include "imageloader.h"
+#include "mappedimage.h"
+#include <QImageReader>
+#include <QImageIOHandler>
+#include <QMetaObject>
+
+constexpr double ImageLoader::MIN_PREVIEW_REDUCTION;
+
+ImageLoader::ImageLoader(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+    , m_loading(false)
+    , m_firstPixelMs(-1)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+ImageLoader::~ImageLoader()
+{
+    // 工作线程会向本对象投递结果，必须在析构前结束
+    cancel();
+    m_pool.waitForDone();
+}
+
+void ImageLoader::load(const QString &fileName, const QSize &previewSize)
+{
+    m_pool.clear();
+    const int generation = ++m_generation;
+    
+    m_loading = true;
+    m_fileName = fileName;
+    m_firstPixelMs = -1;
+    m_timer.start();
+    
+    m_pool.start([this, generation, fileName, previewSize]() {
+        decode(generation, fileName, previewSize);
+    });
+}
+
+void ImageLoader::cancel()
+{
+    m_pool.clear();
+    ++m_generation;
+    m_loading = false;
+}
+
+void ImageLoader::decode(int generation, const QString &fileName, const QSize &previewSize)
+{
+    // 未压缩的交换格式直接映射文件，像素不经过解码器，也不需要预览
+    QImageIOHandler::Transformations transformation = QImageIOHandler::TransformationNone;
+    QImage image = MappedImage::read(fileName);
+    if (image.isNull()) {
+        image = decodeWithReader(generation, fileName, previewSize, &transformation);
+        if (image.isNull()) {
+            return;
+        }
+    }
+    
+    // 确保图像格式支持颜色拾取；映射的 32 位 BMP 本身即为该格式，保持零复制
+    if (image.format() != QImage::Format_ARGB32 &&
+        image.format() != QImage::Format_RGB32) {
+        image = image.convertToFormat(QImage::Format_ARGB32);
+    }
+    
+    const OrientedImage oriented(image, transformation);
+    QMetaObject::invokeMethod(this, [this, generation, oriented]() {
+        deliverImage(generation, oriented);
+    }, Qt::QueuedConnection);
+}
+
+QImage ImageLoader::decodeWithReader(int generation, const QString &fileName, const QSize &previewSize,
+                                     QImageIOHandler::Transformations *transformation)
+{
+    // 第一阶段：解码时缩放，只读取视口所需的数据量
+    if (previewSize.isValid() && !previewSize.isEmpty()) {
+        QImageReader reader(fileName);
+        reader.setAutoTransform(true);
+        const QSize fullSize = reader.size();
+        if (fullSize.isValid() && reader.supportsOption(QImageIOHandler::ScaledSize) &&
+            (fullSize.width() >= previewSize.width() * MIN_PREVIEW_REDUCTION ||
+             fullSize.height() >= previewSize.height() * MIN_PREVIEW_REDUCTION)) {
+            const QSize scaledSize = fullSize.scaled(previewSize, Qt::KeepAspectRatio)
+                                             .expandedTo(QSize(1, 1));
+            reader.setScaledSize(scaledSize);
+            QImage preview = reader.read();
+            if (!preview.isNull() && generation == m_generation) {
+                // 缩放发生在方向变换之前，宽高比例相同，取宽度之比即可
+                preview.setDevicePixelRatio(static_cast<qreal>(scaledSize.width()) / fullSize.width());
+                QMetaObject::invokeMethod(this, [this, generation, preview]() {
+                    deliverPreview(generation, preview);
+                }, Qt::QueuedConnection);
+            }
+        }
+    }
+    
+    if (generation != m_generation) {
+        return QImage();
+    }
+    
+    // 第二阶段：完整解码。EXIF 方向只作为元数据返回，不在此旋转整图
+    QImageReader reader(fileName);
+    reader.setAutoTransform(false);
+    *transformation = reader.transformation();
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        const QString errorString = reader.errorString();
+        QMetaObject::invokeMethod(this, [this, generation, errorString]() {
+            deliverFailure(generation, errorString);
+        }, Qt::QueuedConnection);
+    }
+    return image;
+}
+
+void ImageLoader::deliverPreview(int generation, const QImage &preview)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    m_firstPixelMs = m_timer.elapsed();
+    emit previewReady(m_fileName, preview);
+}
+
+void ImageLoader::deliverImage(int generation, const OrientedImage &image)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    const qint64 fullImageMs = m_timer.elapsed();
+    if (m_firstPixelMs < 0) {
+        m_firstPixelMs = fullImageMs;
+    }
+    m_loading = false;
+    emit imageReady(m_fileName, image, m_firstPixelMs, fullImageMs);
+}
+
+void ImageLoader::deliverFailure(int generation, const QString &errorString)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    m_loading = false;
+    emit loadFailed(m_fileName, errorString);
+}
@@ -0,0 +1,69 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QImageIOHandler>
+#include <atomic>
+#include "orientedimage.h"
+
+// 异步图像加载
+// 在工作线程中解码，界面线程不再因大图卡顿。支持解码时缩放的格式
+// （如 JPEG 的 DCT 缩放）先解出视口大小的预览，再解码完整图像。
+// 预览通过 devicePixelRatio 标记其相对完整图像的缩放比例。
+// 未压缩的 PPM/PAM、BMP 与 TIFF 经 MappedImage 直接映射，跳过解码与预览。
+// 完整图像保持存储方向，EXIF 方向随 OrientedImage 携带，不做整图旋转
+class ImageLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageLoader(QObject *parent = nullptr);
+    ~ImageLoader() override;
+    
+    // 开始加载；尚未完成的上一次加载结果将被丢弃。
+    // previewSize 为预览的目标尺寸（物理像素），无效时不生成预览
+    void load(const QString &fileName, const QSize &previewSize);
+    void cancel();
+    
+    bool isLoading() const { return m_loading; }
+    QString fileName() const { return m_fileName; }
+
+signals:
+    void previewReady(const QString &fileName, const QImage &preview);
+    // firstPixelMs 为首次可显示内容的耗时，fullImageMs 为完整图像的耗时
+    void imageReady(const QString &fileName, const OrientedImage &image,
+                    qint64 firstPixelMs, qint64 fullImageMs);
+    void loadFailed(const QString &fileName, const QString &errorString);
+
+private:
+    // 在工作线程中执行
+    void decode(int generation, const QString &fileName, const QSize &previewSize);
+    // 经 QImageReader 解码，可先投递预览；失败时投递错误并返回空图像。
+    // 返回存储方向的图像，transformation 为其 EXIF 方向
+    QImage decodeWithReader(int generation, const QString &fileName, const QSize &previewSize,
+                            QImageIOHandler::Transformations *transformation);
+    
+    // 在界面线程中执行，过期的结果直接丢弃
+    void deliverPreview(int generation, const QImage &preview);
+    void deliverImage(int generation, const OrientedImage &image);
+    void deliverFailure(int generation, const QString &errorString);
+    
+    // 单线程池：新的加载请求会移除排队中的旧请求
+    QThreadPool m_pool;
+    std::atomic<int> m_generation;
+    
+    bool m_loading;
+    QString m_fileName;
+    QElapsedTimer m_timer;
+    qint64 m_firstPixelMs;
+    
+    // 完整图像比预览大出该倍数时才值得先解码预览
+    static constexpr double MIN_PREVIEW_REDUCTION = 2.0;
+};
+
+#endif // IMAGELOADER_H
@@ -1,11 +1,150 @@
 #include "imageprocessor.h"
+#include "fillkernels.h"
+#include "patchmatchfill.h"
+#include "poissonseam.h"
+#include "distancetransform.h"
+#include "colorspace.h"
+#include "parallelfor.h"
 #include <QApplication>
 #include <QDebug>
 #include <QMutexLocker>
 #include <QtAlgorithms>
 #include <QHash>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <cmath>
+#include <vector>
+
+namespace {
+
+// 按整数权重混合两个像素：weight 为 edge 所占比例（0..GradientProfile::WEIGHT_ONE）
+// R/B 与 A/G 各打包为两个 16 位通道一次计算
+inline QRgb mixPixels(QRgb background, QRgb edge, int weight)
+{
+    const quint32 w = static_cast<quint32>(weight);
+    const quint32 inv = GradientProfile::WEIGHT_ONE - w;
+    const quint32 rb = (((background & 0x00ff00ffu) * inv + (edge & 0x00ff00ffu) * w)
+                        >> GradientProfile::WEIGHT_SHIFT) & 0x00ff00ffu;
+    const quint32 ag = (((background >> 8) & 0x00ff00ffu) * inv + ((edge >> 8) & 0x00ff00ffu) * w)
+                       & 0xff00ff00u;
+    return rb | ag;
+}
+
+// 直接在 sRGB 编码值上混合
+struct SrgbMixer {
+    QRgb operator()(QRgb background, QRgb edge, int weight) const
+    {
+        return mixPixels(background, edge, weight);
+    }
+};
+
+// 线性光混合：颜色通道查表转为 16 位线性值后插值，再查 4096 项表转回 sRGB；
+// alpha 本身是线性量，直接插值
+struct LinearLightMixer {
+    const quint16 *toLinear;
+    const quint8 *toSrgb;
+    
+    LinearLightMixer()
+        : toLinear(ColorSpace::srgbToLinearTable())
+        , toSrgb(ColorSpace::linearToSrgbTable())
+    {
+    }
+    
+    inline quint32 channel(quint32 background, quint32 edge, quint32 w, quint32 inv) const
+    {
+        const quint32 linear = (toLinear[background] * inv + toLinear[edge] * w)
+                               >> GradientProfile::WEIGHT_SHIFT;
+        return toSrgb[linear >> (16 - ColorSpace::LINEAR_TO_SRGB_BITS)];
+    }
+    
+    QRgb operator()(QRgb background, QRgb edge, int weight) const
+    {
+        const quint32 w = static_cast<quint32>(weight);
+        const quint32 inv = GradientProfile::WEIGHT_ONE - w;
+        const quint32 r = channel(qRed(background), qRed(edge), w, inv);
+        const quint32 g = channel(qGreen(background), qGreen(edge), w, inv);
+        const quint32 b = channel(qBlue(background), qBlue(edge), w, inv);
+        const quint32 a = (qAlpha(background) * inv + qAlpha(edge) * w) >> GradientProfile::WEIGHT_SHIFT;
+        return (a << 24) | (r << 16) | (g << 8) | b;
+    }
+};
+
+// 各边的过渡距离
+struct FeatherSides {
+    int top;
+    int bottom;
+    int left;
+    int right;
+};
+
+// 距离变换条带：domain 为参与变换的区域（含源图特征像素），output 为要写入的边距区域
+struct FeatherStrip {
+    QRect domain;
+    QRect output;
+};
+
+// 按到源图的真实欧氏距离混合条带内的边距像素（角落同样按径向过渡）
+// 过渡距离按离最近源图像素的方向在水平/垂直两侧之间加权，查表得到权重；
+// 逐像素只有查表与选择运算，没有分支；混合方式由 Mixer 在编译期选定
+template <typename Mixer>
+void featherStrip(QRgb *pixels, ptrdiff_t stride, bool alphaMask, const QRect &sourceRect,
+                  const FeatherStrip &strip, const FeatherSides &sides, const int *weights,
+                  const Mixer &mix)
+{
+    const QRect &domain = strip.domain;
+    const int width = domain.width();
+    const int height = domain.height();
+    
+    // 特征像素：源图中不完全透明的像素（不透明图像即整个源图矩形）
+    const QRect features = domain.intersected(sourceRect);
+    std::vector<uchar> mask(static_cast<size_t>(width) * height, 0);
+    for (int y = features.top(); y <= features.bottom(); ++y) {
+        const QRgb *line = pixels + y * stride;
+        uchar *maskRow = mask.data() + static_cast<size_t>(y - domain.top()) * width;
+        for (int x = features.left(); x <= features.right(); ++x) {
+            maskRow[x - domain.left()] = !alphaMask || qAlpha(line[x]) != 0;
+        }
+    }
+    
+    std::vector<qint32> squaredDistance;
+    std::vector<qint32> nearest;
+    DistanceTransform::compute(mask, width, height, squaredDistance, nearest);
+    
+    // 下标 [0] 为最近源图像素在右/下方（即位于左/上边距），[1] 为在左/上方
+    const float horizontal[2] = {static_cast<float>(sides.left), static_cast<float>(sides.right)};
+    const float vertical[2] = {static_cast<float>(sides.top), static_cast<float>(sides.bottom)};
+    const float lutSize = static_cast<float>(GradientProfile::LUT_SIZE);
+    
+    const QRect &output = strip.output;
+    for (int y = output.top(); y <= output.bottom(); ++y) {
+        QRgb *line = pixels + y * stride;
+        const int localY = y - domain.top();
+        const size_t rowOffset = static_cast<size_t>(localY) * width;
+        for (int x = output.left(); x <= output.right(); ++x) {
+            const int localX = x - domain.left();
+            const size_t index = rowOffset + localX;
+            
+            // 无特征像素时距离为极大值，权重查表结果为 0，颜色任取
+            const qint32 feature = qMax(nearest[index], 0);
+            const int featureX = feature % width;
+            const int featureY = feature / width;
+            const int dx = localX - featureX;
+            const int dy = localY - featureY;
+            const float ax = static_cast<float>(qAbs(dx));
+            const float ay = static_cast<float>(qAbs(dy));
+            
+            const float reach = ax * horizontal[dx > 0] + ay * vertical[dy > 0];
+            const float distance = std::sqrt(static_cast<float>(squaredDistance[index])) - 1.0f;
+            const float t = distance * (ax + ay) * lutSize / qMax(reach, 1e-6f) + 1e-3f;
+            const int weight = weights[static_cast<int>(qMin(t, lutSize))];
+            
+            const QRgb edge = pixels[(domain.top() + featureY) * stride + domain.left() + featureX];
+            line[x] = mix(line[x], edge, weight);
+        }
+    }
+}
+
+} // namespace
 
 ImageProcessor::ImageProcessor(QObject *parent)
     : QObject(parent)
@@ -17,10 +156,25 @@ ImageProcessor::ImageProcessor(QObject *parent)
     , m_currentBottomExpansion(0)
     , m_currentLeftExpansion(0)
     , m_currentRightExpansion(0)
-    , m_blendDistance(DEFAULT_BLEND_DISTANCE)
+    , m_schedulerPolicy(defaultSchedulerPolicy())
+    , m_currentProxyScale(1.0)
+    , m_costPerPixelNs(DEFAULT_COST_PER_PIXEL_NS)
+    , m_canvasConstraints(defaultCanvasConstraints())
+    , m_resampleFilter(Resampler::Lanczos3)
+    , m_resultCache(DEFAULT_CACHE_LIMIT_MB * 1024)
+    , m_fillMode(SolidFill)
+    , m_colorFieldSegments(DEFAULT_COLOR_FIELD_SEGMENTS)
+    , m_seamMode(GradientSeam)
+    , m_seamBandWidth(DEFAULT_SEAM_BAND_WIDTH)
     , m_enableGradient(true)
-    , m_gradientStrength(DEFAULT_GRADIENT_STRENGTH)
+    , m_linearLightBlending(false)
 {
+    m_blendDistances.top = DEFAULT_BLEND_DISTANCE;
+    m_blendDistances.bottom = DEFAULT_BLEND_DISTANCE;
+    m_blendDistances.left = DEFAULT_BLEND_DISTANCE;
+    m_blendDistances.right = DEFAULT_BLEND_DISTANCE;
+    m_gradientProfile.setStrength(DEFAULT_GRADIENT_STRENGTH);
+    
     // 设置单次触发定时器，用于延迟处理
     m_processTimer->setSingleShot(true);
     m_processTimer->setInterval(PROGRESS_UPDATE_INTERVAL);
@@ -32,7 +186,7 @@ ImageProcessor::~ImageProcessor()
     cancelProcessing();
 }
 
-void ImageProcessor::expandBackground(const QImage &originalImage,
+void ImageProcessor::expandBackground(const OrientedImage &originalImage,
                                     const QColor &backgroundColor,
                                     int topExpansion,
                                     int bottomExpansion, 
@@ -43,16 +197,24 @@ void ImageProcessor::expandBackground(const QImage &originalImage,
         return;
     }
     
+    // 命中结果缓存时直接返回，无需重新处理
+    const CacheKey key = makeCacheKey(originalImage, backgroundColor,
+                                      topExpansion, bottomExpansion,
+                                      leftExpansion, rightExpansion);
+    if (const QImage *cached = m_resultCache.object(key)) {
+        m_processTimer->stop();
+        emit progressChanged(100);
+        emit imageProcessed(*cached);
+        return;
+    }
+    
     // 如果参数没有变化且正在处理，则不重复处理
     QMutexLocker locker(&m_processMutex);
     
     if (m_processing && 
-        m_currentOriginalImage == originalImage &&
-        m_currentBackgroundColor == backgroundColor &&
-        m_currentTopExpansion == topExpansion &&
-        m_currentBottomExpansion == bottomExpansion &&
-        m_currentLeftExpansion == leftExpansion &&
-        m_currentRightExpansion == rightExpansion) {
+        makeCacheKey(m_currentOriginalImage, m_currentBackgroundColor,
+                     m_currentTopExpansion, m_currentBottomExpansion,
+                     m_currentLeftExpansion, m_currentRightExpansion) == key) {
         return;
     }
     
@@ -64,9 +226,32 @@ void ImageProcessor::expandBackground(const QImage &originalImage,
     m_currentLeftExpansion = leftExpansion;
     m_currentRightExpansion = rightExpansion;
     
-    // 重启定时器进行延迟处理（避免频繁处理）
+    // 根据近期测得的处理耗时决定调度方式：
+    // 能在一帧预算内完成的立即处理；否则合并连续请求，必要时先生成代理预览
+    const bool scaledOutput = m_outputSize.isValid() && !m_outputSize.isEmpty();
+    const qint64 outputPixels = scaledOutput
+        ? static_cast<qint64>(m_outputSize.width()) * m_outputSize.height()
+        : static_cast<qint64>(originalImage.width() + leftExpansion + rightExpansion) *
+          (originalImage.height() + topExpansion + bottomExpansion);
+    double estimateMs = estimateProcessingCost(outputPixels);
+    
+    // 固定输出尺寸时结果本身已受限，不再生成代理预览
+    m_currentProxyScale = 1.0;
+    if (m_schedulerPolicy.allowProxy && !scaledOutput &&
+        estimateMs > m_schedulerPolicy.targetLatencyMs) {
+        m_currentProxyScale = qBound(MIN_PROXY_SCALE,
+                                     std::sqrt(m_schedulerPolicy.targetLatencyMs / estimateMs),
+                                     1.0);
+        estimateMs *= m_currentProxyScale * m_currentProxyScale;
+    }
+    
+    int delay = 0;
+    if (estimateMs > m_schedulerPolicy.frameBudgetMs) {
+        delay = qMin(m_schedulerPolicy.maxCoalesceMs, static_cast<int>(estimateMs));
+    }
+    
     m_processTimer->stop();
-    m_processTimer->start();
+    m_processTimer->start(delay);
 }
 
 void ImageProcessor::processInBackground()
@@ -85,38 +270,58 @@ void ImageProcessor::processInBackground()
     emit progressChanged(0);
     
     try {
+        // 代理预览：在缩小的源图上处理，结果通过 devicePixelRatio 标记实际尺寸
+        const double proxyScale = m_currentProxyScale;
+        const bool proxy = proxyScale < 1.0;
+        
+        OrientedImage source = m_currentOriginalImage;
+        int top = m_currentTopExpansion;
+        int bottom = m_currentBottomExpansion;
+        int left = m_currentLeftExpansion;
+        int right = m_currentRightExpansion;
+        
+        if (proxy) {
+            source = m_currentOriginalImage.scaled(
+                QSize(qMax(1, qRound(m_currentOriginalImage.width() * proxyScale)),
+                      qMax(1, qRound(m_currentOriginalImage.height() * proxyScale))),
+                Qt::FastTransformation);
+            top = qRound(top * proxyScale);
+            bottom = qRound(bottom * proxyScale);
+            left = qRound(left * proxyScale);
+            right = qRound(right * proxyScale);
+        }
+        
+        QElapsedTimer timer;
+        timer.start();
+        
         // 执行图像处理
-        QImage result = createExpandedImage(
-            m_currentOriginalImage,
-            m_currentBackgroundColor,
-            m_currentTopExpansion,
-            m_currentBottomExpansion,
-            m_currentLeftExpansion,
-            m_currentRightExpansion
-        );
+        QImage result = renderExpansion(source, m_currentBackgroundColor,
+                                        top, bottom, left, right, m_outputSize);
         
         if (!m_cancelRequested && !result.isNull()) {
-            // 应用渐变混合（如果启用）
-            if (m_enableGradient && 
-                (m_currentTopExpansion > 0 || m_currentBottomExpansion > 0 || 
-                 m_currentLeftExpansion > 0 || m_currentRightExpansion > 0)) {
-                
-                emit progressChanged(70);
-                if (!m_cancelRequested) {
-                    result = applyGradientBlending(
-                        result,
-                        m_currentOriginalImage,
-                        m_currentTopExpansion,
-                        m_currentBottomExpansion,
-                        m_currentLeftExpansion,
-                        m_currentRightExpansion
-                    );
-                }
-            }
+            recordProcessingCost(static_cast<qint64>(result.width()) * result.height(),
+                                 timer.nsecsElapsed());
             
             emit progressChanged(100);
             
-            if (!m_cancelRequested) {
+            if (!m_cancelRequested && proxy) {
+                const int fullWidth = m_currentOriginalImage.width() +
+                                      m_currentLeftExpansion + m_currentRightExpansion;
+                result.setDevicePixelRatio(static_cast<double>(result.width()) / fullWidth);
+                emit imageProcessed(result);
+                
+                // 空闲后再生成全分辨率结果
+                m_currentProxyScale = 1.0;
+                m_processTimer->start(m_schedulerPolicy.maxCoalesceMs);
+            } else if (!m_cancelRequested) {
+                const CacheKey key = makeCacheKey(m_currentOriginalImage,
+                                                  m_currentBackgroundColor,
+                                                  m_currentTopExpansion,
+                                                  m_currentBottomExpansion,
+                                                  m_currentLeftExpansion,
+                                                  m_currentRightExpansion);
+                const int cost = static_cast<int>(qMax<qint64>(1, result.sizeInBytes() / 1024));
+                m_resultCache.insert(key, new QImage(result), cost);
                 emit imageProcessed(result);
             }
         }
@@ -132,7 +337,107 @@ void ImageProcessor::processInBackground()
     emit processingFinished();
 }
 
-QImage ImageProcessor::createExpandedImage(const QImage &originalImage,
+QImage ImageProcessor::renderExpansion(const OrientedImage &originalImage,
+                                       const QColor &backgroundColor,
+                                       int topExpansion,
+                                       int bottomExpansion,
+                                       int leftExpansion,
+                                       int rightExpansion,
+                                       const QSize &outputSize) const
+{
+    const int fullWidth = originalImage.width() + leftExpansion + rightExpansion;
+    const int fullHeight = originalImage.height() + topExpansion + bottomExpansion;
+    if (!outputSize.isValid() || outputSize.isEmpty() ||
+        outputSize == QSize(fullWidth, fullHeight) || originalImage.isNull()) {
+        return renderCanvas(originalImage, backgroundColor,
+                            topExpansion, bottomExpansion, leftExpansion, rightExpansion,
+                            1.0, 1.0);
+    }
+    
+    // 源图按统一比例缩放，不随输出宽高比变形：取两个方向中较小的缩放比例，
+    // 输出比例与扩展后的画布不同时，多出的空间按原有两侧边距的比例分给边距（无边距时居中）
+    const double scale = qMin(static_cast<double>(outputSize.width()) / fullWidth,
+                              static_cast<double>(outputSize.height()) / fullHeight);
+    const int placedWidth = qBound(1, qRound(originalImage.width() * scale), outputSize.width());
+    const int placedHeight = qBound(1, qRound(originalImage.height() * scale), outputSize.height());
+    const auto leading = [](int space, int before, int after) {
+        return before + after > 0 ? qRound(static_cast<double>(space) * before / (before + after))
+                                  : space / 2;
+    };
+    const int placedLeft = leading(outputSize.width() - placedWidth, leftExpansion, rightExpansion);
+    const int placedTop = leading(outputSize.height() - placedHeight, topExpansion, bottomExpansion);
+    
+    // 只对源图重采样，边距直接在输出分辨率上生成；带方向的源图在存储方向上重采样
+    const OrientedImage placed = originalImage.resized(QSize(placedWidth, placedHeight),
+                                                       m_resampleFilter);
+    if (m_cancelRequested) {
+        return QImage();
+    }
+    
+    return renderCanvas(placed, backgroundColor,
+                        placedTop, outputSize.height() - placedTop - placedHeight,
+                        placedLeft, outputSize.width() - placedLeft - placedWidth,
+                        scale, scale);
+}
+
+QImage ImageProcessor::renderCanvas(const OrientedImage &originalImage,
+                                    const QColor &backgroundColor,
+                                    int topExpansion,
+                                    int bottomExpansion,
+                                    int leftExpansion,
+                                    int rightExpansion,
+                                    double scaleX,
+                                    double scaleY) const
+{
+    QImage result = createExpandedImage(originalImage, backgroundColor,
+                                        topExpansion, bottomExpansion,
+                                        leftExpansion, rightExpansion);
+    if (m_cancelRequested || result.isNull()) {
+        return result;
+    }
+    
+    const QRect sourceRect(leftExpansion, topExpansion, originalImage.width(), originalImage.height());
+    if (!applySeam(result, sourceRect, scaleX, scaleY)) {
+        return QImage();
+    }
+    return result;
+}
+
+bool ImageProcessor::renderInPlace(QImage &canvas, const QRect &sourceRect,
+                                   const QColor &backgroundColor) const
+{
+    if (canvas.isNull() || sourceRect.isEmpty() || !canvas.rect().contains(sourceRect) ||
+        (canvas.format() != QImage::Format_ARGB32 && canvas.format() != QImage::Format_RGB32)) {
+        return false;
+    }
+    fillMargins(canvas, sourceRect, backgroundColor);
+    if (m_cancelRequested) {
+        return false;
+    }
+    return applySeam(canvas, sourceRect, 1.0, 1.0);
+}
+
+bool ImageProcessor::applySeam(QImage &canvas, const QRect &sourceRect,
+                               double scaleX, double scaleY) const
+{
+    const bool expanded = sourceRect != canvas.rect();
+    if (m_seamMode == PoissonSeam && expanded) {
+        // 泊松无缝融合（适用于所有填充方式）
+        updateProgress(70, 100);
+        if (!PoissonSeamBlend::blend(canvas, sourceRect,
+                                     qMax(1, qRound(m_seamBandWidth * qMin(scaleX, scaleY))))) {
+            // 不输出未收敛的近似解；信号可从其他线程发出，连接方按队列接收
+            emit const_cast<ImageProcessor*>(this)->errorOccurred("泊松接缝融合未能在迭代上限内收敛");
+            return false;
+        }
+    } else if (m_enableGradient && m_fillMode == SolidFill && expanded) {
+        // 应用渐变混合（如果启用，仅对纯色填充有意义）
+        return applyGradientBlending(canvas, sourceRect, scaleX, scaleY);
+    }
+    return true;
+}
+
+QImage ImageProcessor::createExpandedImage(const OrientedImage &originalImage,
                                           const QColor &backgroundColor,
                                           int topExpansion,
                                           int bottomExpansion,
@@ -153,7 +458,6 @@ QImage ImageProcessor::createExpandedImage(const QImage &originalImage,
     
     // 创建新图像
     QImage expandedImage(newWidth, newHeight, QImage::Format_ARGB32);
-    expandedImage.fill(backgroundColor);
     
     updateProgress(10, 100);
     if (m_cancelRequested) return QImage();
@@ -162,173 +466,164 @@ QImage ImageProcessor::createExpandedImage(const QImage &originalImage,
     int offsetX = leftExpansion;
     int offsetY = topExpansion;
     
-    // 复制原始图像到新图像中心
-    for (int y = 0; y < originalImage.height(); ++y) {
-        if (m_cancelRequested) return QImage();
-        
-        const QRgb *sourceLine = reinterpret_cast<const QRgb*>(originalImage.constScanLine(y));
-        QRgb *destLine = reinterpret_cast<QRgb*>(expandedImage.scanLine(y + offsetY));
-        
-        for (int x = 0; x < originalImage.width(); ++x) {
-            destLine[x + offsetX] = sourceLine[x];
-        }
-        
-        // 更新进度（10% - 60%）
-        if (y % 10 == 0) {
-            updateProgress(10 + (50 * y) / originalImage.height(), 100);
-        }
-    }
+    // 复制原始图像到新图像中心；EXIF 方向在这一遍拷贝中完成，不生成旋转后的中间图像
+    originalImage.copyTo(expandedImage, QPoint(offsetX, offsetY));
+    updateProgress(50, 100);
+    if (m_cancelRequested) return QImage();
+    
+    // 填充四周边距
+    fillMargins(expandedImage, QRect(offsetX, offsetY, originalImage.width(), originalImage.height()),
+                backgroundColor);
     
     updateProgress(60, 100);
     return expandedImage;
 }
 
-QImage ImageProcessor::applyGradientBlending(const QImage &expandedImage,
-                                           const QImage &originalImage,
-                                           int topExpansion,
-                                           int bottomExpansion,
-                                           int leftExpansion,
-                                           int rightExpansion) const
+void ImageProcessor::fillMargins(QImage &canvas, const QRect &sourceRect,
+                                 const QColor &backgroundColor) const
+{
+    switch (m_fillMode) {
+    case EdgeStretchFill:
+        FillKernels::fillEdgeStretch(canvas, sourceRect);
+        break;
+    case ReflectFill:
+        FillKernels::fillPadded(canvas, sourceRect, FillKernels::PadReflect);
+        break;
+    case Reflect101Fill:
+        FillKernels::fillPadded(canvas, sourceRect, FillKernels::PadReflect101);
+        break;
+    case WrapFill:
+        FillKernels::fillPadded(canvas, sourceRect, FillKernels::PadWrap);
+        break;
+    case BlurredEdgeFill:
+        FillKernels::fillBlurredEdge(canvas, sourceRect);
+        break;
+    case ContentAwareFill:
+        // 源图过小无法取补丁时退回模糊延伸
+        if (!PatchMatchFill::fill(canvas, sourceRect)) {
+            FillKernels::fillBlurredEdge(canvas, sourceRect);
+        }
+        break;
+    case ColorFieldFill:
+        FillKernels::fillColorField(canvas, sourceRect, m_colorFieldSegments);
+        break;
+    case SolidFill:
+    default:
+        FillKernels::fillSolid(canvas, sourceRect, backgroundColor.rgba());
+        break;
+    }
+}
+
+bool ImageProcessor::applyGradientBlending(QImage &result, const QRect &sourceRect,
+                                          double scaleX, double scaleY) const
 {
-    if (expandedImage.isNull() || originalImage.isNull()) {
-        return expandedImage;
+    if (result.isNull() || sourceRect.isEmpty()) {
+        return true;
     }
     
-    QImage result = expandedImage;
-    int blendDist = qMin(m_blendDistance, 
-                        qMin(qMin(topExpansion, bottomExpansion), 
-                             qMin(leftExpansion, rightExpansion)));
-    
-    if (blendDist <= 0) {
-        return result;
+    const int topExpansion = sourceRect.top();
+    const int bottomExpansion = result.height() - sourceRect.bottom() - 1;
+    const int leftExpansion = sourceRect.left();
+    const int rightExpansion = result.width() - sourceRect.right() - 1;
+    
+    // 各边过渡带不超过该边的扩展量，互不影响
+    FeatherSides sides;
+    sides.top = qMin(qRound(m_blendDistances.top * scaleY), topExpansion);
+    sides.bottom = qMin(qRound(m_blendDistances.bottom * scaleY), bottomExpansion);
+    sides.left = qMin(qRound(m_blendDistances.left * scaleX), leftExpansion);
+    sides.right = qMin(qRound(m_blendDistances.right * scaleX), rightExpansion);
+    const int reach = qMax(qMax(sides.top, sides.bottom), qMax(sides.left, sides.right));
+    if (reach <= 0) {
+        return true;
     }
     
-    // 获取原始图像在扩展图像中的区域
-    QRect originalRect(leftExpansion, topExpansion, 
-                      originalImage.width(), originalImage.height());
-    
     updateProgress(70, 100);
-    if (m_cancelRequested) return QImage();
-    
-    // 对每个扩展区域应用渐变
-    const QColor bgColor = QColor(expandedImage.pixel(0, 0));
-    
-    // 顶部渐变
-    if (topExpansion > 0) {
-        for (int y = 0; y < qMin(topExpansion, blendDist); ++y) {
-            if (m_cancelRequested) return QImage();
-            
-            double factor = static_cast<double>(y) / blendDist;
-            factor = calculateBlendFactor(y, blendDist);
-            
-            QRgb *line = reinterpret_cast<QRgb*>(result.scanLine(topExpansion - 1 - y));
-            const QRgb *edgeLine = reinterpret_cast<const QRgb*>(originalImage.constScanLine(0));
-            
-            for (int x = leftExpansion; x < leftExpansion + originalImage.width(); ++x) {
-                QColor edgeColor(edgeLine[x - leftExpansion]);
-                QColor blendedColor = blendColors(bgColor, edgeColor, factor);
-                line[x] = blendedColor.rgba();
-            }
-        }
+    if (m_cancelRequested) return false;
+    
+    // 离源图 reach 以内的边距像素，其 reach 以内的源图像素必然落在同侧的
+    // 条带里，因此只需对四个条带分别做距离变换，而不必覆盖整个源图
+    const int left = sourceRect.left();
+    const int top = sourceRect.top();
+    const int right = sourceRect.right() + 1;
+    const int bottom = sourceRect.bottom() + 1;
+    const int domainLeft = qMax(0, left - reach);
+    const int domainTop = qMax(0, top - reach);
+    const int domainRight = qMin(result.width(), right + reach);
+    const int domainBottom = qMin(result.height(), bottom + reach);
+    
+    FeatherStrip strips[4];
+    int stripCount = 0;
+    if (top > domainTop) {
+        strips[stripCount++] = FeatherStrip{
+            QRect(QPoint(domainLeft, domainTop), QPoint(domainRight - 1, qMin(top + reach, bottom) - 1)),
+            QRect(QPoint(domainLeft, domainTop), QPoint(domainRight - 1, top - 1))};
     }
-    
-    updateProgress(80, 100);
-    if (m_cancelRequested) return QImage();
-    
-    // 底部渐变
-    if (bottomExpansion > 0) {
-        int bottomStart = topExpansion + originalImage.height();
-        for (int y = 0; y < qMin(bottomExpansion, blendDist); ++y) {
-            if (m_cancelRequested) return QImage();
-            
-            double factor = static_cast<double>(y) / blendDist;
-            factor = calculateBlendFactor(y, blendDist);
-            
-            QRgb *line = reinterpret_cast<QRgb*>(result.scanLine(bottomStart + y));
-            const QRgb *edgeLine = reinterpret_cast<const QRgb*>(
-                originalImage.constScanLine(originalImage.height() - 1));
-            
-            for (int x = leftExpansion; x < leftExpansion + originalImage.width(); ++x) {
-                QColor edgeColor(edgeLine[x - leftExpansion]);
-                QColor blendedColor = blendColors(bgColor, edgeColor, factor);
-                line[x] = blendedColor.rgba();
-            }
-        }
+    if (domainBottom > bottom) {
+        strips[stripCount++] = FeatherStrip{
+            QRect(QPoint(domainLeft, qMax(bottom - reach, top)), QPoint(domainRight - 1, domainBottom - 1)),
+            QRect(QPoint(domainLeft, bottom), QPoint(domainRight - 1, domainBottom - 1))};
     }
-    
-    updateProgress(90, 100);
-    if (m_cancelRequested) return QImage();
-    
-    // 左侧渐变
-    if (leftExpansion > 0) {
-        for (int x = 0; x < qMin(leftExpansion, blendDist); ++x) {
-            if (m_cancelRequested) return QImage();
-            
-            double factor = static_cast<double>(x) / blendDist;
-            factor = calculateBlendFactor(x, blendDist);
-            
-            for (int y = topExpansion; y < topExpansion + originalImage.height(); ++y) {
-                QRgb *pixel = reinterpret_cast<QRgb*>(result.scanLine(y));
-                QColor edgeColor(originalImage.pixel(0, y - topExpansion));
-                QColor blendedColor = blendColors(bgColor, edgeColor, factor);
-                pixel[leftExpansion - 1 - x] = blendedColor.rgba();
-            }
-        }
+    if (left > domainLeft) {
+        strips[stripCount++] = FeatherStrip{
+            QRect(QPoint(domainLeft, top), QPoint(qMin(left + reach, right) - 1, bottom - 1)),
+            QRect(QPoint(domainLeft, top), QPoint(left - 1, bottom - 1))};
+    }
+    if (domainRight > right) {
+        strips[stripCount++] = FeatherStrip{
+            QRect(QPoint(qMax(right - reach, left), top), QPoint(domainRight - 1, bottom - 1)),
+            QRect(QPoint(right, top), QPoint(domainRight - 1, bottom - 1))};
     }
     
-    // 右侧渐变
-    if (rightExpansion > 0) {
-        int rightStart = leftExpansion + originalImage.width();
-        for (int x = 0; x < qMin(rightExpansion, blendDist); ++x) {
-            if (m_cancelRequested) return QImage();
-            
-            double factor = static_cast<double>(x) / blendDist;
-            factor = calculateBlendFactor(x, blendDist);
-            
-            for (int y = topExpansion; y < topExpansion + originalImage.height(); ++y) {
-                QRgb *pixel = reinterpret_cast<QRgb*>(result.scanLine(y));
-                QColor edgeColor(originalImage.pixel(originalImage.width() - 1, y - topExpansion));
-                QColor blendedColor = blendColors(bgColor, edgeColor, factor);
-                pixel[rightStart + x] = blendedColor.rgba();
-            }
+    // 各条带的输出区域互不重叠，且只读取源图区域，可以并行
+    const int *weights = m_gradientProfile.weights();
+    QRgb *pixels = reinterpret_cast<QRgb*>(result.bits());
+    const ptrdiff_t stride = result.bytesPerLine() / static_cast<int>(sizeof(QRgb));
+    const bool alphaMask = result.hasAlphaChannel();
+    const bool linearLight = m_linearLightBlending;
+    parallelFor(stripCount, [&](int i) {
+        if (linearLight) {
+            featherStrip(pixels, stride, alphaMask, sourceRect, strips[i], sides, weights,
+                         LinearLightMixer());
+        } else {
+            featherStrip(pixels, stride, alphaMask, sourceRect, strips[i], sides, weights,
+                         SrgbMixer());
         }
-    }
+    });
     
     updateProgress(95, 100);
-    return result;
+    return true;
 }
 
-QColor ImageProcessor::blendColors(const QColor &color1, const QColor &color2, double factor) const
+void ImageProcessor::setBlendDistances(const BlendDistances &distances)
 {
-    factor = qBound(0.0, factor, 1.0);
-    
-    int r = static_cast<int>(color1.red() * (1.0 - factor) + color2.red() * factor);
-    int g = static_cast<int>(color1.green() * (1.0 - factor) + color2.green() * factor);
-    int b = static_cast<int>(color1.blue() * (1.0 - factor) + color2.blue() * factor);
-    int a = static_cast<int>(color1.alpha() * (1.0 - factor) + color2.alpha() * factor);
-    
-    return QColor(r, g, b, a);
+    m_blendDistances.top = qMax(0, distances.top);
+    m_blendDistances.bottom = qMax(0, distances.bottom);
+    m_blendDistances.left = qMax(0, distances.left);
+    m_blendDistances.right = qMax(0, distances.right);
 }
 
-double ImageProcessor::calculateBlendFactor(int distance, int maxDistance) const
+void ImageProcessor::copyRenderSettings(const ImageProcessor &other)
 {
-    if (maxDistance <= 0) {
-        return 0.0;
-    }
-    
-    double normalizedDistance = static_cast<double>(distance) / maxDistance;
-    
-    // 使用平滑步函数创建更自然的渐变
-    double factor = normalizedDistance * normalizedDistance * (3.0 - 2.0 * normalizedDistance);
-    
-    // 应用渐变强度
-    factor *= m_gradientStrength;
-    
-    return qBound(0.0, factor, 1.0);
+    m_canvasConstraints = other.m_canvasConstraints;
+    m_outputSize = other.m_outputSize;
+    m_resampleFilter = other.m_resampleFilter;
+    m_fillMode = other.m_fillMode;
+    m_colorFieldSegments = other.m_colorFieldSegments;
+    m_seamMode = other.m_seamMode;
+    m_seamBandWidth = other.m_seamBandWidth;
+    m_blendDistances = other.m_blendDistances;
+    m_enableGradient = other.m_enableGradient;
+    m_linearLightBlending = other.m_linearLightBlending;
+    m_gradientProfile = other.m_gradientProfile;
 }
 
 void ImageProcessor::updateProgress(int current, int total) const
 {
+    // 在其他线程中渲染（如批量导出）时不报告预览进度
+    if (QThread::currentThread() != thread()) {
+        return;
+    }
+    
     if (total > 0) {
         int percentage = (current * 100) / total;
         // 由于这是const函数，我们需要通过const_cast来发射信号
@@ -336,7 +631,7 @@ void ImageProcessor::updateProgress(int current, int total) const
     }
 }
 
-QColor ImageProcessor::getDominantColor(const QImage &image, const QRect &region) const
+QColor ImageProcessor::getDominantColor(const OrientedImage &image, const QRect &region) const
 {
     if (image.isNull()) {
         return QColor();
@@ -346,7 +641,7 @@ QColor ImageProcessor::getDominantColor(const QImage &image, const QRect &region
     return calculateDominantColor(pixels);
 }
 
-QColor ImageProcessor::getAverageColor(const QImage &image, const QRect &region) const
+QColor ImageProcessor::getAverageColor(const OrientedImage &image, const QRect &region) const
 {
     if (image.isNull()) {
         return QColor();
@@ -356,7 +651,7 @@ QColor ImageProcessor::getAverageColor(const QImage &image, const QRect &region)
     return calculateAverageColor(pixels);
 }
 
-QColor ImageProcessor::getEdgeColor(const QImage &image, Qt::Edge edge) const
+QColor ImageProcessor::getEdgeColor(const OrientedImage &image, Qt::Edge edge) const
 {
     if (image.isNull()) {
         return QColor();
@@ -388,16 +683,108 @@ void ImageProcessor::cancelProcessing()
     m_processTimer->stop();
 }
 
-QVector<QRgb> ImageProcessor::extractPixels(const QImage &image, const QRect &region) const
+ImageProcessor::SchedulerPolicy ImageProcessor::defaultSchedulerPolicy()
 {
-    QRect actualRegion = region.isValid() ? region : image.rect();
-    actualRegion = actualRegion.intersected(image.rect());
+    SchedulerPolicy policy;
+    policy.frameBudgetMs = 16;
+    policy.targetLatencyMs = 150;
+    policy.maxCoalesceMs = 300;
+    policy.allowProxy = true;
+    return policy;
+}
+
+ImageProcessor::CanvasConstraints ImageProcessor::defaultCanvasConstraints()
+{
+    CanvasConstraints constraints;
+    constraints.alignment = 1;
+    constraints.maxPixels = 0;
+    constraints.ratioTolerance = 0.01;
+    return constraints;
+}
+
+void ImageProcessor::finishPendingWork()
+{
+    if (!m_processTimer->isActive() && m_currentProxyScale >= 1.0) {
+        return;
+    }
+    
+    m_processTimer->stop();
+    m_currentProxyScale = 1.0;
+    processInBackground();
+}
+
+double ImageProcessor::estimateProcessingCost(qint64 outputPixels) const
+{
+    return m_costPerPixelNs * outputPixels / 1.0e6;
+}
+
+void ImageProcessor::recordProcessingCost(qint64 outputPixels, qint64 elapsedNs)
+{
+    if (outputPixels <= 0) {
+        return;
+    }
+    
+    const double sample = static_cast<double>(elapsedNs) / outputPixels;
+    m_costPerPixelNs = m_costPerPixelNs * (1.0 - COST_SMOOTHING) + sample * COST_SMOOTHING;
+}
+
+void ImageProcessor::setCacheLimit(int megabytes)
+{
+    m_resultCache.setMaxCost(qMax(0, megabytes) * 1024);
+}
+
+void ImageProcessor::clearCache()
+{
+    m_resultCache.clear();
+}
+
+ImageProcessor::CacheKey ImageProcessor::makeCacheKey(const OrientedImage &originalImage,
+                                                      const QColor &backgroundColor,
+                                                      int topExpansion,
+                                                      int bottomExpansion,
+                                                      int leftExpansion,
+                                                      int rightExpansion) const
+{
+    // cacheKey() 标识共享的图像数据，不需要逐像素比较
+    CacheKey key;
+    key.imageKey = originalImage.cacheKey();
+    key.color = backgroundColor.rgba();
+    key.top = topExpansion;
+    key.bottom = bottomExpansion;
+    key.left = leftExpansion;
+    key.right = rightExpansion;
+    key.outputWidth = m_outputSize.isValid() ? m_outputSize.width() : -1;
+    key.outputHeight = m_outputSize.isValid() ? m_outputSize.height() : -1;
+    key.resampleFilter = m_resampleFilter;
+    key.fillMode = m_fillMode;
+    key.colorFieldSegments = m_colorFieldSegments;
+    key.seamMode = m_seamMode;
+    key.seamBandWidth = m_seamBandWidth;
+    key.blendTop = m_blendDistances.top;
+    key.blendBottom = m_blendDistances.bottom;
+    key.blendLeft = m_blendDistances.left;
+    key.blendRight = m_blendDistances.right;
+    key.enableGradient = m_enableGradient;
+    key.linearLightBlending = m_linearLightBlending;
+    key.gradientFingerprint = m_gradientProfile.fingerprint();
+    return key;
+}
+
+QVector<QRgb> ImageProcessor::extractPixels(const OrientedImage &image, const QRect &region) const
+{
+    const QRect displayRect(QPoint(0, 0), image.size());
+    QRect actualRegion = region.isValid() ? region : displayRect;
+    actualRegion = actualRegion.intersected(displayRect);
+    
+    // 颜色统计与像素顺序无关，区域换算到存储坐标后直接按行读取
+    const QImage &stored = image.storedImage();
+    actualRegion = image.toStored(actualRegion);
     
     QVector<QRgb> pixels;
     pixels.reserve(actualRegion.width() * actualRegion.height());
     
     for (int y = actualRegion.top(); y <= actualRegion.bottom(); ++y) {
-        const QRgb *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        const QRgb *line = reinterpret_cast<const QRgb*>(stored.constScanLine(y));
         for (int x = actualRegion.left(); x <= actualRegion.right(); ++x) {
             pixels.append(line[x]);
         }
@@ -471,9 +858,17 @@ ImageProcessor::ExpansionValues ImageProcessor::calculateSmartExpansion(
     const QString &targetRatio,
     const QString &distribution) const
 {
-    ExpansionValues result = {0, 0, 0, 0, false, "", "", ""};
+    return calculateSmartExpansion(originalImage.size(), targetRatio, distribution);
+}
+
+ImageProcessor::ExpansionValues ImageProcessor::calculateSmartExpansion(
+    const QSize &originalSize,
+    const QString &targetRatio,
+    const QString &distribution) const
+{
+    ExpansionValues result = {0, 0, 0, 0, false, "", "", "", false, 0.0};
     
-    if (originalImage.isNull()) {
+    if (originalSize.isEmpty()) {
         result.errorMessage = "图像为空";
         return result;
     }
@@ -486,7 +881,7 @@ ImageProcessor::ExpansionValues ImageProcessor::calculateSmartExpansion(
     }
     
     // 计算最优扩展方案
-    result = calculateOptimalExpansion(originalImage.size(), ratio, distribution);
+    result = calculateOptimalExpansion(originalSize, ratio, distribution);
     
     return result;
 }
@@ -532,7 +927,11 @@ ImageProcessor::ExpansionValues ImageProcessor::calculateOptimalExpansion(
     const QPair<double, double> &ratio,
     const QString &distribution) const
 {
-    ExpansionValues result = {0, 0, 0, 0, false, "", "", ""};
+    if (m_canvasConstraints.alignment > 1 || m_canvasConstraints.maxPixels > 0) {
+        return calculateConstrainedExpansion(originalSize, ratio, distribution);
+    }
+    
+    ExpansionValues result = {0, 0, 0, 0, false, "", "", "", false, 0.0};
     
     // 计算两种方案：固定宽度和固定高度
     // 方案1：固定宽度，计算目标高度
@@ -549,6 +948,7 @@ ImageProcessor::ExpansionValues ImageProcessor::calculateOptimalExpansion(
     if (heightExpansion1 == 0 && widthExpansion2 == 0) {
         result.errorMessage = QString("图像当前尺寸(%1x%2)已满足或超过目标比例要求，无需扩展")
             .arg(originalSize.width()).arg(originalSize.height());
+        result.alreadySatisfied = true;
         return result;
     }
     
@@ -587,6 +987,104 @@ ImageProcessor::ExpansionValues ImageProcessor::calculateOptimalExpansion(
         result.bottom = 0;
     }
     
+    const double canvasWidth = originalSize.width() + result.left + result.right;
+    const double canvasHeight = originalSize.height() + result.top + result.bottom;
+    result.ratioError = qAbs(canvasWidth / canvasHeight / (ratio.first / ratio.second) - 1.0);
+    result.isValid = true;
+    return result;
+}
+
+ImageProcessor::ExpansionValues ImageProcessor::calculateConstrainedExpansion(
+    const QSize &originalSize,
+    const QPair<double, double> &ratio,
+    const QString &distribution) const
+{
+    ExpansionValues result = {0, 0, 0, 0, false, "", "", "", false, 0.0};
+    
+    const int alignment = qMax(1, m_canvasConstraints.alignment);
+    const qint64 maxPixels = m_canvasConstraints.maxPixels;
+    const double tolerance = qMax(0.0, m_canvasConstraints.ratioTolerance);
+    const double target = ratio.first / ratio.second;
+    const int width = originalSize.width();
+    const int height = originalSize.height();
+    
+    const auto alignUp = [alignment](double value) {
+        return static_cast<int>(std::ceil(value / alignment - 1e-9)) * alignment;
+    };
+    const auto alignNearest = [alignment](double value) {
+        return static_cast<int>(std::floor(value / alignment + 0.5)) * alignment;
+    };
+    const int minWidth = alignUp(width);
+    const int minHeight = alignUp(height);
+    
+    // 精确比例下容纳源图的最小画布，从它开始按对齐步长逐级放大，
+    // 另一边取最接近目标比例的对齐尺寸，取第一个误差在容许范围内的画布
+    const double exactWidth = qMax<double>(width, height * target);
+    const double exactHeight = exactWidth / target;
+    int canvasWidth = 0;
+    int canvasHeight = 0;
+    double bestError = -1.0;
+    bool exceedsLimit = false;
+    for (int step = 0; step <= CANVAS_SEARCH_STEPS && canvasWidth == 0; ++step) {
+        const int widths[2] = {alignUp(exactWidth) + step * alignment,
+                               qMax(minWidth, alignNearest((alignUp(exactHeight) + step * alignment) * target))};
+        const int heights[2] = {qMax(minHeight, alignNearest(widths[0] / target)),
+                                alignUp(exactHeight) + step * alignment};
+        for (int i = 0; i < 2; ++i) {
+            if (maxPixels > 0 && static_cast<qint64>(widths[i]) * heights[i] > maxPixels) {
+                exceedsLimit = true;
+                continue;
+            }
+            const double error = qAbs(static_cast<double>(widths[i]) / heights[i] / target - 1.0);
+            if (bestError < 0.0 || error < bestError) {
+                bestError = error;
+            }
+            if (error <= tolerance && (canvasWidth == 0 || error < result.ratioError)) {
+                canvasWidth = widths[i];
+                canvasHeight = heights[i];
+                result.ratioError = error;
+            }
+        }
+    }
+    
+    if (canvasWidth == 0) {
+        if (bestError < 0.0) {
+            result.errorMessage = QString("画布像素上限 %1 不足以按目标比例容纳 %2x%3 的源图")
+                .arg(maxPixels).arg(width).arg(height);
+        } else {
+            result.errorMessage = QString("对齐到 %1 像素%2后比例误差至少为 %3%，超出允许的 %4%")
+                .arg(alignment).arg(exceedsLimit ? "并限制像素数" : "")
+                .arg(bestError * 100.0, 0, 'f', 2).arg(tolerance * 100.0, 0, 'f', 2);
+        }
+        return result;
+    }
+    if (canvasWidth == width && canvasHeight == height) {
+        result.errorMessage = QString("图像当前尺寸(%1x%2)已满足目标比例与对齐要求，无需扩展")
+            .arg(width).arg(height);
+        result.alreadySatisfied = true;
+        return result;
+    }
+    
+    // 按分布方式分配后，把起始方向的偏移对齐到同一倍数，余量留给结束方向
+    const auto alignedSplit = [&](int total, const QString &expansionType) {
+        const QPair<int, int> split = distributeExpansion(total, distribution, expansionType);
+        const int start = qMin(alignNearest(split.first), total / alignment * alignment);
+        return qMakePair(start, total - start);
+    };
+    const QPair<int, int> topBottom = alignedSplit(canvasHeight - height, "height");
+    const QPair<int, int> leftRight = alignedSplit(canvasWidth - width, "width");
+    result.top = topBottom.first;
+    result.bottom = topBottom.second;
+    result.left = leftRight.first;
+    result.right = leftRight.second;
+    
+    // 主要扩展方向决定可选的分布方式
+    const bool heightMajor = static_cast<qint64>(canvasHeight - height) * width
+                             >= static_cast<qint64>(canvasWidth - width) * height;
+    result.expansionType = heightMajor ? "height" : "width";
+    result.description = QString("画布 %1x%2（对齐 %3 像素，比例误差 %4%）")
+        .arg(canvasWidth).arg(canvasHeight).arg(alignment)
+        .arg(result.ratioError * 100.0, 0, 'f', 2);
     result.isValid = true;
     return result;
 }
@@ -7,6 +7,11 @@
 #include <QThread>
 #include <QMutex>
 #include <QTimer>
+#include <QCache>
+#include <QHash>
+#include "gradientprofile.h"
+#include "resampler.h"
+#include "orientedimage.h"
 
 class ImageProcessor : public QObject
 {
@@ -16,20 +21,55 @@ public:
     explicit ImageProcessor(QObject *parent = nullptr);
     ~ImageProcessor();
 
+    // 边距填充方式
+    enum FillMode {
+        SolidFill,          // 纯色填充
+        EdgeStretchFill,    // 边缘拉伸：重复最近的源图边缘像素
+        ReflectFill,        // 镜像（重复边缘像素）
+        Reflect101Fill,     // 镜像（不重复边缘像素）
+        WrapFill,           // 平铺
+        BlurredEdgeFill,    // 模糊边缘延伸：镜像延伸并随距离逐渐模糊
+        ContentAwareFill,   // 内容感知：PatchMatch 从源图纹理合成边距
+        ColorFieldFill      // 边缘色场：由分段边缘颜色插值出平滑色场
+    };
+    
+    // 接缝处理方式
+    enum SeamMode {
+        GradientSeam,       // 渐变混合（仅纯色填充）
+        PoissonSeam         // 泊松无缝融合
+    };
+
     // 主要处理函数
-    void expandBackground(const QImage &originalImage, 
+    void expandBackground(const OrientedImage &originalImage, 
                          const QColor &backgroundColor,
                          int topExpansion, 
                          int bottomExpansion, 
                          int leftExpansion, 
                          int rightExpansion);
+    
+    // 同步渲染扩展结果（填充 + 接缝处理），使用当前配置，不经过缓存与调度；
+    // 只读取配置，可在多个线程中同时调用（此时不报告进度）。
+    // 指定 outputSize 时直接在输出分辨率上合成：源图按统一比例重采样到其目标位置，
+    // 边距按输出分辨率生成，不分配全分辨率画布；输出比例与画布不同时多出的空间归入边距
+    QImage renderExpansion(const OrientedImage &originalImage,
+                           const QColor &backgroundColor,
+                           int topExpansion,
+                           int bottomExpansion,
+                           int leftExpansion,
+                           int rightExpansion,
+                           const QSize &outputSize = QSize()) const;
+
+    // 在已放入源图的画布上就地生成边距并处理接缝，不再分配第二块画布。
+    // sourceRect 内为源图像素，画布须为 ARGB32 或 RGB32（RGB32 时背景色须不透明）；
+    // 供先分配画布、再把源图直接解码到其中的批处理使用
+    bool renderInPlace(QImage &canvas, const QRect &sourceRect, const QColor &backgroundColor) const;
 
-    // 颜色分析工具
-    QColor getDominantColor(const QImage &image, const QRect &region = QRect()) const;
-    QColor getAverageColor(const QImage &image, const QRect &region = QRect()) const;
+    // 颜色分析工具（区域按显示方向给出）
+    QColor getDominantColor(const OrientedImage &image, const QRect &region = QRect()) const;
+    QColor getAverageColor(const OrientedImage &image, const QRect &region = QRect()) const;
     
     // 边缘检测（用于智能扩展）
-    QColor getEdgeColor(const QImage &image, Qt::Edge edge) const;
+    QColor getEdgeColor(const OrientedImage &image, Qt::Edge edge) const;
     
     // 智能比例计算
     struct ExpansionValues {
@@ -41,17 +81,93 @@ public:
         QString errorMessage;
         QString expansionType; // "width" 或 "height"
         QString description;   // 扩展描述
+        bool alreadySatisfied; // 源图已符合目标比例，无需扩展（此时 isValid 为 false）
+        double ratioError;     // 画布比例相对目标比例的误差
     };
     
+    // 智能比例计算的画布约束
+    struct CanvasConstraints {
+        int alignment;          // 画布尺寸与源图偏移对齐到该倍数，1 为不对齐（JPEG MCU、视频宏块为 8 或 16）
+        qint64 maxPixels;       // 画布像素上限，0 为不限
+        double ratioTolerance;  // 允许的相对比例误差
+    };
+    
+    void setCanvasConstraints(const CanvasConstraints &constraints) { m_canvasConstraints = constraints; }
+    CanvasConstraints canvasConstraints() const { return m_canvasConstraints; }
+    static CanvasConstraints defaultCanvasConstraints();
+    
     ExpansionValues calculateSmartExpansion(const QImage &originalImage,
                                           const QString &targetRatio,
                                           const QString &distribution) const;
+    // 只需源图尺寸，可在解码前由 QImageReader::size() 计算
+    ExpansionValues calculateSmartExpansion(const QSize &originalSize,
+                                          const QString &targetRatio,
+                                          const QString &distribution) const;
     
     // 取消当前处理
     void cancelProcessing();
     
     // 获取处理状态
     bool isProcessing() const { return m_processing; }
+    
+    // 填充方式
+    void setFillMode(FillMode mode) { m_fillMode = mode; }
+    FillMode fillMode() const { return m_fillMode; }
+    void setColorFieldSegments(int segments) { m_colorFieldSegments = qMax(1, segments); }
+    int colorFieldSegments() const { return m_colorFieldSegments; }
+    
+    // 接缝处理
+    void setSeamMode(SeamMode mode) { m_seamMode = mode; }
+    SeamMode seamMode() const { return m_seamMode; }
+    void setSeamBandWidth(int width) { m_seamBandWidth = qMax(1, width); }
+    int seamBandWidth() const { return m_seamBandWidth; }
+    
+    // 渐变过渡（仅纯色填充 + 渐变接缝时生效）
+    struct BlendDistances {
+        int top;
+        int bottom;
+        int left;
+        int right;
+    };
+    
+    void setGradientEnabled(bool enabled) { m_enableGradient = enabled; }
+    bool gradientEnabled() const { return m_enableGradient; }
+    void setLinearLightBlending(bool enabled) { m_linearLightBlending = enabled; }
+    bool linearLightBlending() const { return m_linearLightBlending; }
+    void setBlendDistances(const BlendDistances &distances);
+    BlendDistances blendDistances() const { return m_blendDistances; }
+    void setGradientProfile(const GradientProfile &profile) { m_gradientProfile = profile; }
+    const GradientProfile &gradientProfile() const { return m_gradientProfile; }
+    
+    // 输出尺寸（无效尺寸表示按扩展后的原始尺寸输出）
+    void setOutputSize(const QSize &size) { m_outputSize = size; }
+    QSize outputSize() const { return m_outputSize; }
+    void setResampleFilter(Resampler::Filter filter) { m_resampleFilter = filter; }
+    Resampler::Filter resampleFilter() const { return m_resampleFilter; }
+    
+    // 复制影响渲染结果的全部配置（填充、接缝、渐变、输出尺寸、画布约束）；
+    // 后台任务使用这样的快照，界面继续修改配置不影响正在进行的任务
+    void copyRenderSettings(const ImageProcessor &other);
+    
+    // 预览调度策略
+    struct SchedulerPolicy {
+        int frameBudgetMs;      // 预计耗时不超过该值时立即处理
+        int targetLatencyMs;    // 预计耗时超过该值时先生成代理预览
+        int maxCoalesceMs;      // 合并连续请求的最长等待时间
+        bool allowProxy;        // 是否允许低分辨率代理预览
+    };
+    
+    void setSchedulerPolicy(const SchedulerPolicy &policy) { m_schedulerPolicy = policy; }
+    SchedulerPolicy schedulerPolicy() const { return m_schedulerPolicy; }
+    static SchedulerPolicy defaultSchedulerPolicy();
+    
+    // 立即完成待处理的请求（全分辨率），用于保存前确保结果完整
+    void finishPendingWork();
+    
+    // 结果缓存（LRU，按内存上限淘汰）
+    void setCacheLimit(int megabytes);
+    int cacheLimit() const { return static_cast<int>(m_resultCache.maxCost() / 1024); }
+    void clearCache();
 
 public slots:
     void setProcessingEnabled(bool enabled) { m_processingEnabled = enabled; }
@@ -68,27 +184,40 @@ private slots:
 
 private:
     // 核心算法函数
-    QImage createExpandedImage(const QImage &originalImage,
+    QImage createExpandedImage(const OrientedImage &originalImage,
                               const QColor &backgroundColor,
                               int topExpansion,
                               int bottomExpansion, 
                               int leftExpansion,
                               int rightExpansion) const;
     
-    QImage applyGradientBlending(const QImage &expandedImage,
-                                const QImage &originalImage,
-                                int topExpansion,
-                                int bottomExpansion,
-                                int leftExpansion, 
-                                int rightExpansion) const;
+    // 按缩放后的画布合成：scaleX/scaleY 为相对全分辨率的比例，
+    // 过渡距离等以像素计的参数随之缩放
+    QImage renderCanvas(const OrientedImage &originalImage,
+                        const QColor &backgroundColor,
+                        int topExpansion,
+                        int bottomExpansion,
+                        int leftExpansion,
+                        int rightExpansion,
+                        double scaleX,
+                        double scaleY) const;
+    
+    // 按填充方式生成 sourceRect 以外的边距
+    void fillMargins(QImage &canvas, const QRect &sourceRect, const QColor &backgroundColor) const;
+    
+    // 接缝处理（泊松融合或渐变混合），就地修改画布；取消时返回 false
+    bool applySeam(QImage &canvas, const QRect &sourceRect, double scaleX, double scaleY) const;
+    
+    bool applyGradientBlending(QImage &result, const QRect &sourceRect,
+                               double scaleX, double scaleY) const;
     
     // 辅助函数
-    QColor blendColors(const QColor &color1, const QColor &color2, double factor) const;
-    double calculateBlendFactor(int distance, int maxDistance) const;
     void updateProgress(int current, int total) const;
+    double estimateProcessingCost(qint64 outputPixels) const;
+    void recordProcessingCost(qint64 outputPixels, qint64 elapsedNs);
     
     // 颜色分析辅助函数
-    QVector<QRgb> extractPixels(const QImage &image, const QRect &region) const;
+    QVector<QRgb> extractPixels(const OrientedImage &image, const QRect &region) const;
     QColor calculateDominantColor(const QVector<QRgb> &pixels) const;
     QColor calculateAverageColor(const QVector<QRgb> &pixels) const;
     
@@ -97,10 +226,96 @@ private:
     ExpansionValues calculateOptimalExpansion(const QSize &originalSize,
                                              const QPair<double, double> &ratio,
                                              const QString &distribution) const;
+    // 带对齐或像素上限时的画布搜索
+    ExpansionValues calculateConstrainedExpansion(const QSize &originalSize,
+                                                  const QPair<double, double> &ratio,
+                                                  const QString &distribution) const;
     QPair<int, int> distributeExpansion(int totalExpansion, 
                                        const QString &distribution,
                                        const QString &expansionType) const;
 
+    // 结果缓存键：图像标识 + 全部影响输出的参数
+    struct CacheKey {
+        qint64 imageKey;
+        QRgb color;
+        int top;
+        int bottom;
+        int left;
+        int right;
+        int outputWidth;
+        int outputHeight;
+        int resampleFilter;
+        int fillMode;
+        int colorFieldSegments;
+        int seamMode;
+        int seamBandWidth;
+        int blendTop;
+        int blendBottom;
+        int blendLeft;
+        int blendRight;
+        bool enableGradient;
+        bool linearLightBlending;
+        uint gradientFingerprint;
+        
+        bool operator==(const CacheKey &other) const
+        {
+            return imageKey == other.imageKey && color == other.color &&
+                   top == other.top && bottom == other.bottom &&
+                   left == other.left && right == other.right &&
+                   outputWidth == other.outputWidth &&
+                   outputHeight == other.outputHeight &&
+                   resampleFilter == other.resampleFilter &&
+                   fillMode == other.fillMode &&
+                   colorFieldSegments == other.colorFieldSegments &&
+                   seamMode == other.seamMode &&
+                   seamBandWidth == other.seamBandWidth &&
+                   blendTop == other.blendTop &&
+                   blendBottom == other.blendBottom &&
+                   blendLeft == other.blendLeft &&
+                   blendRight == other.blendRight &&
+                   enableGradient == other.enableGradient &&
+                   linearLightBlending == other.linearLightBlending &&
+                   gradientFingerprint == other.gradientFingerprint;
+        }
+        
+        // Qt 6 的 QHash 使用 size_t 的哈希值与种子，Qt 5 中按 uint 截取
+        friend size_t qHash(const CacheKey &key, size_t seed = 0)
+        {
+            size_t h = seed;
+            auto combine = [&h](size_t value) {
+                h ^= value + 0x9e3779b9u + (h << 6) + (h >> 2);
+            };
+            combine(::qHash(key.imageKey));
+            combine(key.color);
+            combine(::qHash(key.top));
+            combine(::qHash(key.bottom));
+            combine(::qHash(key.left));
+            combine(::qHash(key.right));
+            combine(::qHash(key.outputWidth));
+            combine(::qHash(key.outputHeight));
+            combine(::qHash(key.resampleFilter));
+            combine(::qHash(key.fillMode));
+            combine(::qHash(key.colorFieldSegments));
+            combine(::qHash(key.seamMode));
+            combine(::qHash(key.seamBandWidth));
+            combine(::qHash(key.blendTop));
+            combine(::qHash(key.blendBottom));
+            combine(::qHash(key.blendLeft));
+            combine(::qHash(key.blendRight));
+            combine(key.enableGradient ? 1 : 0);
+            combine(key.linearLightBlending ? 1 : 0);
+            combine(key.gradientFingerprint);
+            return h;
+        }
+    };
+    
+    CacheKey makeCacheKey(const OrientedImage &originalImage,
+                          const QColor &backgroundColor,
+                          int topExpansion,
+                          int bottomExpansion,
+                          int leftExpansion,
+                          int rightExpansion) const;
+
     // 成员变量
     QTimer *m_processTimer;
     mutable QMutex m_processMutex;
@@ -111,22 +326,49 @@ private:
     bool m_cancelRequested;
     
     // 当前处理参数
-    QImage m_currentOriginalImage;
+    OrientedImage m_currentOriginalImage;
     QColor m_currentBackgroundColor;
     int m_currentTopExpansion;
     int m_currentBottomExpansion;
     int m_currentLeftExpansion;
     int m_currentRightExpansion;
     
+    // 自适应调度
+    SchedulerPolicy m_schedulerPolicy;
+    double m_currentProxyScale;     // 下一次处理的缩放比例（1.0 为全分辨率）
+    double m_costPerPixelNs;        // 近期处理耗时（纳秒/输出像素）的滑动平均
+    
+    // 智能比例的画布约束
+    CanvasConstraints m_canvasConstraints;
+    
+    // 输出尺寸与缩放滤镜
+    QSize m_outputSize;
+    Resampler::Filter m_resampleFilter;
+    
+    // 结果缓存（成本单位为KB）
+    QCache<CacheKey, QImage> m_resultCache;
+    
     // 配置参数
-    int m_blendDistance;        // 混合距离（像素）
-    bool m_enableGradient;      // 是否启用渐变混合
-    double m_gradientStrength;  // 渐变强度
+    FillMode m_fillMode;        // 边距填充方式
+    int m_colorFieldSegments;   // 边缘色场每条边的分段数
+    SeamMode m_seamMode;        // 接缝处理方式
+    int m_seamBandWidth;        // 泊松融合边带宽度（像素）
+    BlendDistances m_blendDistances;    // 各边的渐变过渡距离（像素）
+    bool m_enableGradient;              // 是否启用渐变混合
+    bool m_linearLightBlending;         // 是否在线性光空间混合
+    GradientProfile m_gradientProfile;  // 渐变曲线与强度（已烘焙为权重表）
     
     // 常量
     static constexpr int DEFAULT_BLEND_DISTANCE = 10;
     static constexpr double DEFAULT_GRADIENT_STRENGTH = 0.3;
+    static constexpr int DEFAULT_SEAM_BAND_WIDTH = 32;
+    static constexpr int DEFAULT_COLOR_FIELD_SEGMENTS = 8;
     static constexpr int PROGRESS_UPDATE_INTERVAL = 100; // 进度更新间隔（毫秒）
+    static constexpr int DEFAULT_CACHE_LIMIT_MB = 256;   // 结果缓存默认上限（MB）
+    static constexpr double DEFAULT_COST_PER_PIXEL_NS = 10.0; // 首次处理前的耗时估计
+    static constexpr double COST_SMOOTHING = 0.3;        // 耗时滑动平均系数
+    static constexpr double MIN_PROXY_SCALE = 0.1;       // 代理预览的最小缩放比例
+    static constexpr int CANVAS_SEARCH_STEPS = 64;       // 对齐画布在最小尺寸之上的搜索步数
 };
 
 #endif // IMAGEPROCESSOR_H
@@ -1,8 +1,10 @@
 #include "imageviewer.h"
+#include "imageloader.h"
+#include "mappedimage.h"
+#include "resampler.h"
 #include <QApplication>
 #include <QFileInfo>
 #include <QImageReader>
-#include <QImageWriter>
 #include <QMessageBox>
 #include <QMimeData>
 #include <QDragEnterEvent>
@@ -14,11 +16,22 @@
 #include <QPixmap>
 #include <QScrollBar>
 
+// 代理预览图像通过 devicePixelRatio 标记其相对实际尺寸的缩放比例
+static QSize logicalImageSize(const OrientedImage &image)
+{
+    const qreal ratio = image.devicePixelRatio();
+    if (ratio == 1.0) {
+        return image.size();
+    }
+    return QSize(qRound(image.width() / ratio), qRound(image.height() / ratio));
+}
+
 ImageViewer::ImageViewer(QWidget *parent)
     : QWidget(parent)
     , m_scaleFactor(1.0)
     , m_showProcessed(false)
     , m_dragging(false)
+    , m_loader(new ImageLoader(this))
 {
     setAcceptDrops(true);
     setMouseTracking(true);
@@ -32,58 +45,90 @@ ImageViewer::ImageViewer(QWidget *parent)
     QPalette palette = this->palette();
     palette.setColor(QPalette::Window, QColor(64, 64, 64));
     setPalette(palette);
+    
+    connect(m_loader, &ImageLoader::previewReady, this, &ImageViewer::onPreviewReady);
+    connect(m_loader, &ImageLoader::imageReady, this, &ImageViewer::onImageReady);
+    connect(m_loader, &ImageLoader::loadFailed, this, &ImageViewer::onLoadFailed);
 }
 
 bool ImageViewer::loadImage(const QString &fileName)
 {
+    // 只读取文件头判断格式，解码在工作线程中进行
     QImageReader reader(fileName);
-    reader.setAutoTransform(true);
-    
-    QImage image = reader.read();
-    if (image.isNull()) {
+    if (!MappedImage::canRead(fileName) && !reader.canRead()) {
         qDebug() << "无法加载图像:" << reader.errorString();
         return false;
     }
     
-    // 确保图像格式支持颜色拾取
-    if (image.format() != QImage::Format_ARGB32 && 
-        image.format() != QImage::Format_RGB32) {
-        image = image.convertToFormat(QImage::Format_ARGB32);
-    }
+    // 预览按视口的物理像素尺寸解码
+    const QSize previewSize = (size() - QSize(20, 20)).expandedTo(QSize(1, 1)) * devicePixelRatioF();
+    m_loader->load(fileName, previewSize);
     
-    m_originalImage = image;
-    m_processedImage = QImage(); // 清除处理后的图像
+    m_originalImage = QImage();
+    m_processedImage = QImage();
     m_showProcessed = false;
+    m_scaleFactor = 1.0;
+    updateImageSize();
+    update();
+    return true;
+}
+
+bool ImageViewer::isLoading() const
+{
+    return m_loader->isLoading();
+}
+
+void ImageViewer::onPreviewReady(const QString &fileName, const QImage &preview)
+{
+    Q_UNUSED(fileName);
     
-    // 重置显示参数
+    // 预览带有 devicePixelRatio 标记，逻辑尺寸与完整图像一致
+    m_originalImage = preview;
     m_scaleFactor = 1.0;
     updateImageSize();
     fitToWindow();
+    update();
+}
+
+void ImageViewer::onImageReady(const QString &fileName, const OrientedImage &image,
+                               qint64 firstPixelMs, qint64 fullImageMs)
+{
+    const bool hadPreview = !m_originalImage.isNull();
+    m_originalImage = image;
+    m_processedImage = QImage(); // 清除处理后的图像
+    m_showProcessed = false;
+    
+    // 已显示预览时保持当前缩放，替换后画面不跳动
+    if (hadPreview) {
+        updateImageSize();
+    } else {
+        m_scaleFactor = 1.0;
+        updateImageSize();
+        fitToWindow();
+    }
     
     emit imageChanged();
     emit zoomChanged(m_scaleFactor);
+    emit imageLoaded(fileName, firstPixelMs, fullImageMs);
     
     update();
-    return true;
 }
 
-bool ImageViewer::saveImage(const QString &fileName)
+void ImageViewer::onLoadFailed(const QString &fileName, const QString &errorString)
 {
-    if (!hasImage()) {
-        return false;
-    }
-    
-    // 选择要保存的图像（原始或处理后）
-    const QImage &imageToSave = m_showProcessed && !m_processedImage.isNull() 
-                                ? m_processedImage : m_originalImage;
-    
-    QImageWriter writer(fileName);
-    if (!writer.write(imageToSave)) {
-        qDebug() << "保存图像失败:" << writer.errorString();
-        return false;
-    }
-    
-    return true;
+    qDebug() << "无法加载图像:" << errorString;
+    m_originalImage = QImage();
+    m_processedImage = QImage();
+    m_showProcessed = false;
+    updateImageSize();
+    update();
+    emit imageLoadFailed(fileName, errorString);
+}
+
+QImage ImageViewer::currentImage() const
+{
+    // 未处理的原图按显示方向生成，只在保存时发生
+    return m_showProcessed && !m_processedImage.isNull() ? m_processedImage : m_originalImage.toImage();
 }
 
 bool ImageViewer::hasImage() const
@@ -97,13 +142,24 @@ QSize ImageViewer::imageSize() const
         return QSize();
     }
     
-    const QImage &currentImage = m_showProcessed && !m_processedImage.isNull() 
-                                ? m_processedImage : m_originalImage;
-    return currentImage.size();
+    const OrientedImage currentImage = m_showProcessed && !m_processedImage.isNull()
+                                      ? OrientedImage(m_processedImage) : m_originalImage;
+    return logicalImageSize(currentImage);
+}
+
+bool ImageViewer::isProxyPreview() const
+{
+    return m_showProcessed && !m_processedImage.isNull() &&
+           m_processedImage.devicePixelRatio() != 1.0;
 }
 
 void ImageViewer::setProcessedImage(const QImage &image)
 {
+    // 加载新图像期间到达的旧图像处理结果不再显示
+    if (isLoading()) {
+        return;
+    }
+    
     m_processedImage = image;
     m_showProcessed = true;
     updateImageSize();
@@ -175,8 +231,9 @@ void ImageViewer::paintEvent(QPaintEvent *event)
     if (!hasImage()) {
         // 绘制提示文字
         painter.setPen(QPen(Qt::white));
-        painter.drawText(rect(), Qt::AlignCenter, 
-                        QString::fromUtf8("点击\"文件\"菜单打开图像\n或拖拽图像文件到此处"));
+        painter.drawText(rect(), Qt::AlignCenter, isLoading()
+                        ? QString::fromUtf8("正在加载图像...")
+                        : QString::fromUtf8("点击\"文件\"菜单打开图像\n或拖拽图像文件到此处"));
         return;
     }
     
@@ -187,8 +244,8 @@ void ImageViewer::paintEvent(QPaintEvent *event)
     }
     
     // 如果图像有透明通道，先绘制棋盘背景
-    const QImage &currentImage = m_showProcessed && !m_processedImage.isNull() 
-                                ? m_processedImage : m_originalImage;
+    const OrientedImage currentImage = m_showProcessed && !m_processedImage.isNull()
+                                      ? OrientedImage(m_processedImage) : m_originalImage;
     
     if (currentImage.hasAlphaChannel()) {
         drawCheckerboard(painter, imageRect);
@@ -282,18 +339,20 @@ void ImageViewer::updateImageSize()
         return;
     }
     
-    const QImage &currentImage = m_showProcessed && !m_processedImage.isNull() 
-                                ? m_processedImage : m_originalImage;
+    const OrientedImage currentImage = m_showProcessed && !m_processedImage.isNull()
+                                      ? OrientedImage(m_processedImage) : m_originalImage;
     
     // 计算缩放后的尺寸
-    m_scaledImageSize = currentImage.size() * m_scaleFactor;
+    m_scaledImageSize = logicalImageSize(currentImage) * m_scaleFactor;
     
-    // 创建缩放后的像素图
-    if (m_scaleFactor == 1.0) {
-        m_scaledPixmap = QPixmap::fromImage(currentImage);
+    // 创建缩放后的像素图；带方向的原图在存储方向上缩放，只旋转缩放后的结果
+    if (m_scaleFactor == 1.0 && currentImage.devicePixelRatio() == 1.0) {
+        m_scaledPixmap = QPixmap::fromImage(currentImage.toImage());
     } else {
-        m_scaledPixmap = QPixmap::fromImage(currentImage.scaled(
-            m_scaledImageSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        // 预览缩放使用双三次滤波，在清晰度与交互速度之间取得平衡
+        const QSize targetSize = currentImage.size().scaled(m_scaledImageSize, Qt::KeepAspectRatio);
+        m_scaledPixmap = QPixmap::fromImage(
+            currentImage.resized(targetSize, Resampler::Bicubic).toImage());
     }
     
     // 计算居中位置
@@ -317,11 +376,12 @@ QPoint ImageViewer::imagePointFromWidget(const QPoint &widgetPoint) const
     double x = relativePoint.x() / m_scaleFactor;
     double y = relativePoint.y() / m_scaleFactor;
     
-    const QImage &currentImage = m_showProcessed && !m_processedImage.isNull() 
-                                ? m_processedImage : m_originalImage;
+    const OrientedImage currentImage = m_showProcessed && !m_processedImage.isNull()
+                                      ? OrientedImage(m_processedImage) : m_originalImage;
     
     // 确保坐标在图像范围内
-    if (x >= 0 && x < currentImage.width() && y >= 0 && y < currentImage.height()) {
+    const QSize size = logicalImageSize(currentImage);
+    if (x >= 0 && x < size.width() && y >= 0 && y < size.height()) {
         return QPoint(static_cast<int>(x), static_cast<int>(y));
     }
     
@@ -334,12 +394,17 @@ QColor ImageViewer::getPixelColor(const QPoint &imagePoint) const
         return QColor();
     }
     
-    const QImage &currentImage = m_showProcessed && !m_processedImage.isNull() 
-                                ? m_processedImage : m_originalImage;
+    const OrientedImage currentImage = m_showProcessed && !m_processedImage.isNull()
+                                      ? OrientedImage(m_processedImage) : m_originalImage;
+    
+    // 代理预览需将逻辑坐标换算为实际像素坐标
+    const qreal ratio = currentImage.devicePixelRatio();
+    const QPoint pixelPoint(static_cast<int>(imagePoint.x() * ratio),
+                            static_cast<int>(imagePoint.y() * ratio));
     
-    if (imagePoint.x() >= 0 && imagePoint.x() < currentImage.width() &&
-        imagePoint.y() >= 0 && imagePoint.y() < currentImage.height()) {
-        return QColor(currentImage.pixel(imagePoint));
+    if (pixelPoint.x() >= 0 && pixelPoint.x() < currentImage.width() &&
+        pixelPoint.y() >= 0 && pixelPoint.y() < currentImage.height()) {
+        return QColor(currentImage.pixel(pixelPoint));
     }
     
     return QColor();
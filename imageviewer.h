@@ -12,6 +12,9 @@
 #include <QResizeEvent>
 #include <QScrollArea>
 #include <QScrollBar>
+#include "orientedimage.h"
+
+class ImageLoader;
 
 class ImageViewer : public QWidget
 {
@@ -20,15 +23,17 @@ class ImageViewer : public QWidget
 public:
     explicit ImageViewer(QWidget *parent = nullptr);
     
-    // 图像操作
+    // 图像操作（异步加载，完成后发出 imageLoaded 或 imageLoadFailed）
     bool loadImage(const QString &fileName);
-    bool saveImage(const QString &fileName);
+    bool isLoading() const;
     bool hasImage() const;
     QSize imageSize() const;
     
-    // 获取图像数据
-    QImage originalImage() const { return m_originalImage; }
+    // 获取图像数据；原图保持存储方向，EXIF 方向作为元数据
+    OrientedImage originalImage() const { return m_originalImage; }
     QImage processedImage() const { return m_processedImage; }
+    // 当前显示的图像（处理结果或原图），即保存与导出的内容
+    QImage currentImage() const;
     
     // 预览控制
     void setProcessedImage(const QImage &image);
@@ -44,10 +49,13 @@ public:
     // 获取状态
     double zoomFactor() const { return m_scaleFactor; }
     bool isPreviewMode() const { return m_showProcessed; }
+    bool isProxyPreview() const;
 
 signals:
     void colorPicked(const QColor &color);
     void imageChanged();
+    void imageLoaded(const QString &fileName, qint64 firstPixelMs, qint64 fullImageMs);
+    void imageLoadFailed(const QString &fileName, const QString &errorString);
     void zoomChanged(double factor);
 
 protected:
@@ -57,6 +65,12 @@ protected:
     void wheelEvent(QWheelEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
 
+private slots:
+    void onPreviewReady(const QString &fileName, const QImage &preview);
+    void onImageReady(const QString &fileName, const OrientedImage &image,
+                      qint64 firstPixelMs, qint64 fullImageMs);
+    void onLoadFailed(const QString &fileName, const QString &errorString);
+
 private:
     void updateImageSize();
     void scaleImage(double factor);
@@ -65,9 +79,10 @@ private:
     void drawCheckerboard(QPainter &painter, const QRect &rect) const;
     
     // 图像数据
-    QImage m_originalImage;
+    OrientedImage m_originalImage;
     QImage m_processedImage;
     QPixmap m_scaledPixmap;
+    ImageLoader *m_loader;
     
     // 显示状态
     double m_scaleFactor;
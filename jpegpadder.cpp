@@ -0,0 +1,1351 @@
+#include "jpegpadder.h"
+#include <QIODevice>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Z 字形序号对应的自然顺序（行优先）下标
+const int ZIGZAG_TO_NATURAL[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+enum Marker {
+    SOF0 = 0xC0,
+    SOF1 = 0xC1,
+    SOF2 = 0xC2,
+    DHT = 0xC4,
+    RST0 = 0xD0,
+    RST7 = 0xD7,
+    SOI = 0xD8,
+    EOI = 0xD9,
+    SOS = 0xDA,
+    DQT = 0xDB,
+    DNL = 0xDC,
+    DRI = 0xDD,
+    APP0 = 0xE0,
+    APP1 = 0xE1,
+    APP14 = 0xEE,
+    APP15 = 0xEF,
+    COM = 0xFE
+};
+
+const int MAX_DIMENSION = 65535;
+
+inline int readU16(const uchar *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+inline void appendU16(QByteArray &out, int value)
+{
+    out.append(static_cast<char>((value >> 8) & 0xFF));
+    out.append(static_cast<char>(value & 0xFF));
+}
+
+inline void appendMarker(QByteArray &out, int marker, int payloadLength)
+{
+    out.append(static_cast<char>(0xFF));
+    out.append(static_cast<char>(marker));
+    appendU16(out, payloadLength + 2);
+}
+
+// 哈夫曼解码表：短码查表，长码按各码长的最大码字逐级比较
+struct HuffmanDecoder {
+    static constexpr int LOOKAHEAD = 9;
+
+    bool defined = false;
+    uchar lookupLength[1 << LOOKAHEAD];
+    uchar lookupSymbol[1 << LOOKAHEAD];
+    int maxCode[18];
+    int valueOffset[17];
+    uchar values[256];
+
+    bool build(const uchar *bits, const uchar *symbols, int count)
+    {
+        std::memset(lookupLength, 0, sizeof(lookupLength));
+        std::memcpy(values, symbols, count);
+        int code = 0;
+        int k = 0;
+        for (int length = 1; length <= 16; ++length) {
+            valueOffset[length] = k - code;
+            for (int i = 0; i < bits[length - 1]; ++i) {
+                if (length <= LOOKAHEAD) {
+                    const int shift = LOOKAHEAD - length;
+                    for (int fill = 0; fill < (1 << shift); ++fill) {
+                        lookupLength[(code << shift) | fill] = static_cast<uchar>(length);
+                        lookupSymbol[(code << shift) | fill] = symbols[k];
+                    }
+                }
+                ++code;
+                ++k;
+            }
+            // 码字不能超出该码长的取值范围
+            if (code > (1 << length)) {
+                return false;
+            }
+            maxCode[length] = bits[length - 1] ? code - 1 : -1;
+            code <<= 1;
+        }
+        maxCode[17] = 0x7FFFFFFF;
+        defined = true;
+        return true;
+    }
+};
+
+constexpr int HuffmanDecoder::LOOKAHEAD;
+
+// 熵编码段的位读取：去掉填充的 0x00，遇到标记后补零并记录标记
+class BitReader
+{
+public:
+    BitReader(const uchar *data, size_t size, size_t position)
+        : m_data(data)
+        , m_size(size)
+        , m_position(position)
+        , m_buffer(0)
+        , m_bits(0)
+        , m_marker(-1)
+    {
+    }
+
+    int getBits(int count)
+    {
+        if (count == 0) {
+            return 0;
+        }
+        fill();
+        m_bits -= count;
+        return static_cast<int>((m_buffer >> m_bits) & ((1u << count) - 1));
+    }
+
+    int getBit()
+    {
+        return getBits(1);
+    }
+
+    // 返回 -1 表示码字无效
+    int decode(const HuffmanDecoder &table)
+    {
+        fill();
+        const int look = static_cast<int>((m_buffer >> (m_bits - HuffmanDecoder::LOOKAHEAD))
+                                          & ((1 << HuffmanDecoder::LOOKAHEAD) - 1));
+        const int length = table.lookupLength[look];
+        if (length) {
+            m_bits -= length;
+            return table.lookupSymbol[look];
+        }
+        const int code16 = static_cast<int>((m_buffer >> (m_bits - 16)) & 0xFFFF);
+        for (int length = HuffmanDecoder::LOOKAHEAD + 1; length <= 16; ++length) {
+            const int code = code16 >> (16 - length);
+            if (code <= table.maxCode[length]) {
+                m_bits -= length;
+                return table.values[code + table.valueOffset[length]];
+            }
+        }
+        return -1;
+    }
+
+    // 重启间隔结束：丢弃剩余的填充位并越过 RSTn 标记
+    bool restart()
+    {
+        m_buffer = 0;
+        m_bits = 0;
+        if (m_marker < RST0 || m_marker > RST7) {
+            return false;
+        }
+        m_position += 2;
+        m_marker = -1;
+        return true;
+    }
+
+    // 扫描结束后下一个标记的位置
+    size_t nextMarkerPosition() const
+    {
+        size_t position = m_position;
+        while (position + 1 < m_size) {
+            if (m_data[position] == 0xFF && m_data[position + 1] != 0x00
+                && m_data[position + 1] != 0xFF
+                && (m_data[position + 1] < RST0 || m_data[position + 1] > RST7)) {
+                return position;
+            }
+            ++position;
+        }
+        return m_size;
+    }
+
+    size_t position() const { return m_position; }
+
+private:
+    void fill()
+    {
+        while (m_bits <= 56) {
+            uchar byte = 0;
+            if (m_marker < 0) {
+                if (m_position >= m_size) {
+                    m_marker = EOI;
+                } else if (m_data[m_position] != 0xFF) {
+                    byte = m_data[m_position++];
+                } else if (m_position + 1 < m_size && m_data[m_position + 1] == 0x00) {
+                    byte = 0xFF;
+                    m_position += 2;
+                } else {
+                    m_marker = m_position + 1 < m_size ? static_cast<int>(m_data[m_position + 1]) : static_cast<int>(EOI);
+                }
+            }
+            m_buffer = (m_buffer << 8) | byte;
+            m_bits += 8;
+        }
+    }
+
+    const uchar *m_data;
+    size_t m_size;
+    size_t m_position;
+    quint64 m_buffer;
+    int m_bits;
+    int m_marker;
+};
+
+inline int extend(int value, int bits)
+{
+    return value < (1 << (bits - 1)) ? value - (1 << bits) + 1 : value;
+}
+
+// 一个扫描的参数与熵解码状态
+struct ScanState {
+    std::vector<int> components;    // 分量下标
+    int dcTable[4];
+    int acTable[4];
+    int spectralStart;
+    int spectralEnd;
+    int approximationHigh;
+    int approximationLow;
+    int dcPredictors[4];
+    int eobRun;
+};
+
+bool decodeSequentialBlock(BitReader &reader, qint16 *block, int &predictor,
+                           const HuffmanDecoder &dc, const HuffmanDecoder &ac)
+{
+    const int size = reader.decode(dc);
+    if (size < 0 || size > 11) {
+        return false;
+    }
+    predictor += size ? extend(reader.getBits(size), size) : 0;
+    block[0] = static_cast<qint16>(predictor);
+    for (int k = 1; k < 64; ++k) {
+        const int symbol = reader.decode(ac);
+        if (symbol < 0) {
+            return false;
+        }
+        const int run = symbol >> 4;
+        const int bits = symbol & 15;
+        if (bits) {
+            k += run;
+            if (k > 63) {
+                return false;
+            }
+            block[k] = static_cast<qint16>(extend(reader.getBits(bits), bits));
+        } else if (run == 15) {
+            k += 15;
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+bool decodeDcFirst(BitReader &reader, qint16 *block, int &predictor,
+                   const HuffmanDecoder &dc, int low)
+{
+    const int size = reader.decode(dc);
+    if (size < 0 || size > 11) {
+        return false;
+    }
+    predictor += size ? extend(reader.getBits(size), size) : 0;
+    block[0] = static_cast<qint16>(predictor * (1 << low));
+    return true;
+}
+
+void decodeDcRefine(BitReader &reader, qint16 *block, int low)
+{
+    if (reader.getBit()) {
+        block[0] = static_cast<qint16>(block[0] | (1 << low));
+    }
+}
+
+bool decodeAcFirst(BitReader &reader, qint16 *block, ScanState &scan, const HuffmanDecoder &ac)
+{
+    if (scan.eobRun > 0) {
+        --scan.eobRun;
+        return true;
+    }
+    for (int k = scan.spectralStart; k <= scan.spectralEnd; ++k) {
+        const int symbol = reader.decode(ac);
+        if (symbol < 0) {
+            return false;
+        }
+        const int run = symbol >> 4;
+        const int bits = symbol & 15;
+        if (bits) {
+            k += run;
+            if (k > 63) {
+                return false;
+            }
+            block[k] = static_cast<qint16>(extend(reader.getBits(bits), bits)
+                                           * (1 << scan.approximationLow));
+        } else if (run == 15) {
+            k += 15;
+        } else {
+            scan.eobRun = (1 << run) - 1;
+            if (run) {
+                scan.eobRun += reader.getBits(run);
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+// 与 libjpeg 的 decode_mcu_AC_refine 相同的逐次逼近细化
+bool decodeAcRefine(BitReader &reader, qint16 *block, ScanState &scan, const HuffmanDecoder &ac)
+{
+    const int plus = 1 << scan.approximationLow;
+    const int minus = -plus;
+    const auto refine = [&](qint16 &coefficient) {
+        if (reader.getBit() && (coefficient & plus) == 0) {
+            coefficient = static_cast<qint16>(coefficient + (coefficient >= 0 ? plus : minus));
+        }
+    };
+
+    int k = scan.spectralStart;
+    if (scan.eobRun == 0) {
+        for (; k <= scan.spectralEnd; ++k) {
+            const int symbol = reader.decode(ac);
+            if (symbol < 0) {
+                return false;
+            }
+            int run = symbol >> 4;
+            int value = 0;
+            if (symbol & 15) {
+                value = reader.getBit() ? plus : minus;
+            } else if (run != 15) {
+                scan.eobRun = 1 << run;
+                if (run) {
+                    scan.eobRun += reader.getBits(run);
+                }
+                break;
+            }
+            do {
+                qint16 &coefficient = block[k];
+                if (coefficient != 0) {
+                    refine(coefficient);
+                } else if (--run < 0) {
+                    break;
+                }
+                ++k;
+            } while (k <= scan.spectralEnd);
+            if (value && k <= scan.spectralEnd) {
+                block[k] = static_cast<qint16>(value);
+            }
+        }
+    }
+    if (scan.eobRun > 0) {
+        for (; k <= scan.spectralEnd; ++k) {
+            if (block[k] != 0) {
+                refine(block[k]);
+            }
+        }
+        --scan.eobRun;
+    }
+    return true;
+}
+
+// EXIF 方向标签（0x0112），找不到时为 1
+int parseExifOrientation(const uchar *data, int size)
+{
+    if (size < 14 || std::memcmp(data, "Exif\0\0", 6) != 0) {
+        return 1;
+    }
+    const uchar *tiff = data + 6;
+    const int length = size - 6;
+    const bool littleEndian = tiff[0] == 'I' && tiff[1] == 'I';
+    if (!littleEndian && !(tiff[0] == 'M' && tiff[1] == 'M')) {
+        return 1;
+    }
+    const auto u16 = [&](int offset) {
+        return littleEndian ? tiff[offset] | (tiff[offset + 1] << 8)
+                            : (tiff[offset] << 8) | tiff[offset + 1];
+    };
+    const auto u32 = [&](int offset) {
+        return littleEndian ? static_cast<quint32>(u16(offset)) | (static_cast<quint32>(u16(offset + 2)) << 16)
+                            : (static_cast<quint32>(u16(offset)) << 16) | static_cast<quint32>(u16(offset + 2));
+    };
+    const quint32 ifd = u32(4);
+    if (ifd + 2 > static_cast<quint32>(length)) {
+        return 1;
+    }
+    const int entries = u16(ifd);
+    for (int i = 0; i < entries; ++i) {
+        const quint32 entry = ifd + 2 + i * 12;
+        if (entry + 12 > static_cast<quint32>(length)) {
+            break;
+        }
+        if (u16(entry) == 0x0112) {
+            const int orientation = u16(entry + 8);
+            return orientation >= 1 && orientation <= 8 ? orientation : 1;
+        }
+    }
+    return 1;
+}
+
+// 按 JPEG 标准附录 K.2 生成码长不超过 16 位的最优哈夫曼表
+void buildOptimalTable(const quint64 *frequencies, uchar *bits, std::vector<uchar> &values)
+{
+    quint64 freq[257];
+    std::memcpy(freq, frequencies, 256 * sizeof(quint64));
+    // 保留一个全 1 码字，确保没有码字全为 1
+    freq[256] = 1;
+    int codeSize[257] = {0};
+    int others[257];
+    std::fill(others, others + 257, -1);
+
+    for (;;) {
+        int c1 = -1;
+        quint64 v = ~quint64(0);
+        for (int i = 0; i <= 256; ++i) {
+            if (freq[i] && freq[i] <= v) {
+                v = freq[i];
+                c1 = i;
+            }
+        }
+        int c2 = -1;
+        v = ~quint64(0);
+        for (int i = 0; i <= 256; ++i) {
+            if (freq[i] && freq[i] <= v && i != c1) {
+                v = freq[i];
+                c2 = i;
+            }
+        }
+        if (c2 < 0) {
+            break;
+        }
+        freq[c1] += freq[c2];
+        freq[c2] = 0;
+        ++codeSize[c1];
+        while (others[c1] >= 0) {
+            c1 = others[c1];
+            ++codeSize[c1];
+        }
+        others[c1] = c2;
+        ++codeSize[c2];
+        while (others[c2] >= 0) {
+            c2 = others[c2];
+            ++codeSize[c2];
+        }
+    }
+
+    int count[33] = {0};
+    for (int i = 0; i <= 256; ++i) {
+        if (codeSize[i]) {
+            ++count[qMin(codeSize[i], 32)];
+        }
+    }
+    // 把超过 16 位的码字移到较短的码长上
+    for (int i = 32; i > 16; --i) {
+        while (count[i] > 0) {
+            int j = i - 2;
+            while (count[j] == 0) {
+                --j;
+            }
+            count[i] -= 2;
+            ++count[i - 1];
+            count[j + 1] += 2;
+            --count[j];
+        }
+    }
+    // 去掉保留的码字
+    int longest = 16;
+    while (count[longest] == 0) {
+        --longest;
+    }
+    --count[longest];
+
+    for (int i = 1; i <= 16; ++i) {
+        bits[i - 1] = static_cast<uchar>(count[i]);
+    }
+    values.clear();
+    for (int size = 1; size <= 32; ++size) {
+        for (int symbol = 0; symbol < 256; ++symbol) {
+            if (codeSize[symbol] == size) {
+                values.push_back(static_cast<uchar>(symbol));
+            }
+        }
+    }
+}
+
+// 哈夫曼编码表
+struct HuffmanEncoder {
+    quint16 code[256];
+    uchar size[256];
+
+    void build(const uchar *bits, const std::vector<uchar> &values)
+    {
+        std::memset(size, 0, sizeof(size));
+        int next = 0;
+        int k = 0;
+        for (int length = 1; length <= 16; ++length) {
+            for (int i = 0; i < bits[length - 1]; ++i) {
+                code[values[k]] = static_cast<quint16>(next++);
+                size[values[k]] = static_cast<uchar>(length);
+                ++k;
+            }
+            next <<= 1;
+        }
+    }
+};
+
+// 熵编码输出，0xFF 后填充 0x00
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray &out)
+        : m_out(out)
+        , m_buffer(0)
+        , m_bits(0)
+    {
+    }
+
+    void put(quint32 value, int count)
+    {
+        m_buffer = (m_buffer << count) | (value & ((1u << count) - 1));
+        m_bits += count;
+        while (m_bits >= 8) {
+            m_bits -= 8;
+            const char byte = static_cast<char>((m_buffer >> m_bits) & 0xFF);
+            m_out.append(byte);
+            if (byte == static_cast<char>(0xFF)) {
+                m_out.append('\0');
+            }
+        }
+        m_buffer &= (1u << m_bits) - 1;
+    }
+
+    // 以 1 补齐最后一个字节
+    void flush()
+    {
+        if (m_bits > 0) {
+            put(0x7F, 8 - m_bits);
+        }
+    }
+
+private:
+    QByteArray &m_out;
+    quint32 m_buffer;
+    int m_bits;
+};
+
+inline int bitLength(int value)
+{
+    int magnitude = value < 0 ? -value : value;
+    int bits = 0;
+    while (magnitude) {
+        ++bits;
+        magnitude >>= 1;
+    }
+    return bits;
+}
+
+// 正交 DCT 基：basis[x][u] = C(u)/2 * cos((2x+1)uπ/16)
+struct DctBasis {
+    double basis[8][8];
+
+    DctBasis()
+    {
+        for (int x = 0; x < 8; ++x) {
+            for (int u = 0; u < 8; ++u) {
+                const double scale = u == 0 ? 0.5 / std::sqrt(2.0) : 0.5;
+                basis[x][u] = scale * std::cos((2 * x + 1) * u * M_PI / 16.0);
+            }
+        }
+    }
+};
+
+// 跨越源图右、下边缘的块：超出源图的像素改为背景值后重新量化
+void fillBlockOutside(const qint16 *source, qint16 *target, const quint16 *quant,
+                      int validColumns, int validRows, double background)
+{
+    static const DctBasis dct;
+    double coefficients[64];
+    for (int k = 0; k < 64; ++k) {
+        coefficients[ZIGZAG_TO_NATURAL[k]] = source[k] * static_cast<double>(quant[k]);
+    }
+
+    // 反变换到电平平移后的像素（保留小数，源图部分不引入额外的取整）
+    double temp[64];
+    double pixels[64];
+    for (int v = 0; v < 8; ++v) {
+        for (int x = 0; x < 8; ++x) {
+            double sum = 0.0;
+            for (int u = 0; u < 8; ++u) {
+                sum += dct.basis[x][u] * coefficients[v * 8 + u];
+            }
+            temp[v * 8 + x] = sum;
+        }
+    }
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            double sum = 0.0;
+            for (int v = 0; v < 8; ++v) {
+                sum += dct.basis[y][v] * temp[v * 8 + x];
+            }
+            pixels[y * 8 + x] = (x < validColumns && y < validRows) ? sum : background;
+        }
+    }
+
+    // 正变换并按原量化表量化
+    for (int y = 0; y < 8; ++y) {
+        for (int u = 0; u < 8; ++u) {
+            double sum = 0.0;
+            for (int x = 0; x < 8; ++x) {
+                sum += dct.basis[x][u] * pixels[y * 8 + x];
+            }
+            temp[y * 8 + u] = sum;
+        }
+    }
+    for (int v = 0; v < 8; ++v) {
+        for (int u = 0; u < 8; ++u) {
+            double sum = 0.0;
+            for (int y = 0; y < 8; ++y) {
+                sum += dct.basis[y][v] * temp[y * 8 + u];
+            }
+            coefficients[v * 8 + u] = sum;
+        }
+    }
+    // 基线格式中直流系数不超过 11 位，交流系数不超过 10 位
+    for (int k = 0; k < 64; ++k) {
+        const int limit = k == 0 ? 2047 : 1023;
+        target[k] = static_cast<qint16>(qBound(-limit, qRound(coefficients[ZIGZAG_TO_NATURAL[k]] / quant[k]), limit));
+    }
+}
+
+// 输出分量的系数块来源：源图块、边缘重新量化的块或纯色块
+struct OutputComponent {
+    const qint16 *source;
+    int sourceStride;           // 源系数网格每行的块数
+    int sourceBlocksX;          // 含源图像素的块数
+    int sourceBlocksY;
+    int offsetX;                // 源图在输出网格中的块偏移
+    int offsetY;
+    bool fixColumn;             // 最右一列块需要重新量化
+    bool fixRow;
+    std::vector<qint16> rightColumn;
+    std::vector<qint16> bottomRow;
+    qint16 background[64];
+    int table;                  // 哈夫曼表号
+
+    const qint16 *block(int x, int y) const
+    {
+        const int sx = x - offsetX;
+        const int sy = y - offsetY;
+        if (sx < 0 || sy < 0 || sx >= sourceBlocksX || sy >= sourceBlocksY) {
+            return background;
+        }
+        if (fixColumn && sx == sourceBlocksX - 1) {
+            return &rightColumn[sy * 64];
+        }
+        if (fixRow && sy == sourceBlocksY - 1) {
+            return &bottomRow[sx * 64];
+        }
+        return source + (static_cast<size_t>(sy) * sourceStride + sx) * 64;
+    }
+};
+
+} // namespace
+
+JpegPadder::JpegPadder()
+    : m_width(0)
+    , m_height(0)
+    , m_maxH(1)
+    , m_maxV(1)
+    , m_progressive(false)
+    , m_hasFrame(false)
+    , m_loaded(false)
+    , m_orientation(1)
+    , m_colorTransform(YCbCrColor)
+{
+    std::memset(m_quantTables, 0, sizeof(m_quantTables));
+    std::fill(m_quantDefined, m_quantDefined + 4, false);
+}
+
+bool JpegPadder::readHeader(const QByteArray &data)
+{
+    return parse(data, false, nullptr, ProgressCallback());
+}
+
+bool JpegPadder::load(const QByteArray &data, const std::atomic<bool> *cancelled,
+                      const ProgressCallback &progress)
+{
+    return parse(data, true, cancelled, progress);
+}
+
+bool JpegPadder::fail(const QString &message)
+{
+    m_errorString = message;
+    return false;
+}
+
+bool JpegPadder::parse(const QByteArray &data, bool decodeScans,
+                       const std::atomic<bool> *cancelled, const ProgressCallback &progress)
+{
+    m_hasFrame = false;
+    m_loaded = false;
+    m_orientation = 1;
+    m_components.clear();
+    m_preservedMarkers.clear();
+    m_errorString.clear();
+    std::fill(m_quantDefined, m_quantDefined + 4, false);
+
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+    const size_t size = static_cast<size_t>(data.size());
+    if (size < 4 || bytes[0] != 0xFF || bytes[1] != SOI) {
+        return fail("不是 JPEG 文件");
+    }
+
+    HuffmanDecoder dcTables[4];
+    HuffmanDecoder acTables[4];
+    int restartInterval = 0;
+    bool hasJfif = false;
+    bool hasAdobe = false;
+    int adobeTransform = 1;
+    bool scanned = false;
+    size_t position = 2;
+
+    for (;;) {
+        if (cancelled && cancelled->load()) {
+            return fail("导出已取消");
+        }
+        // 跳到下一个标记（允许标记前的填充 0xFF）
+        while (position < size && bytes[position] != 0xFF) {
+            ++position;
+        }
+        while (position < size && bytes[position] == 0xFF) {
+            ++position;
+        }
+        if (position >= size) {
+            break;
+        }
+        const int marker = bytes[position++];
+        if (marker == EOI) {
+            break;
+        }
+        if (marker == SOI || (marker >= RST0 && marker <= RST7)) {
+            continue;
+        }
+        if (position + 2 > size) {
+            return fail("JPEG 数据不完整");
+        }
+        const int length = readU16(bytes + position);
+        if (length < 2 || position + length > size) {
+            return fail("JPEG 标记段长度无效");
+        }
+        const uchar *segment = bytes + position + 2;
+        const int segmentSize = length - 2;
+        const size_t segmentEnd = position + length;
+
+        if ((marker >= APP0 && marker <= APP15) || marker == COM) {
+            if (marker == APP0 && segmentSize >= 5 && std::memcmp(segment, "JFIF\0", 5) == 0) {
+                hasJfif = true;
+            } else if (marker == APP1) {
+                m_orientation = parseExifOrientation(segment, segmentSize);
+            } else if (marker == APP14 && segmentSize >= 12 && std::memcmp(segment, "Adobe", 5) == 0) {
+                hasAdobe = true;
+                adobeTransform = segment[11];
+            }
+            if (!scanned) {
+                m_preservedMarkers.append(reinterpret_cast<const char *>(bytes + position - 2), length + 2);
+            }
+        } else if (marker == DQT) {
+            int offset = 0;
+            while (offset < segmentSize) {
+                const int precision = segment[offset] >> 4;
+                const int id = segment[offset] & 15;
+                const int tableSize = precision ? 128 : 64;
+                if (id > 3 || precision > 1 || offset + 1 + tableSize > segmentSize) {
+                    return fail("量化表无效");
+                }
+                for (int k = 0; k < 64; ++k) {
+                    const uchar *value = segment + offset + 1 + (precision ? k * 2 : k);
+                    m_quantTables[id][k] = static_cast<quint16>(precision ? readU16(value) : value[0]);
+                    if (m_quantTables[id][k] == 0) {
+                        return fail("量化表无效");
+                    }
+                }
+                m_quantDefined[id] = true;
+                offset += 1 + tableSize;
+            }
+        } else if (marker == DHT) {
+            int offset = 0;
+            while (offset + 17 <= segmentSize) {
+                const int tableClass = segment[offset] >> 4;
+                const int id = segment[offset] & 15;
+                int count = 0;
+                for (int i = 0; i < 16; ++i) {
+                    count += segment[offset + 1 + i];
+                }
+                if (tableClass > 1 || id > 3 || count > 256 || offset + 17 + count > segmentSize) {
+                    return fail("哈夫曼表无效");
+                }
+                HuffmanDecoder &table = tableClass ? acTables[id] : dcTables[id];
+                if (!table.build(segment + offset + 1, segment + offset + 17, count)) {
+                    return fail("哈夫曼表无效");
+                }
+                offset += 17 + count;
+            }
+        } else if (marker == DRI) {
+            if (segmentSize < 2) {
+                return fail("重启间隔无效");
+            }
+            restartInterval = readU16(segment);
+        } else if (marker == SOF0 || marker == SOF1 || marker == SOF2) {
+            if (m_hasFrame || segmentSize < 6) {
+                return fail("帧头无效");
+            }
+            if (segment[0] != 8) {
+                return fail("只支持 8 位精度的 JPEG");
+            }
+            m_progressive = marker == SOF2;
+            m_height = readU16(segment + 1);
+            m_width = readU16(segment + 3);
+            const int count = segment[5];
+            if (m_width == 0 || m_height == 0) {
+                return fail("不支持高度由 DNL 标记给出的 JPEG");
+            }
+            if ((count != 1 && count != 3) || segmentSize < 6 + count * 3) {
+                return fail("只支持灰度与三分量 JPEG");
+            }
+            m_maxH = 1;
+            m_maxV = 1;
+            for (int i = 0; i < count; ++i) {
+                Component component = Component();
+                component.id = segment[6 + i * 3];
+                component.h = segment[7 + i * 3] >> 4;
+                component.v = segment[7 + i * 3] & 15;
+                component.quantTable = segment[8 + i * 3];
+                if (component.h < 1 || component.h > 4 || component.v < 1 || component.v > 4
+                    || component.quantTable > 3) {
+                    return fail("帧头无效");
+                }
+                // 单分量图像总是按单块 MCU 处理
+                if (count == 1) {
+                    component.h = 1;
+                    component.v = 1;
+                }
+                m_maxH = qMax(m_maxH, component.h);
+                m_maxV = qMax(m_maxV, component.v);
+                m_components.push_back(component);
+            }
+            const int mcusX = (m_width + 8 * m_maxH - 1) / (8 * m_maxH);
+            const int mcusY = (m_height + 8 * m_maxV - 1) / (8 * m_maxV);
+            for (Component &component : m_components) {
+                component.width = (m_width * component.h + m_maxH - 1) / m_maxH;
+                component.height = (m_height * component.v + m_maxV - 1) / m_maxV;
+                component.blocksPerLine = mcusX * component.h;
+                component.blocksPerColumn = mcusY * component.v;
+            }
+            if (count == 1) {
+                m_colorTransform = GrayColor;
+            } else if (hasAdobe) {
+                m_colorTransform = adobeTransform == 0 ? RgbColor : YCbCrColor;
+            } else if (!hasJfif && m_components[0].id == 'R' && m_components[1].id == 'G'
+                       && m_components[2].id == 'B') {
+                m_colorTransform = RgbColor;
+            } else {
+                m_colorTransform = YCbCrColor;
+            }
+            m_hasFrame = true;
+        } else if (marker >= 0xC3 && marker <= 0xCF && marker != DHT && marker != 0xC8) {
+            return fail(marker >= 0xC9 ? "不支持算术编码的 JPEG" : "不支持无损或分层 JPEG");
+        } else if (marker == DNL) {
+            return fail("不支持 DNL 标记");
+        } else if (marker == SOS) {
+            if (!m_hasFrame) {
+                return fail("扫描出现在帧头之前");
+            }
+            for (const Component &component : m_components) {
+                if (!m_quantDefined[component.quantTable]) {
+                    return fail("缺少量化表");
+                }
+            }
+            if (!decodeScans) {
+                return true;
+            }
+            if (!scanned) {
+                for (Component &component : m_components) {
+                    component.coefficients.assign(static_cast<size_t>(component.blocksPerLine)
+                                                  * component.blocksPerColumn * 64, 0);
+                }
+                scanned = true;
+            }
+
+            ScanState scan;
+            const int count = segmentSize > 0 ? segment[0] : 0;
+            if (count < 1 || count > static_cast<int>(m_components.size()) || segmentSize < 4 + count * 2) {
+                return fail("扫描头无效");
+            }
+            for (int i = 0; i < count; ++i) {
+                const int id = segment[1 + i * 2];
+                int index = -1;
+                for (size_t c = 0; c < m_components.size(); ++c) {
+                    if (m_components[c].id == id) {
+                        index = static_cast<int>(c);
+                    }
+                }
+                if (index < 0) {
+                    return fail("扫描头无效");
+                }
+                scan.components.push_back(index);
+                scan.dcTable[i] = segment[2 + i * 2] >> 4;
+                scan.acTable[i] = segment[2 + i * 2] & 15;
+                if (scan.dcTable[i] > 3 || scan.acTable[i] > 3) {
+                    return fail("扫描头无效");
+                }
+            }
+            scan.spectralStart = segment[1 + count * 2];
+            scan.spectralEnd = segment[2 + count * 2];
+            scan.approximationHigh = segment[3 + count * 2] >> 4;
+            scan.approximationLow = segment[3 + count * 2] & 15;
+            scan.eobRun = 0;
+            std::fill(scan.dcPredictors, scan.dcPredictors + 4, 0);
+
+            enum { Sequential, DcFirst, DcRefine, AcFirst, AcRefine } mode = Sequential;
+            if (m_progressive) {
+                const bool dc = scan.spectralStart == 0;
+                if ((dc && scan.spectralEnd != 0) || (!dc && (scan.spectralEnd < scan.spectralStart
+                                                              || scan.spectralEnd > 63 || count != 1))) {
+                    return fail("渐进式扫描参数无效");
+                }
+                mode = dc ? (scan.approximationHigh ? DcRefine : DcFirst)
+                          : (scan.approximationHigh ? AcRefine : AcFirst);
+            } else if (scan.spectralStart != 0 || scan.spectralEnd != 63) {
+                return fail("扫描头无效");
+            }
+            for (int i = 0; i < count; ++i) {
+                const bool needsDc = mode == Sequential || mode == DcFirst;
+                const bool needsAc = mode == Sequential || mode == AcFirst || mode == AcRefine;
+                if ((needsDc && !dcTables[scan.dcTable[i]].defined)
+                    || (needsAc && !acTables[scan.acTable[i]].defined)) {
+                    return fail("缺少哈夫曼表");
+                }
+            }
+
+            BitReader reader(bytes, size, segmentEnd);
+            const auto decodeBlock = [&](int slot, qint16 *block) {
+                switch (mode) {
+                case Sequential:
+                    return decodeSequentialBlock(reader, block, scan.dcPredictors[slot],
+                                                 dcTables[scan.dcTable[slot]], acTables[scan.acTable[slot]]);
+                case DcFirst:
+                    return decodeDcFirst(reader, block, scan.dcPredictors[slot],
+                                         dcTables[scan.dcTable[slot]], scan.approximationLow);
+                case DcRefine:
+                    decodeDcRefine(reader, block, scan.approximationLow);
+                    return true;
+                case AcFirst:
+                    return decodeAcFirst(reader, block, scan, acTables[scan.acTable[slot]]);
+                case AcRefine:
+                    return decodeAcRefine(reader, block, scan, acTables[scan.acTable[slot]]);
+                }
+                return false;
+            };
+
+            // 单分量扫描按分量自身的块网格逐块编码，多分量扫描按 MCU 交织
+            int unitsX;
+            int unitsY;
+            if (count == 1) {
+                const Component &component = m_components[scan.components[0]];
+                unitsX = (component.width + 7) / 8;
+                unitsY = (component.height + 7) / 8;
+            } else {
+                unitsX = (m_width + 8 * m_maxH - 1) / (8 * m_maxH);
+                unitsY = (m_height + 8 * m_maxV - 1) / (8 * m_maxV);
+            }
+            int unitsToRestart = restartInterval;
+            for (int uy = 0; uy < unitsY; ++uy) {
+                if (cancelled && cancelled->load()) {
+                    return fail("导出已取消");
+                }
+                for (int ux = 0; ux < unitsX; ++ux) {
+                    if (restartInterval) {
+                        if (unitsToRestart == 0) {
+                            if (!reader.restart()) {
+                                return fail("JPEG 重启标记缺失");
+                            }
+                            unitsToRestart = restartInterval;
+                            scan.eobRun = 0;
+                            std::fill(scan.dcPredictors, scan.dcPredictors + 4, 0);
+                        }
+                        --unitsToRestart;
+                    }
+                    for (int slot = 0; slot < count; ++slot) {
+                        Component &component = m_components[scan.components[slot]];
+                        const int blocksX = count == 1 ? 1 : component.h;
+                        const int blocksY = count == 1 ? 1 : component.v;
+                        for (int by = 0; by < blocksY; ++by) {
+                            for (int bx = 0; bx < blocksX; ++bx) {
+                                const int x = count == 1 ? ux : ux * component.h + bx;
+                                const int y = count == 1 ? uy : uy * component.v + by;
+                                qint16 *block = &component.coefficients[
+                                    (static_cast<size_t>(y) * component.blocksPerLine + x) * 64];
+                                if (!decodeBlock(slot, block)) {
+                                    return fail("JPEG 熵编码数据损坏");
+                                }
+                            }
+                        }
+                    }
+                }
+                if (progress) {
+                    progress(static_cast<int>(reader.position() * 100 / size));
+                }
+            }
+            position = reader.nextMarkerPosition();
+            continue;
+        }
+        position = segmentEnd;
+    }
+
+    if (!m_hasFrame) {
+        return fail("JPEG 缺少帧头");
+    }
+    if (decodeScans && !scanned) {
+        return fail("JPEG 没有图像数据");
+    }
+    m_loaded = decodeScans;
+    return true;
+}
+
+QSize JpegPadder::size() const
+{
+    return m_orientation >= 5 ? QSize(m_height, m_width) : QSize(m_width, m_height);
+}
+
+QSize JpegPadder::mcuSize() const
+{
+    return m_orientation >= 5 ? QSize(8 * m_maxV, 8 * m_maxH) : QSize(8 * m_maxH, 8 * m_maxV);
+}
+
+bool JpegPadder::isGrayscale() const
+{
+    return m_colorTransform == GrayColor;
+}
+
+bool JpegPadder::canRepresent(const QColor &color) const
+{
+    return !isGrayscale() || (color.red() == color.green() && color.green() == color.blue());
+}
+
+JpegPadder::Margins JpegPadder::toStored(const Margins &m) const
+{
+    // 存储方向的各边在显示方向中的位置
+    switch (m_orientation) {
+    case 2: return Margins{m.top, m.bottom, m.right, m.left};
+    case 3: return Margins{m.bottom, m.top, m.right, m.left};
+    case 4: return Margins{m.bottom, m.top, m.left, m.right};
+    case 5: return Margins{m.left, m.right, m.top, m.bottom};
+    case 6: return Margins{m.right, m.left, m.top, m.bottom};
+    case 7: return Margins{m.right, m.left, m.bottom, m.top};
+    case 8: return Margins{m.left, m.right, m.bottom, m.top};
+    default: return m;
+    }
+}
+
+JpegPadder::Margins JpegPadder::toDisplay(const Margins &m) const
+{
+    switch (m_orientation) {
+    case 2: return Margins{m.top, m.bottom, m.right, m.left};
+    case 3: return Margins{m.bottom, m.top, m.right, m.left};
+    case 4: return Margins{m.bottom, m.top, m.left, m.right};
+    case 5: return Margins{m.left, m.right, m.top, m.bottom};
+    case 6: return Margins{m.left, m.right, m.bottom, m.top};
+    case 7: return Margins{m.right, m.left, m.bottom, m.top};
+    case 8: return Margins{m.right, m.left, m.top, m.bottom};
+    default: return m;
+    }
+}
+
+JpegPadder::Margins JpegPadder::alignedMargins(const Margins &requested) const
+{
+    Margins stored = toStored(requested);
+    const int mcuWidth = 8 * m_maxH;
+    const int mcuHeight = 8 * m_maxV;
+    stored.left = (qMax(0, stored.left) + mcuWidth - 1) / mcuWidth * mcuWidth;
+    stored.top = (qMax(0, stored.top) + mcuHeight - 1) / mcuHeight * mcuHeight;
+    stored.right = qMax(0, stored.right);
+    stored.bottom = qMax(0, stored.bottom);
+    return toDisplay(stored);
+}
+
+bool JpegPadder::pad(const Margins &margins, const QColor &color, QIODevice *device,
+                     const std::atomic<bool> *cancelled, const ProgressCallback &progress)
+{
+    if (!m_loaded) {
+        return fail("JPEG 系数尚未解码");
+    }
+    const Margins stored = toStored(margins);
+    const int mcuWidth = 8 * m_maxH;
+    const int mcuHeight = 8 * m_maxV;
+    if (stored.left < 0 || stored.top < 0 || stored.right < 0 || stored.bottom < 0
+        || stored.left % mcuWidth || stored.top % mcuHeight) {
+        return fail("边距未按 MCU 对齐");
+    }
+    const int width = stored.left + m_width + stored.right;
+    const int height = stored.top + m_height + stored.bottom;
+    if (width > MAX_DIMENSION || height > MAX_DIMENSION) {
+        return fail("扩展后的尺寸超出 JPEG 的上限 65535");
+    }
+    if (!canRepresent(color)) {
+        return fail("灰度 JPEG 无法写出彩色背景");
+    }
+
+    // 背景色在源图色彩空间中的分量值
+    double values[3];
+    const double r = color.red();
+    const double g = color.green();
+    const double b = color.blue();
+    if (m_colorTransform == GrayColor) {
+        values[0] = 0.299 * r + 0.587 * g + 0.114 * b;
+    } else if (m_colorTransform == RgbColor) {
+        values[0] = r;
+        values[1] = g;
+        values[2] = b;
+    } else {
+        values[0] = 0.299 * r + 0.587 * g + 0.114 * b;
+        values[1] = -0.168736 * r - 0.331264 * g + 0.5 * b + 128.0;
+        values[2] = 0.5 * r - 0.418688 * g - 0.081312 * b + 128.0;
+    }
+
+    const int mcusX = (width + mcuWidth - 1) / mcuWidth;
+    const int mcusY = (height + mcuHeight - 1) / mcuHeight;
+    const int count = static_cast<int>(m_components.size());
+    std::vector<OutputComponent> outputs(count);
+    for (int c = 0; c < count; ++c) {
+        const Component &component = m_components[c];
+        const quint16 *quant = m_quantTables[component.quantTable];
+        OutputComponent &output = outputs[c];
+        output.source = component.coefficients.data();
+        output.sourceStride = component.blocksPerLine;
+        output.sourceBlocksX = (component.width + 7) / 8;
+        output.sourceBlocksY = (component.height + 7) / 8;
+        output.offsetX = stored.left / mcuWidth * component.h;
+        output.offsetY = stored.top / mcuHeight * component.v;
+        output.table = c == 0 ? 0 : 1;
+
+        // 直流系数为 8 倍的电平平移后像素值
+        const double level = values[c] - 128.0;
+        std::fill(output.background, output.background + 64, 0);
+        output.background[0] = static_cast<qint16>(qBound(-2047, qRound(8.0 * level / quant[0]), 2047));
+
+        // 源图右、下边缘不足一块时，块内的编码填充在扩展后会露出，改为背景
+        const int outputWidth = (width * component.h + m_maxH - 1) / m_maxH;
+        const int outputHeight = (height * component.v + m_maxV - 1) / m_maxV;
+        const int columns = component.width % 8;
+        const int rows = component.height % 8;
+        output.fixColumn = columns && outputWidth > output.offsetX * 8 + component.width;
+        output.fixRow = rows && outputHeight > output.offsetY * 8 + component.height;
+        if (output.fixColumn) {
+            output.rightColumn.resize(static_cast<size_t>(output.sourceBlocksY) * 64);
+            for (int y = 0; y < output.sourceBlocksY; ++y) {
+                const bool corner = output.fixRow && y == output.sourceBlocksY - 1;
+                fillBlockOutside(output.source + (static_cast<size_t>(y) * output.sourceStride
+                                                  + output.sourceBlocksX - 1) * 64,
+                                 &output.rightColumn[y * 64], quant, columns, corner ? rows : 8, level);
+            }
+        }
+        if (output.fixRow) {
+            output.bottomRow.resize(static_cast<size_t>(output.sourceBlocksX) * 64);
+            for (int x = 0; x < output.sourceBlocksX; ++x) {
+                const bool corner = output.fixColumn && x == output.sourceBlocksX - 1;
+                fillBlockOutside(output.source + (static_cast<size_t>(output.sourceBlocksY - 1)
+                                                  * output.sourceStride + x) * 64,
+                                 &output.bottomRow[x * 64], quant, corner ? columns : 8, rows, level);
+            }
+        }
+    }
+
+    // 按输出顺序遍历所有块：第一遍统计符号频率，第二遍编码
+    const auto forEachBlock = [&](const std::function<void(int, const qint16 *)> &visit, int progressBase) {
+        for (int my = 0; my < mcusY; ++my) {
+            if (cancelled && cancelled->load()) {
+                return false;
+            }
+            for (int mx = 0; mx < mcusX; ++mx) {
+                for (int c = 0; c < count; ++c) {
+                    const Component &component = m_components[c];
+                    for (int by = 0; by < component.v; ++by) {
+                        for (int bx = 0; bx < component.h; ++bx) {
+                            visit(c, outputs[c].block(mx * component.h + bx, my * component.v + by));
+                        }
+                    }
+                }
+            }
+            if (progress) {
+                progress(progressBase + (my + 1) * 50 / mcusY);
+            }
+        }
+        return true;
+    };
+
+    quint64 dcFrequencies[2][256];
+    quint64 acFrequencies[2][256];
+    std::memset(dcFrequencies, 0, sizeof(dcFrequencies));
+    std::memset(acFrequencies, 0, sizeof(acFrequencies));
+    int predictors[3] = {0, 0, 0};
+    const bool counted = forEachBlock([&](int c, const qint16 *block) {
+        const int table = outputs[c].table;
+        ++dcFrequencies[table][bitLength(block[0] - predictors[c])];
+        predictors[c] = block[0];
+        int run = 0;
+        for (int k = 1; k < 64; ++k) {
+            if (block[k] == 0) {
+                ++run;
+                continue;
+            }
+            while (run > 15) {
+                ++acFrequencies[table][0xF0];
+                run -= 16;
+            }
+            ++acFrequencies[table][(run << 4) | bitLength(block[k])];
+            run = 0;
+        }
+        if (run) {
+            ++acFrequencies[table][0x00];
+        }
+    }, 0);
+    if (!counted) {
+        return fail("导出已取消");
+    }
+
+    QByteArray out;
+    out.reserve(64 * 1024);
+    out.append(static_cast<char>(0xFF));
+    out.append(static_cast<char>(SOI));
+    out.append(m_preservedMarkers);
+
+    // 量化表原样写出
+    bool extended = false;
+    for (int id = 0; id < 4; ++id) {
+        bool used = false;
+        for (const Component &component : m_components) {
+            used = used || component.quantTable == id;
+        }
+        if (!used) {
+            continue;
+        }
+        bool wide = false;
+        for (int k = 0; k < 64; ++k) {
+            wide = wide || m_quantTables[id][k] > 255;
+        }
+        extended = extended || wide;
+        appendMarker(out, DQT, 1 + (wide ? 128 : 64));
+        out.append(static_cast<char>((wide ? 0x10 : 0x00) | id));
+        for (int k = 0; k < 64; ++k) {
+            if (wide) {
+                appendU16(out, m_quantTables[id][k]);
+            } else {
+                out.append(static_cast<char>(m_quantTables[id][k]));
+            }
+        }
+    }
+
+    // 16 位量化表只能用于扩展顺序格式，其余写为基线格式
+    appendMarker(out, extended ? SOF1 : SOF0, 6 + count * 3);
+    out.append(static_cast<char>(8));
+    appendU16(out, height);
+    appendU16(out, width);
+    out.append(static_cast<char>(count));
+    for (const Component &component : m_components) {
+        out.append(static_cast<char>(component.id));
+        out.append(static_cast<char>((component.h << 4) | component.v));
+        out.append(static_cast<char>(component.quantTable));
+    }
+
+    HuffmanEncoder dcEncoders[2];
+    HuffmanEncoder acEncoders[2];
+    const int tableCount = count > 1 ? 2 : 1;
+    for (int table = 0; table < tableCount; ++table) {
+        for (int tableClass = 0; tableClass < 2; ++tableClass) {
+            uchar bits[16];
+            std::vector<uchar> symbols;
+            buildOptimalTable(tableClass ? acFrequencies[table] : dcFrequencies[table], bits, symbols);
+            (tableClass ? acEncoders[table] : dcEncoders[table]).build(bits, symbols);
+            appendMarker(out, DHT, 17 + static_cast<int>(symbols.size()));
+            out.append(static_cast<char>((tableClass << 4) | table));
+            out.append(reinterpret_cast<const char *>(bits), 16);
+            out.append(reinterpret_cast<const char *>(symbols.data()), static_cast<int>(symbols.size()));
+        }
+    }
+
+    appendMarker(out, SOS, 4 + count * 2);
+    out.append(static_cast<char>(count));
+    for (int c = 0; c < count; ++c) {
+        out.append(static_cast<char>(m_components[c].id));
+        out.append(static_cast<char>((outputs[c].table << 4) | outputs[c].table));
+    }
+    out.append(static_cast<char>(0));
+    out.append(static_cast<char>(63));
+    out.append(static_cast<char>(0));
+
+    BitWriter writer(out);
+    std::fill(predictors, predictors + 3, 0);
+    const bool encoded = forEachBlock([&](int c, const qint16 *block) {
+        const HuffmanEncoder &dc = dcEncoders[outputs[c].table];
+        const HuffmanEncoder &ac = acEncoders[outputs[c].table];
+        const int diff = block[0] - predictors[c];
+        predictors[c] = block[0];
+        const int dcBits = bitLength(diff);
+        writer.put(dc.code[dcBits], dc.size[dcBits]);
+        if (dcBits) {
+            writer.put(static_cast<quint32>(diff < 0 ? diff - 1 : diff), dcBits);
+        }
+        int run = 0;
+        for (int k = 1; k < 64; ++k) {
+            const int value = block[k];
+            if (value == 0) {
+                ++run;
+                continue;
+            }
+            while (run > 15) {
+                writer.put(ac.code[0xF0], ac.size[0xF0]);
+                run -= 16;
+            }
+            const int bits = bitLength(value);
+            const int symbol = (run << 4) | bits;
+            writer.put(ac.code[symbol], ac.size[symbol]);
+            writer.put(static_cast<quint32>(value < 0 ? value - 1 : value), bits);
+            run = 0;
+        }
+        if (run) {
+            writer.put(ac.code[0x00], ac.size[0x00]);
+        }
+    }, 50);
+    if (!encoded) {
+        return fail("导出已取消");
+    }
+    writer.flush();
+    out.append(static_cast<char>(0xFF));
+    out.append(static_cast<char>(EOI));
+
+    if (device->write(out) != out.size()) {
+        return fail(device->errorString());
+    }
+    return true;
+}
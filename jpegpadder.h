@@ -0,0 +1,109 @@
+#ifndef JPEGPADDER_H
+#define JPEGPADDER_H
+
+#include <QByteArray>
+#include <QColor>
+#include <QSize>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+class QIODevice;
+
+// JPEG 的 DCT 域无损扩展
+// 只做熵解码得到量化后的 DCT 系数（支持基线、扩展顺序与渐进式哈夫曼编码），
+// 原始系数块原样放入更大的系数网格，边距为只含直流分量的纯色块，
+// 再以基线格式和优化的哈夫曼表写出，源图内容不经过反变换与重新量化。
+// 左、上边距必须为 MCU 尺寸的整数倍；源图宽高不是块尺寸的整数倍时，
+// 落在右、下边缘的块同时包含源图与边距，只有这一列（行）块在像素域重新量化
+class JpegPadder
+{
+public:
+    // 显示方向（已按 EXIF 方向校正）的边距
+    struct Margins {
+        int top;
+        int bottom;
+        int left;
+        int right;
+    };
+
+    // 参数为当前阶段的完成百分比
+    typedef std::function<void(int percent)> ProgressCallback;
+
+    JpegPadder();
+
+    // 只解析到第一个扫描之前的标记段，用于判断能否无损处理并计算对齐后的边距；
+    // data 可以只是文件开头的一部分，通常 HEADER_PROBE_BYTES 字节即可包含全部标记段
+    bool readHeader(const QByteArray &data);
+    // 解析全部标记段并熵解码所有扫描的系数
+    bool load(const QByteArray &data, const std::atomic<bool> *cancelled = nullptr,
+              const ProgressCallback &progress = ProgressCallback());
+
+    // 显示方向的图像尺寸与 MCU 尺寸
+    QSize size() const;
+    QSize mcuSize() const;
+
+    // 源图只有一个灰度分量时边距只能写出亮度，彩色背景无法无损表示
+    bool isGrayscale() const;
+    bool canRepresent(const QColor &color) const;
+
+    // 把请求的边距调整为可无损放置的边距：
+    // 源数据中位于左、上方向的边距向上取整到 MCU 尺寸的整数倍
+    Margins alignedMargins(const Margins &requested) const;
+
+    // 写出扩展后的 JPEG；margins 须已经过 alignedMargins 调整，背景色忽略 alpha，
+    // 且须满足 canRepresent
+    bool pad(const Margins &margins, const QColor &color, QIODevice *device,
+             const std::atomic<bool> *cancelled = nullptr,
+             const ProgressCallback &progress = ProgressCallback());
+
+    QString errorString() const { return m_errorString; }
+
+    static constexpr int HEADER_PROBE_BYTES = 256 * 1024;
+
+private:
+    // 帧中的颜色分量
+    struct Component {
+        int id;
+        int h;                      // 水平采样因子
+        int v;                      // 垂直采样因子
+        int quantTable;
+        int width;                  // 分量的采样宽度
+        int height;
+        int blocksPerLine;          // 系数网格按整 MCU 分配
+        int blocksPerColumn;
+        std::vector<qint16> coefficients;   // 每块 64 个系数，按 Z 字形顺序
+    };
+
+    enum ColorTransform {
+        GrayColor,
+        YCbCrColor,
+        RgbColor
+    };
+
+    bool parse(const QByteArray &data, bool decodeScans,
+               const std::atomic<bool> *cancelled, const ProgressCallback &progress);
+    bool fail(const QString &message);
+
+    // 显示方向与存储方向的边距互换
+    Margins toStored(const Margins &margins) const;
+    Margins toDisplay(const Margins &margins) const;
+
+    int m_width;
+    int m_height;
+    int m_maxH;
+    int m_maxV;
+    bool m_progressive;
+    bool m_hasFrame;
+    bool m_loaded;
+    int m_orientation;          // EXIF 方向 1-8
+    ColorTransform m_colorTransform;
+    std::vector<Component> m_components;
+    quint16 m_quantTables[4][64];   // Z 字形顺序
+    bool m_quantDefined[4];
+    QByteArray m_preservedMarkers;  // 原样保留的 APPn 与 COM 段
+    QString m_errorString;
+};
+
+#endif // JPEGPADDER_H
@@ -1,10 +1,21 @@
 #include <QApplication>
+#include <QCoreApplication>
 #include <QStyleFactory>
 #include <QDir>
 #include "mainwindow.h"
+#include "clicommands.h"
 
 int main(int argc, char *argv[])
 {
+    // 命令行模式不创建图形界面，可在无显示环境中运行
+    if (CliCommands::isCommandLineMode(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        app.setApplicationName("Image Background Expander");
+        app.setApplicationVersion("1.0.0");
+        app.setOrganizationName("Image Tools");
+        return CliCommands::run(app);
+    }
+    
     QApplication app(argc, argv);
     
     // 设置应用程序信息
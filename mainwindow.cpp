@@ -1,6 +1,7 @@
 #include "mainwindow.h"
 #include "imageviewer.h"
 #include "imageprocessor.h"
+#include "variantexporter.h"
 #include <QApplication>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
@@ -9,6 +10,7 @@
 #include <QScrollArea>
 #include <QGroupBox>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
 #include <QPushButton>
 #include <QCheckBox>
 #include <QColorDialog>
@@ -25,6 +27,11 @@
 #include <QComboBox>
 #include <QRegularExpression>
 #include <QRegularExpressionValidator>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QFile>
+#include <memory>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -34,6 +41,7 @@ MainWindow::MainWindow(QWidget *parent)
     , m_imageViewer(nullptr)
     , m_controlPanel(nullptr)
     , m_imageProcessor(nullptr)
+    , m_imageExporter(nullptr)
     , m_selectedColor(Qt::white)
     , m_previewEnabled(true)
 {
@@ -43,6 +51,7 @@ MainWindow::MainWindow(QWidget *parent)
     
     // 创建核心组件
     m_imageProcessor = new ImageProcessor(this);
+    m_imageExporter = new ImageExporter(this);
     
     // 创建界面
     createCentralWidget();
@@ -56,6 +65,11 @@ MainWindow::MainWindow(QWidget *parent)
     // 加载上次选择的路径
     loadLastImageDirectory();
     
+    // 加载预览调度设置
+    loadSchedulerSettings();
+    loadOutputSettings();
+    loadCanvasConstraints();
+    
     // 初始状态
     setControlsEnabled(false);
     updateStatusBar();
@@ -166,16 +180,34 @@ void MainWindow::createControlPanel()
     m_distributionCombo->addItem("居中分布", "center");
     ratioLayout->addWidget(m_distributionCombo, 2, 1);
     
+    // 画布约束
+    ratioLayout->addWidget(new QLabel("画布对齐:"), 3, 0);
+    m_canvasAlignmentCombo = new QComboBox;
+    m_canvasAlignmentCombo->addItem("不对齐", 1);
+    m_canvasAlignmentCombo->addItem("8 像素", 8);
+    m_canvasAlignmentCombo->addItem("16 像素", 16);
+    m_canvasAlignmentCombo->setToolTip("画布尺寸与源图偏移对齐到 JPEG MCU 或视频宏块，编码更快并支持无损分块操作");
+    ratioLayout->addWidget(m_canvasAlignmentCombo, 3, 1);
+    
+    ratioLayout->addWidget(new QLabel("像素上限:"), 4, 0);
+    m_maxCanvasMegapixelsSpinBox = new QDoubleSpinBox;
+    m_maxCanvasMegapixelsSpinBox->setRange(0.0, 1000.0);
+    m_maxCanvasMegapixelsSpinBox->setDecimals(1);
+    m_maxCanvasMegapixelsSpinBox->setSuffix(" MP");
+    m_maxCanvasMegapixelsSpinBox->setSpecialValueText("不限");
+    m_maxCanvasMegapixelsSpinBox->setToolTip("画布的最大像素数（百万像素），0 为不限");
+    ratioLayout->addWidget(m_maxCanvasMegapixelsSpinBox, 4, 1);
+    
     // 应用按钮
     m_applyRatioButton = new QPushButton("计算并应用比例");
     m_applyRatioButton->setEnabled(false);
-    ratioLayout->addWidget(m_applyRatioButton, 3, 0, 1, 2);
+    ratioLayout->addWidget(m_applyRatioButton, 5, 0, 1, 2);
     
     // 计算结果显示
     m_calculationInfoLabel = new QLabel("请输入目标比例，计算后会自动填充上方的扩展框");
     m_calculationInfoLabel->setWordWrap(true);
     m_calculationInfoLabel->setStyleSheet("color: gray; font-size: 10px;");
-    ratioLayout->addWidget(m_calculationInfoLabel, 4, 0, 1, 2);
+    ratioLayout->addWidget(m_calculationInfoLabel, 6, 0, 1, 2);
     
     mainLayout->addWidget(m_ratioGroup);
     
@@ -191,10 +223,123 @@ void MainWindow::createControlPanel()
     m_colorLabel->setWordWrap(true);
     m_colorLabel->setStyleSheet("color: gray;");
     
+    m_fillModeCombo = new QComboBox;
+    m_fillModeCombo->addItem("纯色填充", ImageProcessor::SolidFill);
+    m_fillModeCombo->addItem("边缘拉伸", ImageProcessor::EdgeStretchFill);
+    m_fillModeCombo->addItem("镜像", ImageProcessor::ReflectFill);
+    m_fillModeCombo->addItem("镜像（不重复边缘）", ImageProcessor::Reflect101Fill);
+    m_fillModeCombo->addItem("平铺", ImageProcessor::WrapFill);
+    m_fillModeCombo->addItem("模糊延伸", ImageProcessor::BlurredEdgeFill);
+    m_fillModeCombo->addItem("内容感知", ImageProcessor::ContentAwareFill);
+    m_fillModeCombo->addItem("边缘色场", ImageProcessor::ColorFieldFill);
+    m_fillModeCombo->setToolTip("边距的填充方式");
+    
     colorLayout->addWidget(m_colorButton);
     colorLayout->addWidget(m_colorLabel);
+    m_seamModeCombo = new QComboBox;
+    m_seamModeCombo->addItem("渐变过渡", ImageProcessor::GradientSeam);
+    m_seamModeCombo->addItem("泊松融合", ImageProcessor::PoissonSeam);
+    m_seamModeCombo->setToolTip("源图与边距之间接缝的处理方式");
+    
+    colorLayout->addWidget(new QLabel("填充方式:"));
+    colorLayout->addWidget(m_fillModeCombo);
+    colorLayout->addWidget(new QLabel("接缝处理:"));
+    colorLayout->addWidget(m_seamModeCombo);
     mainLayout->addWidget(m_colorGroup);
     
+    // 渐变过渡设置组（纯色填充 + 渐变接缝时生效）
+    m_gradientGroup = new QGroupBox("渐变设置");
+    QGridLayout *gradientLayout = new QGridLayout(m_gradientGroup);
+    
+    m_gradientCheckBox = new QCheckBox("源图边缘渐变过渡");
+    m_gradientCheckBox->setChecked(m_imageProcessor->gradientEnabled());
+    gradientLayout->addWidget(m_gradientCheckBox, 0, 0, 1, 4);
+    
+    m_linearLightCheckBox = new QCheckBox("线性光混合");
+    m_linearLightCheckBox->setChecked(m_imageProcessor->linearLightBlending());
+    m_linearLightCheckBox->setToolTip("在线性光空间插值颜色，深色接缝过渡更干净");
+    
+    const GradientProfile &profile = m_imageProcessor->gradientProfile();
+    gradientLayout->addWidget(new QLabel("曲线:"), 1, 0);
+    m_gradientCurveCombo = new QComboBox;
+    m_gradientCurveCombo->addItem("线性", GradientProfile::Linear);
+    m_gradientCurveCombo->addItem("平滑", GradientProfile::Smoothstep);
+    m_gradientCurveCombo->addItem("更平滑", GradientProfile::Smootherstep);
+    m_gradientCurveCombo->addItem("指数", GradientProfile::Exponential);
+    m_gradientCurveCombo->addItem("自定义", GradientProfile::Custom);
+    m_gradientCurveCombo->setCurrentIndex(m_gradientCurveCombo->findData(profile.curve()));
+    gradientLayout->addWidget(m_gradientCurveCombo, 1, 1, 1, 3);
+    
+    gradientLayout->addWidget(new QLabel("控制点:"), 2, 0);
+    m_gradientPointsEdit = new QLineEdit;
+    m_gradientPointsEdit->setPlaceholderText("如: 0.3,0.1; 0.7,0.9");
+    m_gradientPointsEdit->setToolTip("自定义曲线的控制点 (距离,过渡进度)，取值 0~1，以分号分隔");
+    m_gradientPointsEdit->setEnabled(profile.curve() == GradientProfile::Custom);
+    gradientLayout->addWidget(m_gradientPointsEdit, 2, 1, 1, 3);
+    
+    gradientLayout->addWidget(new QLabel("强度:"), 3, 0);
+    m_gradientStrengthSpinBox = new QSpinBox;
+    m_gradientStrengthSpinBox->setRange(0, 100);
+    m_gradientStrengthSpinBox->setSuffix(" %");
+    m_gradientStrengthSpinBox->setValue(qRound(profile.strength() * 100));
+    gradientLayout->addWidget(m_gradientStrengthSpinBox, 3, 1, 1, 3);
+    
+    const ImageProcessor::BlendDistances distances = m_imageProcessor->blendDistances();
+    auto createDistanceSpinBox = [](int value) {
+        QSpinBox *spinBox = new QSpinBox;
+        spinBox->setRange(0, 1000);
+        spinBox->setValue(value);
+        spinBox->setSuffix(" px");
+        return spinBox;
+    };
+    m_blendTopSpinBox = createDistanceSpinBox(distances.top);
+    m_blendBottomSpinBox = createDistanceSpinBox(distances.bottom);
+    m_blendLeftSpinBox = createDistanceSpinBox(distances.left);
+    m_blendRightSpinBox = createDistanceSpinBox(distances.right);
+    gradientLayout->addWidget(new QLabel("上:"), 4, 0);
+    gradientLayout->addWidget(m_blendTopSpinBox, 4, 1);
+    gradientLayout->addWidget(new QLabel("下:"), 4, 2);
+    gradientLayout->addWidget(m_blendBottomSpinBox, 4, 3);
+    gradientLayout->addWidget(new QLabel("左:"), 5, 0);
+    gradientLayout->addWidget(m_blendLeftSpinBox, 5, 1);
+    gradientLayout->addWidget(new QLabel("右:"), 5, 2);
+    gradientLayout->addWidget(m_blendRightSpinBox, 5, 3);
+    gradientLayout->addWidget(m_linearLightCheckBox, 6, 0, 1, 4);
+    
+    mainLayout->addWidget(m_gradientGroup);
+    
+    // 导出设置组：直接合成为固定的交付尺寸
+    m_outputGroup = new QGroupBox("导出设置");
+    QGridLayout *outputLayout = new QGridLayout(m_outputGroup);
+    
+    m_outputSizeCheckBox = new QCheckBox("输出为固定尺寸");
+    m_outputSizeCheckBox->setToolTip("扩展与缩放一步完成，不生成全分辨率画布；源图按统一比例缩放，比例不一致时多出的空间归入边距");
+    outputLayout->addWidget(m_outputSizeCheckBox, 0, 0, 1, 4);
+    
+    m_outputWidthSpinBox = new QSpinBox;
+    m_outputWidthSpinBox->setRange(1, 20000);
+    m_outputWidthSpinBox->setValue(1080);
+    m_outputWidthSpinBox->setSuffix(" px");
+    m_outputHeightSpinBox = new QSpinBox;
+    m_outputHeightSpinBox->setRange(1, 20000);
+    m_outputHeightSpinBox->setValue(1350);
+    m_outputHeightSpinBox->setSuffix(" px");
+    outputLayout->addWidget(new QLabel("宽:"), 1, 0);
+    outputLayout->addWidget(m_outputWidthSpinBox, 1, 1);
+    outputLayout->addWidget(new QLabel("高:"), 1, 2);
+    outputLayout->addWidget(m_outputHeightSpinBox, 1, 3);
+    
+    m_resampleFilterCombo = new QComboBox;
+    m_resampleFilterCombo->addItem("Lanczos-3（最清晰）", Resampler::Lanczos3);
+    m_resampleFilterCombo->addItem("双三次", Resampler::Bicubic);
+    m_resampleFilterCombo->addItem("双线性", Resampler::Bilinear);
+    m_resampleFilterCombo->addItem("盒式（面积平均）", Resampler::Box);
+    m_resampleFilterCombo->setToolTip("源图缩放到输出尺寸时使用的重采样滤镜");
+    outputLayout->addWidget(new QLabel("缩放滤镜:"), 2, 0);
+    outputLayout->addWidget(m_resampleFilterCombo, 2, 1, 1, 3);
+    
+    mainLayout->addWidget(m_outputGroup);
+    
     // 预览控制组
     m_previewGroup = new QGroupBox("预览设置");
     QVBoxLayout *previewLayout = new QVBoxLayout(m_previewGroup);
@@ -202,9 +347,14 @@ void MainWindow::createControlPanel()
     m_previewCheckBox = new QCheckBox("实时预览");
     m_previewCheckBox->setChecked(true);
     
+    m_proxyPreviewCheckBox = new QCheckBox("大图先显示低分辨率预览");
+    m_proxyPreviewCheckBox->setChecked(true);
+    m_proxyPreviewCheckBox->setToolTip("处理耗时较长时先生成代理预览，空闲后再生成全分辨率结果");
+    
     m_resetButton = new QPushButton("重置扩展");
     
     previewLayout->addWidget(m_previewCheckBox);
+    previewLayout->addWidget(m_proxyPreviewCheckBox);
     previewLayout->addWidget(m_resetButton);
     mainLayout->addWidget(m_previewGroup);
     
@@ -239,6 +389,11 @@ void MainWindow::createMenus()
     connect(exportAction, &QAction::triggered, this, &MainWindow::exportImage);
     m_fileMenu->addAction(exportAction);
     
+    QAction *exportVariantsAction = new QAction("导出多比例版本(&V)...", this);
+    exportVariantsAction->setStatusTip("一次导出多个目标比例的扩展结果");
+    connect(exportVariantsAction, &QAction::triggered, this, &MainWindow::exportVariants);
+    m_fileMenu->addAction(exportVariantsAction);
+    
     m_fileMenu->addSeparator();
     
     QAction *exitAction = new QAction("退出(&X)", this);
@@ -315,6 +470,16 @@ void MainWindow::createStatusBar()
     m_statusBar->addWidget(m_imageInfoLabel, 1);
     m_statusBar->addWidget(m_colorInfoLabel);
     m_statusBar->addWidget(m_progressBar);
+    
+    // 后台导出进度
+    m_exportProgressBar = new QProgressBar;
+    m_exportProgressBar->setMaximumWidth(200);
+    m_exportProgressBar->setVisible(false);
+    m_cancelExportButton = new QPushButton("取消导出");
+    m_cancelExportButton->setFlat(true);
+    m_cancelExportButton->setVisible(false);
+    m_statusBar->addPermanentWidget(m_exportProgressBar);
+    m_statusBar->addPermanentWidget(m_cancelExportButton);
 }
 
 void MainWindow::connectSignals()
@@ -341,11 +506,45 @@ void MainWindow::connectSignals()
         }
     });
     
+    // 填充方式
+    connect(m_fillModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onFillModeChanged);
+    connect(m_seamModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onSeamModeChanged);
+    
+    // 渐变设置
+    connect(m_gradientCheckBox, &QCheckBox::toggled,
+            this, &MainWindow::onGradientSettingsChanged);
+    connect(m_linearLightCheckBox, &QCheckBox::toggled,
+            this, &MainWindow::onGradientSettingsChanged);
+    connect(m_gradientCurveCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onGradientSettingsChanged);
+    connect(m_gradientPointsEdit, &QLineEdit::editingFinished,
+            this, &MainWindow::onGradientSettingsChanged);
+    const QList<QSpinBox*> gradientSpinBoxes = {m_gradientStrengthSpinBox,
+        m_blendTopSpinBox, m_blendBottomSpinBox, m_blendLeftSpinBox, m_blendRightSpinBox};
+    for (QSpinBox *spinBox : gradientSpinBoxes) {
+        connect(spinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+                this, &MainWindow::onGradientSettingsChanged);
+    }
+    
+    // 输出尺寸
+    connect(m_outputSizeCheckBox, &QCheckBox::toggled,
+            this, &MainWindow::onOutputSizeChanged);
+    connect(m_outputWidthSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::onOutputSizeChanged);
+    connect(m_outputHeightSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::onOutputSizeChanged);
+    connect(m_resampleFilterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onOutputSizeChanged);
+    
     // 预览控制信号
     connect(m_previewCheckBox, &QCheckBox::toggled,
             this, &MainWindow::onPreviewToggled);
     connect(m_resetButton, &QPushButton::clicked,
             this, &MainWindow::resetExpansion);
+    connect(m_proxyPreviewCheckBox, &QCheckBox::toggled,
+            this, &MainWindow::saveSchedulerSettings);
     
     // 智能比例控制信号 - 改为按钮触发模式
     connect(m_targetRatioEdit, &QLineEdit::textChanged,
@@ -373,10 +572,30 @@ void MainWindow::connectSignals()
     
     connect(m_applyRatioButton, &QPushButton::clicked,
             this, &MainWindow::onRatioCalculationRequested);
+    connect(m_canvasAlignmentCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onCanvasConstraintsChanged);
+    connect(m_maxCanvasMegapixelsSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::onCanvasConstraintsChanged);
+    
+    // 异步加载完成
+    connect(m_imageViewer, &ImageViewer::imageLoaded,
+            this, &MainWindow::onImageLoaded);
+    connect(m_imageViewer, &ImageViewer::imageLoadFailed,
+            this, &MainWindow::onImageLoadFailed);
+    
+    // 后台导出
+    connect(m_imageExporter, &ImageExporter::jobProgress,
+            this, &MainWindow::onExportProgress);
+    connect(m_imageExporter, &ImageExporter::jobFinished,
+            this, &MainWindow::onExportFinished);
+    connect(m_cancelExportButton, &QPushButton::clicked,
+            m_imageExporter, &ImageExporter::cancelAll);
     
     // 图像处理器信号
     connect(m_imageProcessor, &ImageProcessor::imageProcessed,
             m_imageViewer, &ImageViewer::setProcessedImage);
+    connect(m_imageProcessor, &ImageProcessor::errorOccurred,
+            this, &MainWindow::onProcessingError);
     connect(m_imageProcessor, &ImageProcessor::progressChanged,
             m_progressBar, &QProgressBar::setValue);
 }
@@ -385,27 +604,56 @@ void MainWindow::openImage()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
         "打开图像文件", m_lastImageDirectory,
-        "图像文件 (*.png *.jpg *.jpeg *.bmp *.gif *.tiff);;所有文件 (*)");
+        "图像文件 (*.png *.jpg *.jpeg *.bmp *.gif *.tif *.tiff *.ppm *.pgm *.pam);;所有文件 (*)");
     
     if (!fileName.isEmpty()) {
+        // 旧图像的处理结果不再需要
+        m_imageProcessor->cancelProcessing();
+        
         if (m_imageViewer->loadImage(fileName)) {
-            m_currentImagePath = fileName;
-            
-            // 保存选择的目录路径
-            QFileInfo fileInfo(fileName);
-            saveLastImageDirectory(fileInfo.absolutePath());
-            
-            setControlsEnabled(true);
-            updateStatusBar();
-            
-            // 重置扩展设置
-            resetExpansion();
+            // 解码完成前禁用参数面板，避免在预览图上处理
+            m_currentImagePath.clear();
+            setControlsEnabled(false);
+            m_imageInfoLabel->setText("正在加载...");
+            statusBar()->showMessage("正在加载: " + fileName);
         } else {
             QMessageBox::warning(this, "错误", "无法加载图像文件：" + fileName);
         }
     }
 }
 
+void MainWindow::onImageLoaded(const QString &fileName, qint64 firstPixelMs, qint64 fullImageMs)
+{
+    m_currentImagePath = fileName;
+    m_currentImageModified = QFileInfo(fileName).lastModified();
+    
+    // 新图像的结果与旧缓存无关，释放内存
+    m_imageProcessor->clearCache();
+    
+    // 保存选择的目录路径
+    QFileInfo fileInfo(fileName);
+    saveLastImageDirectory(fileInfo.absolutePath());
+    
+    setControlsEnabled(true);
+    updateStatusBar();
+    
+    // 重置扩展设置
+    resetExpansion();
+    
+    statusBar()->showMessage(QString("加载完成：首次显示 %1 ms，完整图像 %2 ms")
+                             .arg(firstPixelMs).arg(fullImageMs), 5000);
+}
+
+void MainWindow::onImageLoadFailed(const QString &fileName, const QString &errorString)
+{
+    m_currentImagePath.clear();
+    setControlsEnabled(false);
+    updateStatusBar();
+    statusBar()->clearMessage();
+    QMessageBox::warning(this, "错误",
+                         QString("无法加载图像文件：%1\n%2").arg(fileName, errorString));
+}
+
 void MainWindow::saveImage()
 {
     if (m_currentImagePath.isEmpty()) {
@@ -413,11 +661,7 @@ void MainWindow::saveImage()
         return;
     }
     
-    if (m_imageViewer->saveImage(m_currentImagePath)) {
-        statusBar()->showMessage("图像已保存", 2000);
-    } else {
-        QMessageBox::warning(this, "错误", "保存图像失败");
-    }
+    startExport(m_currentImagePath, loadEncoderSettings());
 }
 
 void MainWindow::exportImage()
@@ -426,22 +670,228 @@ void MainWindow::exportImage()
         QMessageBox::information(this, "提示", "请先打开一个图像文件");
         return;
     }
+    if (m_imageViewer->isLoading()) {
+        QMessageBox::information(this, "提示", "图像正在加载，请稍候");
+        return;
+    }
     
     QString fileName = QFileDialog::getSaveFileName(this,
         "导出图像", m_lastImageDirectory,
-        "PNG 文件 (*.png);;JPEG 文件 (*.jpg);;BMP 文件 (*.bmp);;所有文件 (*)");
+        "PNG 文件 (*.png);;JPEG 文件 (*.jpg);;BMP 文件 (*.bmp);;TIFF 文件 (*.tif);;"
+        "PPM/PAM 文件 (*.ppm *.pgm *.pam);;所有文件 (*)");
     
     if (!fileName.isEmpty()) {
-        if (m_imageViewer->saveImage(fileName)) {
-            // 保存选择的目录路径
-            QFileInfo fileInfo(fileName);
-            saveLastImageDirectory(fileInfo.absolutePath());
-            
-            statusBar()->showMessage("图像已导出到: " + fileName, 3000);
-        } else {
-            QMessageBox::warning(this, "错误", "导出图像失败");
+        ImageExporter::EncoderSettings settings = loadEncoderSettings();
+        if (!editEncoderSettings(fileName, settings)) {
+            return;
         }
+        saveEncoderSettings(settings);
+        
+        // 保存选择的目录路径
+        QFileInfo fileInfo(fileName);
+        saveLastImageDirectory(fileInfo.absolutePath());
+        
+        startExport(fileName, settings);
+    }
+}
+
+void MainWindow::startExport(const QString &fileName, const ImageExporter::EncoderSettings &settings)
+{
+    // 确保导出的是全分辨率结果而非代理预览
+    m_imageProcessor->finishPendingWork();
+    
+    // 图像按值传入即为快照，导出期间可以继续编辑
+    ImageExporter::JpegPadding padding;
+    if (settings.losslessJpeg && prepareJpegPadding(fileName, padding)) {
+        m_imageExporter->exportPaddedJpeg(padding, m_imageViewer->currentImage(), fileName, settings);
+        statusBar()->showMessage(QString("正在后台无损扩展 JPEG: %1（边距 上 %2 下 %3 左 %4 右 %5）")
+                                 .arg(fileName).arg(padding.margins.top).arg(padding.margins.bottom)
+                                 .arg(padding.margins.left).arg(padding.margins.right), 4000);
+    } else {
+        m_imageExporter->exportImage(m_imageViewer->currentImage(), fileName, settings);
+        statusBar()->showMessage("正在后台导出: " + fileName, 2000);
+    }
+    
+    m_exportProgressBar->setValue(0);
+    m_exportProgressBar->setVisible(true);
+    m_cancelExportButton->setVisible(true);
+}
+
+bool MainWindow::prepareJpegPadding(const QString &fileName, ImageExporter::JpegPadding &padding) const
+{
+    // 只有纯色填充、没有渐变与泊松融合、不缩放输出时，结果才等于源图加纯色边距
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if ((suffix != "jpg" && suffix != "jpeg") || m_currentImagePath.isEmpty()
+        || m_imageProcessor->fillMode() != ImageProcessor::SolidFill
+        || m_imageProcessor->seamMode() != ImageProcessor::GradientSeam
+        || (m_imageProcessor->gradientEnabled() && m_imageProcessor->gradientProfile().strength() > 0.0)
+        || m_imageProcessor->outputSize().isValid()
+        || m_selectedColor.alpha() != 255) {
+        return false;
     }
+    
+    // 源文件加载后被改写（例如已保存过扩展结果）时不再对应当前图像
+    if (QFileInfo(m_currentImagePath).lastModified() != m_currentImageModified) {
+        return false;
+    }
+    // 界面线程只读取文件开头判断能否无损处理，完整文件在导出任务中读取
+    QFile source(m_currentImagePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray header = source.read(JpegPadder::HEADER_PROBE_BYTES);
+    
+    // DCT 域填充按存储方向进行，带 EXIF 方向的源图不适用；
+    // 灰度源图只能写出中性色边距，其他颜色改为按预览结果编码
+    JpegPadder padder;
+    if (!padder.readHeader(header)
+        || !padder.canRepresent(m_selectedColor)
+        || m_imageViewer->originalImage().isTransformed()
+        || padder.size() != m_imageViewer->originalImage().size()) {
+        return false;
+    }
+    
+    // 源数据中位于左、上方的边距按 MCU 向上对齐，实际边距可能比设置的略大
+    JpegPadder::Margins requested;
+    requested.top = m_topSpinBox->value();
+    requested.bottom = m_bottomSpinBox->value();
+    requested.left = m_leftSpinBox->value();
+    requested.right = m_rightSpinBox->value();
+    padding.sourcePath = m_currentImagePath;
+    padding.sourceModified = m_currentImageModified;
+    padding.margins = padder.alignedMargins(requested);
+    padding.color = m_selectedColor;
+    return true;
+}
+
+void MainWindow::onExportProgress(int jobId, const QString &fileName, int percent, const QString &stage)
+{
+    Q_UNUSED(jobId);
+    m_exportProgressBar->setValue(percent);
+    m_exportProgressBar->setFormat(QString("%1 %2 %p%").arg(QFileInfo(fileName).fileName(), stage));
+}
+
+void MainWindow::onExportFinished(int jobId, const QString &fileName, bool success,
+                                  const QString &errorString, qint64 elapsedMs)
+{
+    Q_UNUSED(jobId);
+    if (m_imageExporter->activeJobCount() == 0) {
+        m_exportProgressBar->setVisible(false);
+        m_cancelExportButton->setVisible(false);
+    }
+    
+    if (success) {
+        statusBar()->showMessage(QString("图像已导出到: %1（%2 ms）").arg(fileName).arg(elapsedMs), 3000);
+    } else {
+        QMessageBox::warning(this, "错误", QString("导出图像失败：%1\n%2").arg(fileName, errorString));
+    }
+}
+
+void MainWindow::exportVariants()
+{
+    if (!m_imageViewer->hasImage()) {
+        QMessageBox::information(this, "提示", "请先打开一个图像文件");
+        return;
+    }
+    if (m_imageViewer->isLoading()) {
+        QMessageBox::information(this, "提示", "图像正在加载，请稍候");
+        return;
+    }
+    
+    QSettings settings;
+    settings.beginGroup("variants");
+    
+    // 比例列表、命名模板与格式
+    QDialog dialog(this);
+    dialog.setWindowTitle("导出多比例版本");
+    QFormLayout *form = new QFormLayout(&dialog);
+    QLineEdit *ratiosEdit = new QLineEdit(
+        settings.value("ratios", VariantExporter::defaultRatios()).toString());
+    ratiosEdit->setToolTip("以逗号分隔的目标比例");
+    QLineEdit *templateEdit = new QLineEdit(
+        settings.value("nameTemplate", VariantExporter::defaultNameTemplate()).toString());
+    templateEdit->setToolTip("可用占位符：{name} {ratio} {width} {height} {index}");
+    QComboBox *formatCombo = new QComboBox;
+    formatCombo->addItem("PNG", "png");
+    formatCombo->addItem("JPEG", "jpg");
+    formatCombo->addItem("BMP", "bmp");
+    formatCombo->addItem("TIFF", "tif");
+    formatCombo->addItem("PPM", "ppm");
+    formatCombo->setCurrentIndex(qMax(0, formatCombo->findData(settings.value("format", "png"))));
+    form->addRow("目标比例:", ratiosEdit);
+    form->addRow("文件名模板:", templateEdit);
+    form->addRow("格式:", formatCombo);
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    form->addRow(buttons);
+    
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    
+    const QStringList ratios = VariantExporter::parseRatioList(ratiosEdit->text());
+    if (ratios.isEmpty()) {
+        QMessageBox::warning(this, "错误", "请输入至少一个目标比例");
+        return;
+    }
+    
+    const QString directory = QFileDialog::getExistingDirectory(this, "选择导出目录",
+                                                                m_lastImageDirectory);
+    if (directory.isEmpty()) {
+        return;
+    }
+    
+    settings.setValue("ratios", ratiosEdit->text());
+    settings.setValue("nameTemplate", templateEdit->text());
+    settings.setValue("format", formatCombo->currentData());
+    settings.endGroup();
+    
+    // 渲染配置与源图都取快照，导出在后台进行期间可以继续编辑；
+    // 快照处理器在界面线程创建，也回到界面线程销毁
+    std::shared_ptr<ImageProcessor> processor(new ImageProcessor, [](ImageProcessor *p) {
+        p->deleteLater();
+    });
+    processor->copyRenderSettings(*m_imageProcessor);
+    
+    VariantExporter exporter(processor.get());
+    exporter.setNameTemplate(templateEdit->text());
+    exporter.setFormat(formatCombo->currentData().toString());
+    exporter.setEncoderSettings(loadEncoderSettings());
+    
+    const QString baseName = m_currentImagePath.isEmpty()
+        ? QString("image") : QFileInfo(m_currentImagePath).completeBaseName();
+    const OrientedImage source = m_imageViewer->originalImage();
+    const QColor color = m_selectedColor;
+    
+    m_imageExporter->startJob(directory, [processor, exporter, source, baseName, color, ratios, directory](
+                                  const std::atomic<bool> *cancelled,
+                                  const ImageExporter::ProgressCallback &progress,
+                                  QString *errorString) {
+        const QVector<VariantExporter::Variant> variants = exporter.exportVariants(
+            source, baseName, color, ratios, directory, cancelled, progress);
+        
+        QStringList failures;
+        int exported = 0;
+        for (const VariantExporter::Variant &variant : variants) {
+            if (variant.success) {
+                ++exported;
+            } else {
+                failures.append(QString("%1: %2").arg(variant.ratio, variant.errorMessage));
+            }
+        }
+        if (failures.isEmpty()) {
+            return true;
+        }
+        *errorString = QString("成功 %1 个，失败 %2 个：\n%3")
+                           .arg(exported).arg(failures.size()).arg(failures.join("\n"));
+        return false;
+    });
+    statusBar()->showMessage(QString("正在后台导出 %1 个版本到: %2").arg(ratios.size()).arg(directory), 2000);
+    
+    m_exportProgressBar->setValue(0);
+    m_exportProgressBar->setVisible(true);
+    m_cancelExportButton->setVisible(true);
 }
 
 void MainWindow::onColorSelected(const QColor &color)
@@ -457,6 +907,87 @@ void MainWindow::onExpansionChanged()
     updatePreview();
 }
 
+void MainWindow::onFillModeChanged(int index)
+{
+    const int mode = m_fillModeCombo->itemData(index).toInt();
+    m_imageProcessor->setFillMode(static_cast<ImageProcessor::FillMode>(mode));
+    updatePreview();
+}
+
+void MainWindow::onSeamModeChanged(int index)
+{
+    const int mode = m_seamModeCombo->itemData(index).toInt();
+    m_imageProcessor->setSeamMode(static_cast<ImageProcessor::SeamMode>(mode));
+    updatePreview();
+}
+
+void MainWindow::onProcessingError(const QString &error)
+{
+    QMessageBox::warning(this, "错误", QString("处理图像失败：%1").arg(error));
+}
+
+void MainWindow::onGradientSettingsChanged()
+{
+    const GradientProfile::Curve curve = static_cast<GradientProfile::Curve>(
+        m_gradientCurveCombo->currentData().toInt());
+    m_gradientPointsEdit->setEnabled(curve == GradientProfile::Custom);
+    
+    // 解析自定义控制点 "x,y; x,y"，忽略格式不正确的项
+    QVector<QPointF> points;
+    const QStringList pairs = m_gradientPointsEdit->text().split(';');
+    for (const QString &pair : pairs) {
+        const QStringList values = pair.split(',');
+        if (values.size() != 2) {
+            continue;
+        }
+        bool okX = false;
+        bool okY = false;
+        const double x = values[0].trimmed().toDouble(&okX);
+        const double y = values[1].trimmed().toDouble(&okY);
+        if (okX && okY) {
+            points.append(QPointF(x, y));
+        }
+    }
+    
+    GradientProfile profile = m_imageProcessor->gradientProfile();
+    profile.setCustomPoints(points);
+    profile.setCurve(curve);
+    profile.setStrength(m_gradientStrengthSpinBox->value() / 100.0);
+    m_imageProcessor->setGradientProfile(profile);
+    
+    ImageProcessor::BlendDistances distances;
+    distances.top = m_blendTopSpinBox->value();
+    distances.bottom = m_blendBottomSpinBox->value();
+    distances.left = m_blendLeftSpinBox->value();
+    distances.right = m_blendRightSpinBox->value();
+    m_imageProcessor->setBlendDistances(distances);
+    m_imageProcessor->setGradientEnabled(m_gradientCheckBox->isChecked());
+    m_imageProcessor->setLinearLightBlending(m_linearLightCheckBox->isChecked());
+    
+    updatePreview();
+}
+
+void MainWindow::onOutputSizeChanged()
+{
+    const bool enabled = m_outputSizeCheckBox->isChecked();
+    m_outputWidthSpinBox->setEnabled(enabled);
+    m_outputHeightSpinBox->setEnabled(enabled);
+    
+    const QSize size(m_outputWidthSpinBox->value(), m_outputHeightSpinBox->value());
+    const int filter = m_resampleFilterCombo->currentData().toInt();
+    m_imageProcessor->setOutputSize(enabled ? size : QSize());
+    m_imageProcessor->setResampleFilter(static_cast<Resampler::Filter>(filter));
+    
+    QSettings settings;
+    settings.beginGroup("output");
+    settings.setValue("fixedSize", enabled);
+    settings.setValue("size", size);
+    settings.setValue("resampleFilter", filter);
+    settings.endGroup();
+    
+    updatePreview();
+}
+
 void MainWindow::onPreviewToggled(bool enabled)
 {
     m_previewEnabled = enabled;
@@ -494,6 +1025,10 @@ void MainWindow::onRatioCalculationRequested()
         QMessageBox::information(this, "提示", "请先打开一个图像文件");
         return;
     }
+    if (m_imageViewer->isLoading()) {
+        QMessageBox::information(this, "提示", "图像正在加载，请稍候");
+        return;
+    }
     
     QString targetRatio = m_targetRatioEdit->text().trimmed();
     if (targetRatio.isEmpty()) {
@@ -505,7 +1040,7 @@ void MainWindow::onRatioCalculationRequested()
     
     // 计算智能扩展
     ImageProcessor::ExpansionValues expansion = m_imageProcessor->calculateSmartExpansion(
-        m_imageViewer->originalImage(), targetRatio, distribution);
+        m_imageViewer->originalImage().size(), targetRatio, distribution);
     
     if (!expansion.isValid) {
         QMessageBox::warning(this, "计算错误", expansion.errorMessage);
@@ -560,11 +1095,13 @@ void MainWindow::updateCalculationDisplay(const ImageProcessor::ExpansionValues
     int newHeight = originalSize.height() + expansion.top + expansion.bottom;
     
     QString info = QString("原图: %1x%2 → 目标: %3x%4<br>"
-                          "扩展: 上%5 下%6 左%7 右%8")
+                          "扩展: 上%5 下%6 左%7 右%8<br>"
+                          "比例误差: %9%")
         .arg(originalSize.width()).arg(originalSize.height())
         .arg(newWidth).arg(newHeight)
         .arg(expansion.top).arg(expansion.bottom)
-        .arg(expansion.left).arg(expansion.right);
+        .arg(expansion.left).arg(expansion.right)
+        .arg(expansion.ratioError * 100.0, 0, 'f', 2);
     
     m_calculationInfoLabel->setText(info);
     m_calculationInfoLabel->setStyleSheet("color: blue; font-size: 10px;");
@@ -596,7 +1133,7 @@ void MainWindow::updateStatusBar()
 
 void MainWindow::updatePreview()
 {
-    if (!m_previewEnabled || !m_imageViewer->hasImage()) {
+    if (!m_previewEnabled || !m_imageViewer->hasImage() || m_imageViewer->isLoading()) {
         return;
     }
     
@@ -647,6 +1184,8 @@ void MainWindow::setControlsEnabled(bool enabled)
     m_expansionGroup->setEnabled(enabled);
     m_ratioGroup->setEnabled(enabled);
     m_colorGroup->setEnabled(enabled);
+    m_gradientGroup->setEnabled(enabled);
+    m_outputGroup->setEnabled(enabled);
     m_previewGroup->setEnabled(enabled);
     
     if (enabled) {
@@ -672,3 +1211,194 @@ void MainWindow::saveLastImageDirectory(const QString &directory)
         settings.setValue("lastImageDirectory", directory);
     }
 }
+
+void MainWindow::loadSchedulerSettings()
+{
+    QSettings settings;
+    ImageProcessor::SchedulerPolicy policy = ImageProcessor::defaultSchedulerPolicy();
+    
+    settings.beginGroup("preview");
+    policy.frameBudgetMs = settings.value("frameBudgetMs", policy.frameBudgetMs).toInt();
+    policy.targetLatencyMs = settings.value("targetLatencyMs", policy.targetLatencyMs).toInt();
+    policy.maxCoalesceMs = settings.value("maxCoalesceMs", policy.maxCoalesceMs).toInt();
+    policy.allowProxy = settings.value("allowProxy", policy.allowProxy).toBool();
+    settings.endGroup();
+    
+    m_imageProcessor->setSchedulerPolicy(policy);
+    
+    // 更新界面时不触发保存
+    const bool blocked = m_proxyPreviewCheckBox->blockSignals(true);
+    m_proxyPreviewCheckBox->setChecked(policy.allowProxy);
+    m_proxyPreviewCheckBox->blockSignals(blocked);
+}
+
+void MainWindow::saveSchedulerSettings()
+{
+    ImageProcessor::SchedulerPolicy policy = m_imageProcessor->schedulerPolicy();
+    policy.allowProxy = m_proxyPreviewCheckBox->isChecked();
+    m_imageProcessor->setSchedulerPolicy(policy);
+    
+    QSettings settings;
+    settings.beginGroup("preview");
+    settings.setValue("frameBudgetMs", policy.frameBudgetMs);
+    settings.setValue("targetLatencyMs", policy.targetLatencyMs);
+    settings.setValue("maxCoalesceMs", policy.maxCoalesceMs);
+    settings.setValue("allowProxy", policy.allowProxy);
+    settings.endGroup();
+}
+
+ImageExporter::EncoderSettings MainWindow::loadEncoderSettings() const
+{
+    const ImageExporter::EncoderSettings defaults = ImageExporter::defaultEncoderSettings();
+    ImageExporter::EncoderSettings encoder;
+    QSettings settings;
+    settings.beginGroup("encoder");
+    encoder.pngCompression = settings.value("pngCompression", defaults.pngCompression).toInt();
+    encoder.jpegQuality = settings.value("jpegQuality", defaults.jpegQuality).toInt();
+    encoder.optimized = settings.value("optimized", defaults.optimized).toBool();
+    encoder.progressive = settings.value("progressive", defaults.progressive).toBool();
+    encoder.losslessJpeg = settings.value("losslessJpeg", defaults.losslessJpeg).toBool();
+    settings.endGroup();
+    return encoder;
+}
+
+void MainWindow::saveEncoderSettings(const ImageExporter::EncoderSettings &encoder)
+{
+    QSettings settings;
+    settings.beginGroup("encoder");
+    settings.setValue("pngCompression", encoder.pngCompression);
+    settings.setValue("jpegQuality", encoder.jpegQuality);
+    settings.setValue("optimized", encoder.optimized);
+    settings.setValue("progressive", encoder.progressive);
+    settings.setValue("losslessJpeg", encoder.losslessJpeg);
+    settings.endGroup();
+}
+
+bool MainWindow::editEncoderSettings(const QString &fileName, ImageExporter::EncoderSettings &settings)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    const bool png = suffix == "png" || suffix.isEmpty();
+    const bool jpeg = suffix == "jpg" || suffix == "jpeg";
+    if (!png && !jpeg) {
+        // 其他格式没有可调的编码参数
+        return true;
+    }
+    
+    QDialog dialog(this);
+    dialog.setWindowTitle("导出选项");
+    QFormLayout *form = new QFormLayout(&dialog);
+    
+    QSpinBox *compressionSpinBox = new QSpinBox;
+    QSpinBox *qualitySpinBox = new QSpinBox;
+    QCheckBox *optimizedCheckBox = new QCheckBox("优化哈夫曼表（文件更小）");
+    QCheckBox *progressiveCheckBox = new QCheckBox("渐进式");
+    QCheckBox *losslessCheckBox = new QCheckBox("JPEG 源图纯色扩展时无损处理");
+    if (png) {
+        compressionSpinBox->setRange(0, 9);
+        compressionSpinBox->setValue(settings.pngCompression);
+        compressionSpinBox->setToolTip("0 为不压缩，9 为最小文件，级别越高编码越慢");
+        form->addRow("PNG 压缩级别:", compressionSpinBox);
+    } else {
+        qualitySpinBox->setRange(0, 100);
+        qualitySpinBox->setValue(settings.jpegQuality);
+        optimizedCheckBox->setChecked(settings.optimized);
+        progressiveCheckBox->setChecked(settings.progressive);
+        form->addRow("JPEG 质量:", qualitySpinBox);
+        form->addRow(optimizedCheckBox);
+        form->addRow(progressiveCheckBox);
+        losslessCheckBox->setChecked(settings.losslessJpeg);
+        losslessCheckBox->setToolTip("直接在 DCT 域放置源图数据，源图不经过重新编码；\n"
+                                     "部分边距会对齐到 8 或 16 像素的整数倍，此时忽略质量与渐进式设置");
+        form->addRow(losslessCheckBox);
+    }
+    
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    form->addRow(buttons);
+    
+    if (dialog.exec() != QDialog::Accepted) {
+        return false;
+    }
+    
+    if (png) {
+        settings.pngCompression = compressionSpinBox->value();
+    } else {
+        settings.jpegQuality = qualitySpinBox->value();
+        settings.optimized = optimizedCheckBox->isChecked();
+        settings.progressive = progressiveCheckBox->isChecked();
+        settings.losslessJpeg = losslessCheckBox->isChecked();
+    }
+    return true;
+}
+
+void MainWindow::loadOutputSettings()
+{
+    QSettings settings;
+    settings.beginGroup("output");
+    const bool enabled = settings.value("fixedSize", false).toBool();
+    const QSize size = settings.value("size", QSize(1080, 1350)).toSize();
+    const int filter = settings.value("resampleFilter", Resampler::Lanczos3).toInt();
+    settings.endGroup();
+    
+    // 更新界面时不触发保存
+    const QList<QWidget*> widgets = {m_outputSizeCheckBox, m_outputWidthSpinBox, m_outputHeightSpinBox,
+                                     m_resampleFilterCombo};
+    for (QWidget *widget : widgets) {
+        widget->blockSignals(true);
+    }
+    m_outputSizeCheckBox->setChecked(enabled);
+    m_outputWidthSpinBox->setValue(size.width());
+    m_outputHeightSpinBox->setValue(size.height());
+    m_outputWidthSpinBox->setEnabled(enabled);
+    m_outputHeightSpinBox->setEnabled(enabled);
+    const int filterIndex = m_resampleFilterCombo->findData(filter);
+    if (filterIndex >= 0) {
+        m_resampleFilterCombo->setCurrentIndex(filterIndex);
+    }
+    for (QWidget *widget : widgets) {
+        widget->blockSignals(false);
+    }
+    
+    m_imageProcessor->setOutputSize(enabled ? size : QSize());
+    m_imageProcessor->setResampleFilter(
+        static_cast<Resampler::Filter>(m_resampleFilterCombo->currentData().toInt()));
+}
+
+void MainWindow::loadCanvasConstraints()
+{
+    ImageProcessor::CanvasConstraints constraints = ImageProcessor::defaultCanvasConstraints();
+    QSettings settings;
+    settings.beginGroup("ratio");
+    constraints.alignment = settings.value("alignment", constraints.alignment).toInt();
+    const double megapixels = settings.value("maxMegapixels", 0.0).toDouble();
+    settings.endGroup();
+    constraints.maxPixels = static_cast<qint64>(megapixels * 1000000.0);
+    m_imageProcessor->setCanvasConstraints(constraints);
+    
+    // 更新界面时不触发保存
+    const QList<QWidget*> widgets = {m_canvasAlignmentCombo, m_maxCanvasMegapixelsSpinBox};
+    for (QWidget *widget : widgets) {
+        widget->blockSignals(true);
+    }
+    const int alignmentIndex = m_canvasAlignmentCombo->findData(constraints.alignment);
+    m_canvasAlignmentCombo->setCurrentIndex(qMax(0, alignmentIndex));
+    m_maxCanvasMegapixelsSpinBox->setValue(megapixels);
+    for (QWidget *widget : widgets) {
+        widget->blockSignals(false);
+    }
+}
+
+void MainWindow::onCanvasConstraintsChanged()
+{
+    ImageProcessor::CanvasConstraints constraints = m_imageProcessor->canvasConstraints();
+    constraints.alignment = m_canvasAlignmentCombo->currentData().toInt();
+    constraints.maxPixels = static_cast<qint64>(m_maxCanvasMegapixelsSpinBox->value() * 1000000.0);
+    m_imageProcessor->setCanvasConstraints(constraints);
+    
+    QSettings settings;
+    settings.beginGroup("ratio");
+    settings.setValue("alignment", constraints.alignment);
+    settings.setValue("maxMegapixels", m_maxCanvasMegapixelsSpinBox->value());
+    settings.endGroup();
+}
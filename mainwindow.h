@@ -5,7 +5,9 @@
 #include <QLabel>
 #include <QWidget>
 #include <QColor>
+#include <QDateTime>
 #include "imageprocessor.h"
+#include "imageexporter.h"
 
 QT_BEGIN_NAMESPACE
 class QAction;
@@ -16,6 +18,7 @@ class QStatusBar;
 class QVBoxLayout;
 class QHBoxLayout;
 class QSpinBox;
+class QDoubleSpinBox;
 class QPushButton;
 class QCheckBox;
 class QGroupBox;
@@ -39,13 +42,25 @@ public:
 private slots:
     // 文件操作
     void openImage();
+    void onImageLoaded(const QString &fileName, qint64 firstPixelMs, qint64 fullImageMs);
+    void onImageLoadFailed(const QString &fileName, const QString &errorString);
     void saveImage();
     void exportImage();
+    void exportVariants();
+    void onExportProgress(int jobId, const QString &fileName, int percent, const QString &stage);
+    void onExportFinished(int jobId, const QString &fileName, bool success,
+                          const QString &errorString, qint64 elapsedMs);
     
     // 图像处理
     void onColorSelected(const QColor &color);
     void onExpansionChanged();
     void onPreviewToggled(bool enabled);
+    void onFillModeChanged(int index);
+    void onSeamModeChanged(int index);
+    void onProcessingError(const QString &error);
+    void onGradientSettingsChanged();
+    void onOutputSizeChanged();
+    void onCanvasConstraintsChanged();
     void resetExpansion();
     
     // 智能比例调节
@@ -72,6 +87,24 @@ private:
     // 路径记忆功能
     void loadLastImageDirectory();
     void saveLastImageDirectory(const QString &directory);
+    
+    // 预览调度设置
+    void loadSchedulerSettings();
+    void saveSchedulerSettings();
+    
+    // 输出尺寸设置
+    void loadOutputSettings();
+    
+    // 智能比例的画布约束
+    void loadCanvasConstraints();
+    
+    // 编码参数
+    ImageExporter::EncoderSettings loadEncoderSettings() const;
+    void saveEncoderSettings(const ImageExporter::EncoderSettings &settings);
+    bool editEncoderSettings(const QString &fileName, ImageExporter::EncoderSettings &settings);
+    void startExport(const QString &fileName, const ImageExporter::EncoderSettings &settings);
+    // JPEG 源图纯色扩展为 JPEG 时准备 DCT 域无损导出，条件不满足时返回 false
+    bool prepareJpegPadding(const QString &fileName, ImageExporter::JpegPadding &padding) const;
 
     // UI组件
     QWidget *m_centralWidget;
@@ -98,9 +131,29 @@ private:
     QGroupBox *m_colorGroup;
     QPushButton *m_colorButton;
     QLabel *m_colorLabel;
+    QComboBox *m_fillModeCombo;
+    QComboBox *m_seamModeCombo;
+    
+    QGroupBox *m_gradientGroup;
+    QCheckBox *m_gradientCheckBox;
+    QCheckBox *m_linearLightCheckBox;
+    QComboBox *m_gradientCurveCombo;
+    QLineEdit *m_gradientPointsEdit;
+    QSpinBox *m_gradientStrengthSpinBox;
+    QSpinBox *m_blendTopSpinBox;
+    QSpinBox *m_blendBottomSpinBox;
+    QSpinBox *m_blendLeftSpinBox;
+    QSpinBox *m_blendRightSpinBox;
+    
+    QGroupBox *m_outputGroup;
+    QCheckBox *m_outputSizeCheckBox;
+    QSpinBox *m_outputWidthSpinBox;
+    QSpinBox *m_outputHeightSpinBox;
+    QComboBox *m_resampleFilterCombo;
     
     QGroupBox *m_previewGroup;
     QCheckBox *m_previewCheckBox;
+    QCheckBox *m_proxyPreviewCheckBox;
     QPushButton *m_resetButton;
     
     // 智能比例控制组
@@ -108,6 +161,8 @@ private:
     QLineEdit *m_targetRatioEdit;
     QLabel *m_expansionTypeLabel;
     QComboBox *m_distributionCombo;
+    QComboBox *m_canvasAlignmentCombo;
+    QDoubleSpinBox *m_maxCanvasMegapixelsSpinBox;
     QPushButton *m_applyRatioButton;
     QLabel *m_calculationInfoLabel;
     
@@ -119,12 +174,16 @@ private:
     QString m_lastImageDirectory;
     QLabel *m_colorInfoLabel;
     QProgressBar *m_progressBar;
+    QProgressBar *m_exportProgressBar;
+    QPushButton *m_cancelExportButton;
     
     // 核心功能
     ImageProcessor *m_imageProcessor;
+    ImageExporter *m_imageExporter;
     
     // 状态变量
     QString m_currentImagePath;
+    QDateTime m_currentImageModified;   // 加载时源文件的修改时间
     QColor m_selectedColor;
     bool m_previewEnabled;
 };
@@ -0,0 +1,823 @@
+#include "mappedimage.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QByteArray>
+#include <QtEndian>
+#include <cstring>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#else
+#include <cstdio>
+#endif
+
+namespace {
+
+// 32 位 BMP 的 BGRA 字节序与小端主机上的 ARGB32 一致
+const bool LITTLE_ENDIAN_HOST = Q_BYTE_ORDER == Q_LITTLE_ENDIAN;
+
+// 文件中像素区域的描述
+struct Layout {
+    qint64 offset;
+    int width;
+    int height;
+    int bytesPerLine;
+    QImage::Format format;
+    bool bottomUp;      // 行序自下而上（BMP）
+};
+
+int bytesPerPixel(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_Grayscale8:
+        return 1;
+    case QImage::Format_RGB888:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    case QImage::Format_BGR888:
+#endif
+        return 3;
+    default:
+        return 4;
+    }
+}
+
+bool isSpace(uchar c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// PNM 头部中的下一个十进制数，跳过空白与注释
+bool readPnmNumber(const uchar *data, qint64 size, qint64 *pos, int *value)
+{
+    qint64 i = *pos;
+    while (i < size) {
+        if (data[i] == '#') {
+            while (i < size && data[i] != '\n') {
+                ++i;
+            }
+        } else if (isSpace(data[i])) {
+            ++i;
+        } else {
+            break;
+        }
+    }
+    qint64 result = 0;
+    const qint64 start = i;
+    while (i < size && data[i] >= '0' && data[i] <= '9') {
+        result = result * 10 + (data[i] - '0');
+        if (result > (1 << 24)) {
+            return false;
+        }
+        ++i;
+    }
+    if (i == start) {
+        return false;
+    }
+    *pos = i;
+    *value = static_cast<int>(result);
+    return true;
+}
+
+// P5（灰度）与 P6（RGB），只映射 maxval 为 255 的 8 位数据
+bool parsePnm(const uchar *data, qint64 size, Layout *layout)
+{
+    qint64 pos = 2;
+    int width = 0;
+    int height = 0;
+    int maxValue = 0;
+    if (!readPnmNumber(data, size, &pos, &width) || !readPnmNumber(data, size, &pos, &height) ||
+        !readPnmNumber(data, size, &pos, &maxValue)) {
+        return false;
+    }
+    // maxval 之后恰好一个空白字符
+    if (maxValue != 255 || pos >= size || !isSpace(data[pos])) {
+        return false;
+    }
+    const bool gray = data[1] == '5';
+    layout->offset = pos + 1;
+    layout->width = width;
+    layout->height = height;
+    layout->bytesPerLine = width * (gray ? 1 : 3);
+    layout->format = gray ? QImage::Format_Grayscale8 : QImage::Format_RGB888;
+    layout->bottomUp = false;
+    return true;
+}
+
+// P7：以 ENDHDR 结束的键值行
+bool parsePam(const uchar *data, qint64 size, Layout *layout)
+{
+    qint64 pos = 2;
+    int width = 0;
+    int height = 0;
+    int depth = 0;
+    int maxValue = 0;
+    QByteArray tupleType;
+
+    for (;;) {
+        while (pos < size && isSpace(data[pos])) {
+            ++pos;
+        }
+        if (pos >= size) {
+            return false;
+        }
+        if (data[pos] == '#') {
+            while (pos < size && data[pos] != '\n') {
+                ++pos;
+            }
+            continue;
+        }
+        const qint64 keyStart = pos;
+        while (pos < size && !isSpace(data[pos])) {
+            ++pos;
+        }
+        const QByteArray key(reinterpret_cast<const char *>(data + keyStart),
+                             static_cast<int>(qMin<qint64>(pos - keyStart, 16)));
+        if (key == "ENDHDR") {
+            if (pos >= size || data[pos] != '\n') {
+                return false;
+            }
+            ++pos;
+            break;
+        }
+        bool parsed = true;
+        if (key == "WIDTH") {
+            parsed = readPnmNumber(data, size, &pos, &width);
+        } else if (key == "HEIGHT") {
+            parsed = readPnmNumber(data, size, &pos, &height);
+        } else if (key == "DEPTH") {
+            parsed = readPnmNumber(data, size, &pos, &depth);
+        } else if (key == "MAXVAL") {
+            parsed = readPnmNumber(data, size, &pos, &maxValue);
+        } else if (key == "TUPLTYPE") {
+            while (pos < size && (data[pos] == ' ' || data[pos] == '\t')) {
+                ++pos;
+            }
+            const qint64 valueStart = pos;
+            while (pos < size && !isSpace(data[pos])) {
+                ++pos;
+            }
+            tupleType = QByteArray(reinterpret_cast<const char *>(data + valueStart),
+                                   static_cast<int>(qMin<qint64>(pos - valueStart, 32)));
+        }
+        if (!parsed) {
+            return false;
+        }
+        // 忽略未知键的其余内容
+        while (pos < size && data[pos] != '\n') {
+            ++pos;
+        }
+    }
+
+    if (maxValue != 255) {
+        return false;
+    }
+    QImage::Format format;
+    if (depth == 1 && (tupleType.isEmpty() || tupleType == "GRAYSCALE")) {
+        format = QImage::Format_Grayscale8;
+    } else if (depth == 3 && (tupleType.isEmpty() || tupleType == "RGB")) {
+        format = QImage::Format_RGB888;
+    } else if (depth == 4 && tupleType == "RGB_ALPHA") {
+        format = QImage::Format_RGBA8888;
+    } else {
+        return false;
+    }
+    layout->offset = pos;
+    layout->width = width;
+    layout->height = height;
+    layout->bytesPerLine = width * depth;
+    layout->format = format;
+    layout->bottomUp = false;
+    return true;
+}
+
+// 未压缩的 24 位与 32 位 BMP；32 位的位域只接受标准的 BGRA 排列
+bool parseBmp(const uchar *data, qint64 size, Layout *layout)
+{
+    if (size < 54) {
+        return false;
+    }
+    const quint32 pixelOffset = qFromLittleEndian<quint32>(data + 10);
+    const quint32 headerSize = qFromLittleEndian<quint32>(data + 14);
+    const qint32 width = qFromLittleEndian<qint32>(data + 18);
+    const qint32 height = qFromLittleEndian<qint32>(data + 22);
+    const quint16 planes = qFromLittleEndian<quint16>(data + 26);
+    const quint16 bitCount = qFromLittleEndian<quint16>(data + 28);
+    const quint32 compression = qFromLittleEndian<quint32>(data + 30);
+    if (headerSize < 40 || planes != 1 || width <= 0 || width > (1 << 24) || height == 0 ||
+        height < -(1 << 24) || height > (1 << 24)) {
+        return false;
+    }
+
+    QImage::Format format;
+    if (bitCount == 24 && compression == 0) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        format = QImage::Format_BGR888;
+#else
+        return false;
+#endif
+    } else if (bitCount == 32 && compression == 0 && LITTLE_ENDIAN_HOST) {
+        format = QImage::Format_RGB32;
+    } else if (bitCount == 32 && (compression == 3 || compression == 6) && LITTLE_ENDIAN_HOST) {
+        // 位域掩码紧跟 40 字节的信息头，V4/V5 信息头中位于相同位置
+        if (size < 70) {
+            return false;
+        }
+        const quint32 redMask = qFromLittleEndian<quint32>(data + 54);
+        const quint32 greenMask = qFromLittleEndian<quint32>(data + 58);
+        const quint32 blueMask = qFromLittleEndian<quint32>(data + 62);
+        const bool hasAlphaMask = headerSize >= 56 || compression == 6;
+        const quint32 alphaMask = hasAlphaMask ? qFromLittleEndian<quint32>(data + 66) : 0;
+        if (redMask != 0x00ff0000 || greenMask != 0x0000ff00 || blueMask != 0x000000ff) {
+            return false;
+        }
+        if (alphaMask == 0xff000000) {
+            format = QImage::Format_ARGB32;
+        } else if (alphaMask == 0) {
+            format = QImage::Format_RGB32;
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    layout->offset = pixelOffset;
+    layout->width = width;
+    layout->height = height < 0 ? -height : height;
+    layout->bytesPerLine = ((width * bitCount + 31) / 32) * 4;
+    layout->format = format;
+    layout->bottomUp = height > 0;
+    return true;
+}
+
+// TIFF 字段读取，按文件字节序
+class TiffReader
+{
+public:
+    TiffReader(const uchar *data, qint64 size)
+        : m_data(data)
+        , m_size(size)
+        , m_bigEndian(data[0] == 'M')
+    {
+    }
+
+    bool contains(qint64 offset, qint64 length) const
+    {
+        return offset >= 0 && length >= 0 && offset + length <= m_size;
+    }
+
+    quint16 u16(qint64 offset) const
+    {
+        return m_bigEndian ? qFromBigEndian<quint16>(m_data + offset)
+                           : qFromLittleEndian<quint16>(m_data + offset);
+    }
+
+    quint32 u32(qint64 offset) const
+    {
+        return m_bigEndian ? qFromBigEndian<quint32>(m_data + offset)
+                           : qFromLittleEndian<quint32>(m_data + offset);
+    }
+
+    // 读取目录项的全部 SHORT/LONG 值；值不超过四字节时内联在目录项中
+    bool values(qint64 entry, std::vector<quint32> *result) const
+    {
+        const quint16 type = u16(entry + 2);
+        const quint32 count = u32(entry + 4);
+        if ((type != 3 && type != 4) || count == 0 || count > (1u << 24)) {
+            return false;
+        }
+        const int valueSize = type == 3 ? 2 : 4;
+        const qint64 byteCount = static_cast<qint64>(count) * valueSize;
+        const qint64 offset = byteCount <= 4 ? entry + 8 : u32(entry + 8);
+        if (!contains(offset, byteCount)) {
+            return false;
+        }
+        result->resize(count);
+        for (quint32 i = 0; i < count; ++i) {
+            (*result)[i] = valueSize == 2 ? u16(offset + i * 2) : u32(offset + i * 4);
+        }
+        return true;
+    }
+
+private:
+    const uchar *m_data;
+    qint64 m_size;
+    bool m_bigEndian;
+};
+
+// 第一个目录的未压缩 8 位交错像素，所有条带须在文件中首尾相接
+bool parseTiff(const uchar *data, qint64 size, Layout *layout)
+{
+    if (size < 8) {
+        return false;
+    }
+    const TiffReader tiff(data, size);
+    if (tiff.u16(2) != 42) {
+        return false;
+    }
+    const qint64 directory = tiff.u32(4);
+    if (!tiff.contains(directory, 2)) {
+        return false;
+    }
+    const int entryCount = tiff.u16(directory);
+    if (!tiff.contains(directory + 2, static_cast<qint64>(entryCount) * 12)) {
+        return false;
+    }
+
+    quint32 width = 0;
+    quint32 height = 0;
+    quint32 compression = 1;
+    quint32 photometric = 0xffff;
+    quint32 samplesPerPixel = 1;
+    quint32 planarConfig = 1;
+    quint32 orientation = 1;
+    quint32 extraSample = 0;
+    std::vector<quint32> bitsPerSample(1, 1);
+    std::vector<quint32> stripOffsets;
+    std::vector<quint32> stripByteCounts;
+
+    for (int i = 0; i < entryCount; ++i) {
+        const qint64 entry = directory + 2 + i * 12;
+        const quint16 tag = tiff.u16(entry);
+        std::vector<quint32> values;
+        switch (tag) {
+        case 256: case 257: case 259: case 262: case 274: case 277: case 284: case 338:
+            if (!tiff.values(entry, &values)) {
+                return false;
+            }
+            break;
+        case 258:
+            if (!tiff.values(entry, &bitsPerSample)) {
+                return false;
+            }
+            continue;
+        case 273:
+            if (!tiff.values(entry, &stripOffsets)) {
+                return false;
+            }
+            continue;
+        case 279:
+            if (!tiff.values(entry, &stripByteCounts)) {
+                return false;
+            }
+            continue;
+        default:
+            continue;
+        }
+        const quint32 value = values.front();
+        switch (tag) {
+        case 256: width = value; break;
+        case 257: height = value; break;
+        case 259: compression = value; break;
+        case 262: photometric = value; break;
+        case 274: orientation = value; break;
+        case 277: samplesPerPixel = value; break;
+        case 284: planarConfig = value; break;
+        case 338: extraSample = value; break;
+        }
+    }
+
+    // 带方向标记的图像交给 QImageReader 做方向变换
+    if (compression != 1 || orientation != 1 || (planarConfig != 1 && samplesPerPixel > 1) ||
+        width == 0 || height == 0 || width > (1u << 24) || height > (1u << 24)) {
+        return false;
+    }
+    for (size_t i = 0; i < bitsPerSample.size(); ++i) {
+        if (bitsPerSample[i] != 8) {
+            return false;
+        }
+    }
+
+    QImage::Format format;
+    if (photometric == 1 && samplesPerPixel == 1) {
+        format = QImage::Format_Grayscale8;
+    } else if (photometric == 2 && samplesPerPixel == 3) {
+        format = QImage::Format_RGB888;
+    } else if (photometric == 2 && samplesPerPixel == 4) {
+        // ExtraSamples：1 为预乘 alpha，2 为非预乘 alpha，0 为无意义的填充
+        if (extraSample == 1) {
+            format = QImage::Format_RGBA8888_Premultiplied;
+        } else if (extraSample == 2) {
+            format = QImage::Format_RGBA8888;
+        } else {
+            format = QImage::Format_RGBX8888;
+        }
+    } else {
+        return false;
+    }
+
+    const qint64 bytesPerLine = static_cast<qint64>(width) * samplesPerPixel;
+    if (stripOffsets.empty() || stripOffsets.size() != stripByteCounts.size()) {
+        return false;
+    }
+    qint64 end = stripOffsets.front();
+    for (size_t i = 0; i < stripOffsets.size(); ++i) {
+        if (stripOffsets[i] != end) {
+            return false;
+        }
+        end += stripByteCounts[i];
+    }
+    if (end - stripOffsets.front() < bytesPerLine * height) {
+        return false;
+    }
+
+    layout->offset = stripOffsets.front();
+    layout->width = static_cast<int>(width);
+    layout->height = static_cast<int>(height);
+    layout->bytesPerLine = static_cast<int>(bytesPerLine);
+    layout->format = format;
+    layout->bottomUp = false;
+    return true;
+}
+
+// 32 位无 alpha 的 BMP 中第四个字节是保留字节，多数编码器写 0。
+// 直接包装为 RGB32 时违反 0xffRRGGBB 的约定，复制到 ARGB32 画布后源图区域会完全透明；
+// 只有保留字节全为 0xff（如本类写出的文件）时才直接映射，否则交给 QImageReader 转换
+bool hasOpaquePadding(const uchar *data, const Layout &layout)
+{
+    const uchar *row = data + layout.offset;
+    for (int y = 0; y < layout.height; ++y, row += layout.bytesPerLine) {
+        for (int x = 0; x < layout.width; ++x) {
+            if (row[x * 4 + 3] != 0xff) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool parseLayout(const uchar *data, qint64 size, Layout *layout)
+{
+    if (size < 8) {
+        return false;
+    }
+    bool parsed = false;
+    if (data[0] == 'P' && (data[1] == '5' || data[1] == '6')) {
+        parsed = parsePnm(data, size, layout);
+    } else if (data[0] == 'P' && data[1] == '7') {
+        parsed = parsePam(data, size, layout);
+    } else if (data[0] == 'B' && data[1] == 'M') {
+        parsed = parseBmp(data, size, layout);
+    } else if ((data[0] == 'I' && data[1] == 'I') || (data[0] == 'M' && data[1] == 'M')) {
+        parsed = parseTiff(data, size, layout);
+    }
+    if (!parsed || layout->width <= 0 || layout->height <= 0) {
+        return false;
+    }
+    // 像素区域必须完整位于文件内
+    const qint64 pixelBytes = static_cast<qint64>(layout->bytesPerLine) * (layout->height - 1) +
+                              static_cast<qint64>(layout->width) * bytesPerPixel(layout->format);
+    if (layout->offset < 0 || layout->offset + pixelBytes > size) {
+        return false;
+    }
+    return layout->format != QImage::Format_RGB32 || hasOpaquePadding(data, *layout);
+}
+
+void releaseMapping(void *info)
+{
+    // 删除 QFile 即解除映射并关闭文件
+    delete static_cast<QFile *>(info);
+}
+
+// 映射整个文件并解析像素布局；成功时返回的 QFile 保持映射
+QFile *mapFile(const QString &fileName, Layout *layout, const uchar **data)
+{
+    QFile *file = new QFile(fileName);
+    if (file->open(QIODevice::ReadOnly) && file->size() > 0) {
+        *data = file->map(0, file->size());
+        if (*data && parseLayout(*data, file->size(), layout)) {
+            return file;
+        }
+    }
+    delete file;
+    return nullptr;
+}
+
+void putLE16(QByteArray *header, quint16 value)
+{
+    header->append(static_cast<char>(value & 0xff));
+    header->append(static_cast<char>(value >> 8));
+}
+
+void putLE32(QByteArray *header, quint32 value)
+{
+    putLE16(header, static_cast<quint16>(value & 0xffff));
+    putLE16(header, static_cast<quint16>(value >> 16));
+}
+
+void padTo(QByteArray *header, int alignment)
+{
+    while (header->size() % alignment != 0) {
+        header->append('\0');
+    }
+}
+
+// TIFF 目录项：值不超过四字节时内联，否则 value 为数据偏移
+void putTiffEntry(QByteArray *header, quint16 tag, quint16 type, quint32 count, quint32 value)
+{
+    putLE16(header, tag);
+    putLE16(header, type);
+    putLE32(header, count);
+    if (type == 3 && count == 1) {
+        putLE16(header, static_cast<quint16>(value));
+        putLE16(header, 0);
+    } else {
+        putLE32(header, value);
+    }
+}
+
+// 目标文件的头部与像素布局；头部长度即像素数据的偏移
+struct Target {
+    QByteArray header;
+    int bytesPerLine;
+    QImage::Format format;
+};
+
+bool buildTarget(const QImage &image, const QByteArray &suffix, Target *target)
+{
+    const int width = image.width();
+    const int height = image.height();
+    const bool alpha = image.hasAlphaChannel();
+    const bool gray = image.format() == QImage::Format_Grayscale8;
+    const int dotsPerMeter = image.dotsPerMeterX() > 0 ? image.dotsPerMeterX() : 2835;
+    QByteArray &header = target->header;
+
+    if (suffix == "ppm" || suffix == "pgm") {
+        const bool pgm = suffix == "pgm";
+        header = QByteArray(pgm ? "P5\n" : "P6\n") + QByteArray::number(width) + ' ' +
+                 QByteArray::number(height) + "\n255\n";
+        target->format = pgm ? QImage::Format_Grayscale8 : QImage::Format_RGB888;
+        target->bytesPerLine = width * (pgm ? 1 : 3);
+        return true;
+    }
+
+    if (suffix == "pam") {
+        const int depth = alpha ? 4 : (gray ? 1 : 3);
+        header = "P7\nWIDTH " + QByteArray::number(width) + "\nHEIGHT " + QByteArray::number(height) +
+                 "\nDEPTH " + QByteArray::number(depth) + "\nMAXVAL 255\nTUPLTYPE " +
+                 QByteArray(alpha ? "RGB_ALPHA" : (gray ? "GRAYSCALE" : "RGB")) + "\n";
+        // 以注释行填充，使像素数据从 16 字节对齐的偏移开始
+        const QByteArray end("ENDHDR\n");
+        int padding = (16 - (header.size() + end.size()) % 16) % 16;
+        if (padding == 1) {
+            padding += 16;
+        }
+        if (padding > 0) {
+            header += '#' + QByteArray(padding - 2, ' ') + '\n';
+        }
+        header += end;
+        target->format = alpha ? QImage::Format_RGBA8888
+                               : (gray ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+        target->bytesPerLine = width * depth;
+        return true;
+    }
+
+    if (suffix == "bmp") {
+        // 32 位自上而下；带 alpha 时用 V5 信息头声明 alpha 掩码
+        if (!LITTLE_ENDIAN_HOST) {
+            return false;
+        }
+        const quint32 infoSize = alpha ? 124 : 40;
+        const qint64 pixelOffset = ((14 + infoSize) + 15) / 16 * 16;
+        const qint64 pixelBytes = static_cast<qint64>(width) * 4 * height;
+        if (pixelOffset + pixelBytes > 0xffffffffLL) {
+            return false;
+        }
+        header.append("BM");
+        putLE32(&header, static_cast<quint32>(pixelOffset + pixelBytes));
+        putLE32(&header, 0);
+        putLE32(&header, static_cast<quint32>(pixelOffset));
+        putLE32(&header, infoSize);
+        putLE32(&header, static_cast<quint32>(width));
+        putLE32(&header, static_cast<quint32>(-height));
+        putLE16(&header, 1);
+        putLE16(&header, 32);
+        putLE32(&header, alpha ? 3 : 0);
+        putLE32(&header, static_cast<quint32>(pixelBytes));
+        putLE32(&header, static_cast<quint32>(dotsPerMeter));
+        putLE32(&header, static_cast<quint32>(image.dotsPerMeterY() > 0 ? image.dotsPerMeterY() : dotsPerMeter));
+        putLE32(&header, 0);
+        putLE32(&header, 0);
+        if (alpha) {
+            putLE32(&header, 0x00ff0000);
+            putLE32(&header, 0x0000ff00);
+            putLE32(&header, 0x000000ff);
+            putLE32(&header, 0xff000000);
+            putLE32(&header, 0x73524742);       // LCS_sRGB
+            header.append(QByteArray(36 + 12, '\0'));
+            putLE32(&header, 4);                // LCS_GM_IMAGES
+            putLE32(&header, 0);
+            putLE32(&header, 0);
+            putLE32(&header, 0);
+        }
+        padTo(&header, 16);
+        target->format = alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+        target->bytesPerLine = width * 4;
+        return true;
+    }
+
+    if (suffix == "tif" || suffix == "tiff") {
+        // 小端、单条带；非内联的数据放在目录之后
+        const quint32 samples = alpha ? 4 : (gray ? 1 : 3);
+        const qint64 pixelBytes = static_cast<qint64>(width) * samples * height;
+        const int entryCount = alpha ? 14 : 13;
+        const quint32 directoryEnd = 8 + 2 + entryCount * 12 + 4;
+        const quint32 bitsOffset = directoryEnd;
+        const quint32 resolutionOffset = bitsOffset + (samples > 2 ? samples * 2 : 0);
+        const quint32 pixelOffset = (resolutionOffset + 16 + 15) / 16 * 16;
+        if (pixelOffset + pixelBytes > 0xffffffffLL) {
+            return false;
+        }
+        header.append("II*");
+        header.append('\0');
+        putLE32(&header, 8);
+        putLE16(&header, static_cast<quint16>(entryCount));
+        putTiffEntry(&header, 256, 4, 1, static_cast<quint32>(width));
+        putTiffEntry(&header, 257, 4, 1, static_cast<quint32>(height));
+        if (samples > 2) {
+            putTiffEntry(&header, 258, 3, samples, bitsOffset);
+        } else {
+            putTiffEntry(&header, 258, 3, 1, 8);
+        }
+        putTiffEntry(&header, 259, 3, 1, 1);
+        putTiffEntry(&header, 262, 3, 1, gray && !alpha ? 1 : 2);
+        putTiffEntry(&header, 273, 4, 1, pixelOffset);
+        putTiffEntry(&header, 277, 3, 1, samples);
+        putTiffEntry(&header, 278, 4, 1, static_cast<quint32>(height));
+        putTiffEntry(&header, 279, 4, 1, static_cast<quint32>(pixelBytes));
+        putTiffEntry(&header, 282, 5, 1, resolutionOffset);
+        putTiffEntry(&header, 283, 5, 1, resolutionOffset + 8);
+        putTiffEntry(&header, 284, 3, 1, 1);
+        putTiffEntry(&header, 296, 3, 1, 3);    // 厘米
+        if (alpha) {
+            putTiffEntry(&header, 338, 3, 1, 2);
+        }
+        putLE32(&header, 0);
+        for (quint32 i = 0; samples > 2 && i < samples; ++i) {
+            putLE16(&header, 8);
+        }
+        // 每厘米点数 = 每米点数 / 100
+        putLE32(&header, static_cast<quint32>(dotsPerMeter));
+        putLE32(&header, 100);
+        putLE32(&header, static_cast<quint32>(image.dotsPerMeterY() > 0 ? image.dotsPerMeterY() : dotsPerMeter));
+        putLE32(&header, 100);
+        padTo(&header, 16);
+        target->format = alpha ? QImage::Format_RGBA8888
+                               : (gray ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+        target->bytesPerLine = width * static_cast<int>(samples);
+        return true;
+    }
+
+    return false;
+}
+
+// 以 from 原子替换 to：目标已存在时直接覆盖，任何时刻目标都是旧文件或完整的新文件
+bool replaceFile(const QString &from, const QString &to, QString *error)
+{
+#ifdef Q_OS_WIN
+    const QString nativeFrom = QDir::toNativeSeparators(from);
+    const QString nativeTo = QDir::toNativeSeparators(to);
+    if (MoveFileExW(reinterpret_cast<const wchar_t*>(nativeFrom.utf16()),
+                    reinterpret_cast<const wchar_t*>(nativeTo.utf16()),
+                    MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        return true;
+    }
+#else
+    if (::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0) {
+        return true;
+    }
+#endif
+    *error = qt_error_string();
+    return false;
+}
+
+} // namespace
+
+bool MappedImage::canRead(const QString &fileName)
+{
+    Layout layout;
+    const uchar *data = nullptr;
+    QFile *file = mapFile(fileName, &layout, &data);
+    const bool mapped = file != nullptr;
+    delete file;
+    return mapped;
+}
+
+QImage MappedImage::read(const QString &fileName, QString *errorString)
+{
+    Layout layout;
+    const uchar *data = nullptr;
+    QFile *file = mapFile(fileName, &layout, &data);
+    if (!file) {
+        if (errorString) {
+            *errorString = "不是可映射的未压缩图像";
+        }
+        return QImage();
+    }
+
+    // 图像接管 QFile，映射随最后一个共享数据的副本释放
+    const uchar *pixels = data + layout.offset;
+    const QImage mapped(pixels, layout.width, layout.height, layout.bytesPerLine, layout.format,
+                        releaseMapping, file);
+    if (layout.bottomUp) {
+        return mapped.mirrored();
+    }
+    // 32 位格式按整字访问像素，地址与行跨度须四字节对齐
+    if (bytesPerPixel(layout.format) == 4 &&
+        ((reinterpret_cast<quintptr>(pixels) | static_cast<quintptr>(layout.bytesPerLine)) & 3) != 0) {
+        return mapped.copy();
+    }
+    return mapped;
+}
+
+bool MappedImage::canWrite(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "ppm" || suffix == "pgm" || suffix == "pam" || suffix == "tif" ||
+           suffix == "tiff" || (suffix == "bmp" && LITTLE_ENDIAN_HOST);
+}
+
+bool MappedImage::write(const QImage &image, const QString &fileName, QString *errorString,
+                        const std::atomic<bool> *cancelled, const ProgressCallback &progress)
+{
+    const auto fail = [errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        return false;
+    };
+
+    if (image.isNull()) {
+        return fail("没有可写出的图像");
+    }
+    Target target;
+    if (!buildTarget(image, QFileInfo(fileName).suffix().toLower().toLatin1(), &target)) {
+        return fail("不支持的格式或图像过大");
+    }
+
+    // 先写入同目录的临时文件，完成后替换目标文件
+    const QString partName = fileName + ".part";
+    QFile file(partName);
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return fail(file.errorString());
+    }
+    const int height = image.height();
+    const qint64 totalSize = target.header.size() + static_cast<qint64>(target.bytesPerLine) * height;
+    uchar *map = nullptr;
+    if (file.resize(totalSize)) {
+        map = file.map(0, totalSize);
+    }
+    if (!map) {
+        const QString error = file.errorString();
+        file.close();
+        file.remove();
+        return fail(error);
+    }
+
+    memcpy(map, target.header.constData(), static_cast<size_t>(target.header.size()));
+    uchar *pixels = map + target.header.size();
+
+    // 格式一致时逐行直接复制；否则按行块转换，转换的临时内存有上限
+    const bool sameFormat = image.format() == target.format;
+    const int rowBytes = target.bytesPerLine;
+    const int chunkRows = qMax(1, (4 << 20) / qMax(1, image.bytesPerLine()));
+    bool aborted = false;
+    for (int y = 0; y < height; y += chunkRows) {
+        if (cancelled && cancelled->load()) {
+            aborted = true;
+            break;
+        }
+        const int rows = qMin(chunkRows, height - y);
+        const QImage chunk = sameFormat ? image
+                                        : image.copy(0, y, image.width(), rows).convertToFormat(target.format);
+        const int chunkY = sameFormat ? y : 0;
+        for (int row = 0; row < rows; ++row) {
+            memcpy(pixels + static_cast<qint64>(y + row) * rowBytes, chunk.constScanLine(chunkY + row),
+                   static_cast<size_t>(rowBytes));
+        }
+        if (progress) {
+            progress((y + rows) * 100 / height);
+        }
+    }
+
+    file.unmap(map);
+    file.close();
+    if (aborted) {
+        file.remove();
+        return fail("已取消");
+    }
+    if (file.error() != QFileDevice::NoError) {
+        const QString error = file.errorString();
+        file.remove();
+        return fail(error);
+    }
+    // 目标仍被映射（Windows 上不允许替换）等失败情况下保留原目标文件
+    QString error;
+    if (!replaceFile(partName, fileName, &error)) {
+        file.remove();
+        return fail("无法替换文件: " + fileName + ": " + error);
+    }
+    return true;
+}
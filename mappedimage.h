@@ -0,0 +1,37 @@
+#ifndef MAPPEDIMAGE_H
+#define MAPPEDIMAGE_H
+
+#include <QImage>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+// 未压缩格式的内存映射读写
+// 读取时映射整个文件，把像素区域直接包装为只读 QImage，像素不经过解码器也不复制；
+// 映射随最后一个共享该数据的 QImage 一起释放。支持 8 位 PPM/PGM/PAM、
+// 24/32 位 BMP 与未压缩、按像素交错、条带连续的 8 位 TIFF。
+// 自下而上存储的 BMP 或未按四字节对齐的 32 位像素只能复制一次。
+// 无 alpha 的 32 位 BMP 只有保留字节全为 0xff 时才映射，否则不支持（由 QImageReader 解码）。
+// 映射期间源文件不应被原地改写；本类写出的文件总是整体替换目标文件
+class MappedImage
+{
+public:
+    // 参数为完成百分比
+    typedef std::function<void(int percent)> ProgressCallback;
+
+    // 解析文件头判断能否映射读取
+    static bool canRead(const QString &fileName);
+    // 不支持的文件返回空图像，调用方应回退到 QImageReader
+    static QImage read(const QString &fileName, QString *errorString = nullptr);
+
+    // 按后缀判断：ppm、pgm、pam、bmp、tif、tiff
+    static bool canWrite(const QString &fileName);
+    // 按头部与像素数据预先确定文件大小并映射，像素逐行直接写入映射区，
+    // 完成后原子替换目标文件。BMP 写为自上而下的 32 位，TIFF 写为单条带小端格式，
+    // 像素数据均从 16 字节对齐的偏移开始，读回时可直接映射
+    static bool write(const QImage &image, const QString &fileName, QString *errorString = nullptr,
+                      const std::atomic<bool> *cancelled = nullptr,
+                      const ProgressCallback &progress = ProgressCallback());
+};
+
+#endif // MAPPEDIMAGE_H
@@ -0,0 +1,153 @@
+#include "orientedimage.h"
+#include "parallelfor.h"
+#include <cstring>
+
+namespace {
+
+// 旋转时按块换算，块内读取的源图行与列都留在缓存中
+const int TILE_SIZE = 64;
+
+} // namespace
+
+OrientedImage::OrientedImage()
+    : m_transformation(QImageIOHandler::TransformationNone)
+{
+}
+
+OrientedImage::OrientedImage(const QImage &image, QImageIOHandler::Transformations transformation)
+    : m_image(image)
+    , m_transformation(transformation)
+{
+}
+
+QSize OrientedImage::size() const
+{
+    return (m_transformation & QImageIOHandler::TransformationRotate90) ? m_image.size().transposed()
+                                                                         : m_image.size();
+}
+
+QSize OrientedImage::storedSize(const QSize &displaySize) const
+{
+    return (m_transformation & QImageIOHandler::TransformationRotate90) ? displaySize.transposed()
+                                                                         : displaySize;
+}
+
+qint64 OrientedImage::cacheKey() const
+{
+    return m_image.cacheKey() ^ (static_cast<qint64>(m_transformation) << 56);
+}
+
+QPoint OrientedImage::toStored(const QPoint &point) const
+{
+    // 逆向执行：先撤销旋转，再撤销镜像
+    int x = point.x();
+    int y = point.y();
+    if (m_transformation & QImageIOHandler::TransformationRotate90) {
+        const int rotatedX = y;
+        y = m_image.height() - 1 - point.x();
+        x = rotatedX;
+    }
+    if (m_transformation & QImageIOHandler::TransformationMirror) {
+        x = m_image.width() - 1 - x;
+    }
+    if (m_transformation & QImageIOHandler::TransformationFlip) {
+        y = m_image.height() - 1 - y;
+    }
+    return QPoint(x, y);
+}
+
+QRect OrientedImage::toStored(const QRect &rect) const
+{
+    if (rect.isEmpty()) {
+        return QRect();
+    }
+    const QPoint first = toStored(rect.topLeft());
+    const QPoint second = toStored(rect.bottomRight());
+    return QRect(QPoint(qMin(first.x(), second.x()), qMin(first.y(), second.y())),
+                 QPoint(qMax(first.x(), second.x()), qMax(first.y(), second.y())));
+}
+
+QRgb OrientedImage::pixel(int x, int y) const
+{
+    return m_image.pixel(toStored(QPoint(x, y)));
+}
+
+void OrientedImage::copyTo(QImage &target, const QPoint &offset) const
+{
+    if (isNull()) {
+        return;
+    }
+
+    // 源图需为 32 位非预乘格式，才能按像素直接拷贝
+    const QImage source = (m_image.format() == QImage::Format_ARGB32 ||
+                           m_image.format() == QImage::Format_RGB32)
+                          ? m_image
+                          : m_image.convertToFormat(QImage::Format_ARGB32);
+    const int width = this->width();
+    const int height = this->height();
+    uchar *targetBits = target.bits();
+    const qsizetype targetStride = target.bytesPerLine();
+
+    if (!isTransformed()) {
+        const size_t rowBytes = static_cast<size_t>(width) * sizeof(QRgb);
+        for (int y = 0; y < height; ++y) {
+            QRgb *destLine = reinterpret_cast<QRgb*>(targetBits + (offset.y() + y) * targetStride);
+            std::memcpy(destLine + offset.x(), source.constScanLine(y), rowBytes);
+        }
+        return;
+    }
+
+    // 显示坐标沿 x 方向前进一个像素时，存储坐标的变化是固定的
+    const QRgb *sourcePixels = reinterpret_cast<const QRgb*>(source.constBits());
+    const ptrdiff_t sourceStride = source.bytesPerLine() / static_cast<int>(sizeof(QRgb));
+    const QPoint origin = toStored(QPoint(0, 0));
+    const QPoint nextX = toStored(QPoint(1, 0));
+    const QPoint nextY = toStored(QPoint(0, 1));
+    const ptrdiff_t stepX = (nextX.x() - origin.x()) + (nextX.y() - origin.y()) * sourceStride;
+    const ptrdiff_t stepY = (nextY.x() - origin.x()) + (nextY.y() - origin.y()) * sourceStride;
+    const QRgb *originPixel = sourcePixels + origin.x() + origin.y() * sourceStride;
+
+    const int bands = (height + TILE_SIZE - 1) / TILE_SIZE;
+    parallelFor(bands, [&](int band) {
+        const int y0 = band * TILE_SIZE;
+        const int y1 = qMin(height, y0 + TILE_SIZE);
+        for (int x0 = 0; x0 < width; x0 += TILE_SIZE) {
+            const int x1 = qMin(width, x0 + TILE_SIZE);
+            for (int y = y0; y < y1; ++y) {
+                QRgb *dest = reinterpret_cast<QRgb*>(targetBits + (offset.y() + y) * targetStride) +
+                             offset.x();
+                const QRgb *src = originPixel + y * stepY + x0 * stepX;
+                for (int x = x0; x < x1; ++x) {
+                    dest[x] = *src;
+                    src += stepX;
+                }
+            }
+        }
+    });
+}
+
+QImage OrientedImage::toImage() const
+{
+    if (!isTransformed() || isNull()) {
+        return m_image;
+    }
+    QImage result(size(), hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    if (result.isNull()) {
+        return result;
+    }
+    copyTo(result, QPoint(0, 0));
+    result.setDevicePixelRatio(m_image.devicePixelRatio());
+    result.setDotsPerMeterX(m_image.dotsPerMeterX());
+    result.setDotsPerMeterY(m_image.dotsPerMeterY());
+    return result;
+}
+
+OrientedImage OrientedImage::scaled(const QSize &size, Qt::TransformationMode mode) const
+{
+    return OrientedImage(m_image.scaled(storedSize(size), Qt::IgnoreAspectRatio, mode), m_transformation);
+}
+
+OrientedImage OrientedImage::resized(const QSize &size, Resampler::Filter filter) const
+{
+    return OrientedImage(Resampler::resize(m_image, storedSize(size), filter), m_transformation);
+}
@@ -0,0 +1,67 @@
+#ifndef ORIENTEDIMAGE_H
+#define ORIENTEDIMAGE_H
+
+#include <QImage>
+#include <QImageIOHandler>
+#include <QMetaType>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include "resampler.h"
+
+// 带 EXIF 方向的图像
+// 像素保持存储方向，方向只作为元数据携带；尺寸与坐标均按显示方向给出，
+// 读取像素时换算到存储坐标。需要显示方向的像素时（合成画布、显示）
+// 在写入目标缓冲的同一遍中完成旋转，不生成旋转后的整图中间结果。
+// 方向的含义与 QImageReader 的自动变换一致：先水平/垂直镜像，再顺时针旋转 90 度
+class OrientedImage
+{
+public:
+    OrientedImage();
+    // 允许由 QImage 隐式构造（无方向变换）
+    OrientedImage(const QImage &image,
+                  QImageIOHandler::Transformations transformation = QImageIOHandler::TransformationNone);
+
+    bool isNull() const { return m_image.isNull(); }
+    bool isTransformed() const { return m_transformation != QImageIOHandler::TransformationNone; }
+
+    // 显示方向的尺寸
+    QSize size() const;
+    int width() const { return size().width(); }
+    int height() const { return size().height(); }
+
+    const QImage &storedImage() const { return m_image; }
+    QImageIOHandler::Transformations transformation() const { return m_transformation; }
+
+    bool hasAlphaChannel() const { return m_image.hasAlphaChannel(); }
+    qreal devicePixelRatio() const { return m_image.devicePixelRatio(); }
+    // 标识共享的像素数据与方向
+    qint64 cacheKey() const;
+
+    // 显示坐标换算为存储坐标
+    QPoint toStored(const QPoint &point) const;
+    QRect toStored(const QRect &rect) const;
+
+    // 按显示坐标读取像素
+    QRgb pixel(int x, int y) const;
+    QRgb pixel(const QPoint &point) const { return pixel(point.x(), point.y()); }
+
+    // 把显示方向的像素写入 32 位画布 target 中以 offset 为左上角的区域
+    void copyTo(QImage &target, const QPoint &offset) const;
+    // 显示方向的图像；没有方向变换时直接返回存储的图像，不复制
+    QImage toImage() const;
+
+    // 缩放到显示方向的 size：在存储方向上缩放，方向元数据保持不变
+    OrientedImage scaled(const QSize &size, Qt::TransformationMode mode) const;
+    OrientedImage resized(const QSize &size, Resampler::Filter filter) const;
+
+private:
+    QSize storedSize(const QSize &displaySize) const;
+
+    QImage m_image;
+    QImageIOHandler::Transformations m_transformation;
+};
+
+Q_DECLARE_METATYPE(OrientedImage)
+
+#endif // ORIENTEDIMAGE_H
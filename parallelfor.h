@@ -0,0 +1,44 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <QThreadPool>
+#include <QSemaphore>
+#include <atomic>
+#include <functional>
+
+// 在全局线程池上并行执行 body(0) ... body(count - 1)
+// 调用线程同样参与计算；只借用当前空闲的线程（tryStart），
+// 因此在线程池任务内部嵌套调用也不会死锁
+inline void parallelFor(int count, const std::function<void(int)> &body)
+{
+    if (count <= 0) {
+        return;
+    }
+    
+    std::atomic<int> next(0);
+    auto worker = [&next, &body, count]() {
+        for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            body(i);
+        }
+    };
+    
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int helpers = qMin(count, pool->maxThreadCount()) - 1;
+    
+    QSemaphore finished;
+    int started = 0;
+    for (int i = 0; i < helpers; ++i) {
+        if (!pool->tryStart([&worker, &finished]() {
+                worker();
+                finished.release();
+            })) {
+            break;
+        }
+        ++started;
+    }
+    
+    worker();
+    finished.acquire(started);
+}
+
+#endif // PARALLELFOR_H
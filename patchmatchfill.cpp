@@ -0,0 +1,433 @@
+#include "patchmatchfill.h"
+#include "fillkernels.h"
+#include "parallelfor.h"
+#include <climits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+inline const QRgb *imageLine(const QImage &image, int y)
+{
+    return reinterpret_cast<const QRgb*>(image.constScanLine(y));
+}
+
+inline QRgb *imageLine(QImage &image, int y)
+{
+    return reinterpret_cast<QRgb*>(image.scanLine(y));
+}
+
+// NNF 条目：源补丁中心坐标打包为 16 位 x / 16 位 y
+inline quint32 packMatch(int x, int y)
+{
+    return static_cast<quint32>(x) | (static_cast<quint32>(y) << 16);
+}
+
+inline int matchX(quint32 match) { return static_cast<int>(match & 0xffff); }
+inline int matchY(quint32 match) { return static_cast<int>(match >> 16); }
+
+// splitmix32 风格的整数哈希，用于确定性随机数
+inline quint32 mixBits(quint32 value)
+{
+    value += 0x9e3779b9u;
+    value = (value ^ (value >> 16)) * 0x85ebca6bu;
+    value = (value ^ (value >> 13)) * 0xc2b2ae35u;
+    return value ^ (value >> 16);
+}
+
+class Random
+{
+public:
+    explicit Random(quint32 seed) : m_state(mixBits(seed) | 1u) {}
+    
+    // [-range, range] 内的整数
+    int offset(int range)
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return static_cast<int>(m_state % static_cast<quint32>(2 * range + 1)) - range;
+    }
+    
+private:
+    quint32 m_state;
+};
+
+// 2x2 盒式降采样
+QImage downsample(const QImage &image)
+{
+    const int width = qMax(1, (image.width() + 1) / 2);
+    const int height = qMax(1, (image.height() + 1) / 2);
+    QImage result(width, height, QImage::Format_ARGB32);
+    
+    parallelFor(height, [&image, &result, width](int y) {
+        const QRgb *upper = imageLine(image, qMin(2 * y, image.height() - 1));
+        const QRgb *lower = imageLine(image, qMin(2 * y + 1, image.height() - 1));
+        QRgb *out = imageLine(result, y);
+        
+        for (int x = 0; x < width; ++x) {
+            const int x0 = qMin(2 * x, image.width() - 1);
+            const int x1 = qMin(2 * x + 1, image.width() - 1);
+            const QRgb p[4] = { upper[x0], upper[x1], lower[x0], lower[x1] };
+            
+            const int a = (qAlpha(p[0]) + qAlpha(p[1]) + qAlpha(p[2]) + qAlpha(p[3]) + 2) >> 2;
+            const int r = (qRed(p[0]) + qRed(p[1]) + qRed(p[2]) + qRed(p[3]) + 2) >> 2;
+            const int g = (qGreen(p[0]) + qGreen(p[1]) + qGreen(p[2]) + qGreen(p[3]) + 2) >> 2;
+            const int b = (qBlue(p[0]) + qBlue(p[1]) + qBlue(p[2]) + qBlue(p[3]) + 2) >> 2;
+            out[x] = qRgba(r, g, b, a);
+        }
+    });
+    
+    return result;
+}
+
+// 降采样后只保留完全由源像素构成的区域
+QRect downsampleRect(const QRect &rect)
+{
+    const int left = (rect.left() + 1) / 2;
+    const int top = (rect.top() + 1) / 2;
+    const int right = (rect.right() + 1) / 2 - 1;
+    const int bottom = (rect.bottom() + 1) / 2 - 1;
+    return QRect(left, top, right - left + 1, bottom - top + 1);
+}
+
+// 单个金字塔层上的 PatchMatch 求解
+class LevelSolver
+{
+public:
+    LevelSolver(QImage &image, const QRect &source, int radius, int tileSize,
+                quint32 seed, int levelIndex)
+        : m_image(image)
+        , m_source(source)
+        , m_radius(radius)
+        , m_tileSize(tileSize)
+        , m_seed(seed)
+        , m_levelIndex(levelIndex)
+        , m_width(image.width())
+        , m_height(image.height())
+        , m_minX(source.left() + radius)
+        , m_maxX(source.right() - radius)
+        , m_minY(source.top() + radius)
+        , m_maxY(source.bottom() - radius)
+        , m_tilesX((image.width() + tileSize - 1) / tileSize)
+        , m_tilesY((image.height() + tileSize - 1) / tileSize)
+        , m_nnf(static_cast<size_t>(image.width()) * image.height(), 0)
+        , m_previous(m_nnf.size(), 0)
+    {
+    }
+    
+    bool isMargin(int x, int y) const { return !m_source.contains(x, y); }
+    
+    quint32 clampMatch(int x, int y) const
+    {
+        return packMatch(qBound(m_minX, x, m_maxX), qBound(m_minY, y, m_maxY));
+    }
+    
+    // 源像素的匹配定义为其自身位置，便于向细层传递
+    quint32 matchAt(int x, int y) const
+    {
+        if (isMargin(x, y)) {
+            return m_nnf[static_cast<size_t>(y) * m_width + x];
+        }
+        return clampMatch(x, y);
+    }
+    
+    void initializeRandom()
+    {
+        parallelFor(m_height, [this](int y) {
+            for (int x = 0; x < m_width; ++x) {
+                if (!isMargin(x, y)) {
+                    continue;
+                }
+                const quint32 hash = mixBits(m_seed ^ mixBits(static_cast<quint32>(y * m_width + x)));
+                const int sx = m_minX + static_cast<int>(hash % static_cast<quint32>(m_maxX - m_minX + 1));
+                const int sy = m_minY + static_cast<int>((hash >> 16) % static_cast<quint32>(m_maxY - m_minY + 1));
+                m_nnf[static_cast<size_t>(y) * m_width + x] = packMatch(sx, sy);
+            }
+        });
+    }
+    
+    void initializeFrom(const LevelSolver &coarse)
+    {
+        parallelFor(m_height, [this, &coarse](int y) {
+            const int cy = qMin(y / 2, coarse.m_height - 1);
+            for (int x = 0; x < m_width; ++x) {
+                if (!isMargin(x, y)) {
+                    continue;
+                }
+                const int cx = qMin(x / 2, coarse.m_width - 1);
+                const quint32 match = coarse.matchAt(cx, cy);
+                m_nnf[static_cast<size_t>(y) * m_width + x] =
+                    clampMatch(2 * matchX(match) + (x & 1), 2 * matchY(match) + (y & 1));
+            }
+        });
+    }
+    
+    // 一轮传播 + 随机搜索；randomRadius 为 0 时只做传播
+    void search(int iteration, int randomRadius)
+    {
+        std::swap(m_nnf, m_previous);
+        const bool reverse = (iteration & 1) != 0;
+        
+        parallelFor(m_tilesX * m_tilesY, [this, iteration, randomRadius, reverse](int tile) {
+            searchTile(tile, iteration, randomRadius, reverse);
+        });
+    }
+    
+    // 补丁投票：每个边距像素取所有覆盖它的补丁所对应源像素的平均值
+    void vote()
+    {
+        parallelFor(m_height, [this](int y) {
+            QRgb *out = imageLine(m_image, y);
+            for (int x = 0; x < m_width; ++x) {
+                if (!isMargin(x, y)) {
+                    x = m_source.right();
+                    continue;
+                }
+                
+                int sumA = 0, sumR = 0, sumG = 0, sumB = 0, count = 0;
+                for (int dy = -m_radius; dy <= m_radius; ++dy) {
+                    const int py = y - dy;
+                    if (py < 0 || py >= m_height) {
+                        continue;
+                    }
+                    for (int dx = -m_radius; dx <= m_radius; ++dx) {
+                        const int px = x - dx;
+                        if (px < 0 || px >= m_width || !isMargin(px, py)) {
+                            continue;
+                        }
+                        const quint32 match = m_nnf[static_cast<size_t>(py) * m_width + px];
+                        const QRgb pixel = imageLine(m_image, matchY(match) + dy)[matchX(match) + dx];
+                        sumA += qAlpha(pixel);
+                        sumR += qRed(pixel);
+                        sumG += qGreen(pixel);
+                        sumB += qBlue(pixel);
+                        ++count;
+                    }
+                }
+                
+                if (count > 0) {
+                    const int half = count / 2;
+                    out[x] = qRgba((sumR + half) / count, (sumG + half) / count,
+                                   (sumB + half) / count, (sumA + half) / count);
+                }
+            }
+        });
+    }
+    
+private:
+    int tileOf(int x, int y) const
+    {
+        return (y / m_tileSize) * m_tilesX + x / m_tileSize;
+    }
+    
+    // 同一图块内读取本轮结果，其他图块读取上一轮结果，保证确定性
+    quint32 neighbourMatch(int x, int y, int tile) const
+    {
+        const size_t index = static_cast<size_t>(y) * m_width + x;
+        return tileOf(x, y) == tile ? m_nnf[index] : m_previous[index];
+    }
+    
+    int distance(int px, int py, quint32 match, int best) const
+    {
+        const int qx = matchX(match);
+        const int qy = matchY(match);
+        int sum = 0;
+        
+        for (int dy = -m_radius; dy <= m_radius; ++dy) {
+            const int ty = py + dy;
+            if (ty < 0 || ty >= m_height) {
+                continue;
+            }
+            const QRgb *target = imageLine(m_image, ty);
+            const QRgb *source = imageLine(m_image, qy + dy) + qx;
+            const int x0 = qMax(-m_radius, -px);
+            const int x1 = qMin(m_radius, m_width - 1 - px);
+            
+            for (int dx = x0; dx <= x1; ++dx) {
+                const QRgb a = target[px + dx];
+                const QRgb b = source[dx];
+                const int dr = qRed(a) - qRed(b);
+                const int dg = qGreen(a) - qGreen(b);
+                const int db = qBlue(a) - qBlue(b);
+                const int da = qAlpha(a) - qAlpha(b);
+                sum += dr * dr + dg * dg + db * db + da * da;
+            }
+            
+            // 提前终止：已不可能优于当前最佳
+            if (sum >= best) {
+                return sum;
+            }
+        }
+        
+        return sum;
+    }
+    
+    void searchTile(int tile, int iteration, int randomRadius, bool reverse)
+    {
+        const int x0 = (tile % m_tilesX) * m_tileSize;
+        const int y0 = (tile / m_tilesX) * m_tileSize;
+        const int x1 = qMin(x0 + m_tileSize, m_width) - 1;
+        const int y1 = qMin(y0 + m_tileSize, m_height) - 1;
+        
+        // 完全位于源图内的图块无需处理
+        if (m_source.contains(x0, y0) && m_source.contains(x1, y1)) {
+            return;
+        }
+        
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                const size_t index = static_cast<size_t>(y) * m_width + x;
+                m_nnf[index] = m_previous[index];
+            }
+        }
+        
+        Random random(m_seed ^ mixBits(static_cast<quint32>(m_levelIndex) * 0x10001u) ^
+                      mixBits(static_cast<quint32>(iteration) * 0x3c6ef372u + static_cast<quint32>(tile)));
+        const int step = reverse ? -1 : 1;
+        const int yStart = reverse ? y1 : y0;
+        const int yEnd = reverse ? y0 - 1 : y1 + 1;
+        const int xStart = reverse ? x1 : x0;
+        const int xEnd = reverse ? x0 - 1 : x1 + 1;
+        
+        for (int y = yStart; y != yEnd; y += step) {
+            for (int x = xStart; x != xEnd; x += step) {
+                if (!isMargin(x, y)) {
+                    continue;
+                }
+                
+                const size_t index = static_cast<size_t>(y) * m_width + x;
+                quint32 best = m_nnf[index];
+                int bestDistance = distance(x, y, best, INT_MAX);
+                
+                auto tryMatch = [&](quint32 candidate) {
+                    if (candidate == best) {
+                        return;
+                    }
+                    const int d = distance(x, y, candidate, bestDistance);
+                    if (d < bestDistance) {
+                        bestDistance = d;
+                        best = candidate;
+                    }
+                };
+                
+                // 传播：沿扫描方向的前一个邻居的匹配平移一步
+                const int nx = x - step;
+                if (nx >= 0 && nx < m_width && isMargin(nx, y)) {
+                    const quint32 match = neighbourMatch(nx, y, tile);
+                    tryMatch(clampMatch(matchX(match) + step, matchY(match)));
+                }
+                const int ny = y - step;
+                if (ny >= 0 && ny < m_height && isMargin(x, ny)) {
+                    const quint32 match = neighbourMatch(x, ny, tile);
+                    tryMatch(clampMatch(matchX(match), matchY(match) + step));
+                }
+                
+                // 随机搜索：半径逐次减半
+                for (int radius = randomRadius; radius >= 1; radius /= 2) {
+                    tryMatch(clampMatch(matchX(best) + random.offset(radius),
+                                        matchY(best) + random.offset(radius)));
+                }
+                
+                m_nnf[index] = best;
+            }
+        }
+    }
+    
+    QImage &m_image;
+    const QRect m_source;
+    const int m_radius;
+    const int m_tileSize;
+    const quint32 m_seed;
+    const int m_levelIndex;
+    const int m_width;
+    const int m_height;
+    const int m_minX;
+    const int m_maxX;
+    const int m_minY;
+    const int m_maxY;
+    const int m_tilesX;
+    const int m_tilesY;
+    std::vector<quint32> m_nnf;
+    std::vector<quint32> m_previous;
+};
+
+} // namespace
+
+PatchMatchFill::Options PatchMatchFill::defaultOptions()
+{
+    Options options;
+    options.patchRadius = 2;
+    options.coarsestSize = 32;
+    options.tileSize = 64;
+    options.seed = 0x5eed1234u;
+    return options;
+}
+
+bool PatchMatchFill::fill(QImage &canvas, const QRect &sourceRect, const Options &options)
+{
+    const int radius = qMax(1, options.patchRadius);
+    const int minimumSide = 2 * radius + 1;
+    
+    if (sourceRect.width() < minimumSide || sourceRect.height() < minimumSide ||
+        canvas.width() > 0xffff || canvas.height() > 0xffff ||
+        canvas.rect() == sourceRect) {
+        return false;
+    }
+    
+    // 构建金字塔：最粗层源图短边不小于 coarsestSize
+    std::vector<QImage> images;
+    std::vector<QRect> sources;
+    images.push_back(std::move(canvas));
+    sources.push_back(sourceRect);
+    
+    while (true) {
+        const QRect next = downsampleRect(sources.back());
+        if (next.width() < qMax(options.coarsestSize, minimumSide) ||
+            next.height() < qMax(options.coarsestSize, minimumSide)) {
+            break;
+        }
+        images.push_back(downsample(images.back()));
+        sources.push_back(next);
+    }
+    
+    const int levelCount = static_cast<int>(images.size());
+    const int coarsest = levelCount - 1;
+    
+    // 最粗层用模糊边缘延伸作为初值
+    FillKernels::fillBlurredEdge(images[coarsest], sources[coarsest]);
+    
+    std::unique_ptr<LevelSolver> previous;
+    
+    for (int level = coarsest; level >= 0; --level) {
+        std::unique_ptr<LevelSolver> solver(new LevelSolver(images[level], sources[level], radius,
+                                                            options.tileSize, options.seed, level));
+        
+        if (previous) {
+            solver->initializeFrom(*previous);
+            solver->vote();
+            previous.reset();
+        } else {
+            solver->initializeRandom();
+        }
+        
+        // 粗层多次 EM 迭代并做大范围随机搜索；最细层只做局部搜索以控制耗时
+        const int emIterations = level == 0 ? 1 : qMin(2 + level, 5);
+        const int maxSide = qMax(sources[level].width(), sources[level].height());
+        const int randomRadius = level == 0 ? qMin(4, maxSide) :
+                                 level == coarsest ? maxSide : qMin(maxSide, 16);
+        
+        for (int em = 0; em < emIterations; ++em) {
+            solver->search(em * 2, randomRadius);
+            solver->search(em * 2 + 1, randomRadius);
+            solver->vote();
+        }
+        
+        previous = std::move(solver);
+    }
+    
+    previous.reset();
+    canvas = std::move(images[0]);
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef PATCHMATCHFILL_H
+#define PATCHMATCHFILL_H
+
+#include <QImage>
+#include <QRect>
+
+// 基于 PatchMatch 的内容感知边距填充
+// 在多尺度金字塔上由粗到细求解最近邻场（NNF），再通过补丁投票合成边距。
+// 按图块并行：图块内按扫描顺序传播，跨图块只读取上一轮的结果，
+// 随机数按（层级、迭代、图块）确定性播种，因此结果与线程调度无关。
+class PatchMatchFill
+{
+public:
+    struct Options {
+        int patchRadius;        // 补丁半径（补丁边长 2r+1）
+        int coarsestSize;       // 最粗层源图短边的最小尺寸
+        int tileSize;           // 并行图块边长
+        quint32 seed;           // 随机种子
+    };
+    
+    static Options defaultOptions();
+    
+    // 合成 canvas 中 sourceRect 之外的区域（画布为 ARGB32 / RGB32）
+    // 源图太小无法取完整补丁时返回 false，画布保持不变
+    static bool fill(QImage &canvas, const QRect &sourceRect,
+                     const Options &options = defaultOptions());
+};
+
+#endif // PATCHMATCHFILL_H
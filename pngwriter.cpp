@@ -0,0 +1,327 @@
+#include "pngwriter.h"
+#include "deflateencoder.h"
+#include "parallelfor.h"
+#include <QHash>
+#include <QIODevice>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const uchar PNG_SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+// 每个行组滤波后的目标数据量：足够大以保持压缩率，又能分出足够多的并行任务
+const size_t TARGET_GROUP_BYTES = 256 * 1024;
+const int REPEAT_SCAN_ROWS = 256;
+
+enum FilterType {
+    FilterNone = 0,
+    FilterSub = 1,
+    FilterUp = 2,
+    FilterAverage = 3,
+    FilterPaeth = 4
+};
+
+const quint32 *crcTable()
+{
+    static const struct Table {
+        quint32 values[256];
+        Table()
+        {
+            for (quint32 n = 0; n < 256; ++n) {
+                quint32 c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                values[n] = c;
+            }
+        }
+    } table;
+    return table.values;
+}
+
+quint32 updateCrc(quint32 crc, const uchar *data, size_t size)
+{
+    const quint32 *table = crcTable();
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+quint32 chunkCrc(const char *type, const uchar *data, size_t size)
+{
+    const quint32 crc = updateCrc(0xffffffffu, reinterpret_cast<const uchar*>(type), 4);
+    return updateCrc(crc, data, size) ^ 0xffffffffu;
+}
+
+inline int paethPredictor(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = qAbs(p - a);
+    const int pb = qAbs(p - b);
+    const int pc = qAbs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+template <int Filter>
+inline uchar predict(int a, int b, int c)
+{
+    switch (Filter) {
+    case FilterSub:
+        return static_cast<uchar>(a);
+    case FilterUp:
+        return static_cast<uchar>(b);
+    case FilterAverage:
+        return static_cast<uchar>((a + b) >> 1);
+    case FilterPaeth:
+        return static_cast<uchar>(paethPredictor(a, b, c));
+    default:
+        return 0;
+    }
+}
+
+// 滤波结果按有符号字节取绝对值求和；超过 limit 时提前结束
+template <int Filter>
+quint64 filterCost(const uchar *row, const uchar *prior, int rowBytes, int bpp, quint64 limit)
+{
+    quint64 sum = 0;
+    for (int i = 0; i < bpp && i < rowBytes; ++i) {
+        const uchar value = static_cast<uchar>(row[i] - predict<Filter>(0, prior[i], 0));
+        sum += value < 128 ? value : 256 - value;
+    }
+    for (int i = bpp; i < rowBytes && sum < limit; ++i) {
+        const uchar value = static_cast<uchar>(
+            row[i] - predict<Filter>(row[i - bpp], prior[i], prior[i - bpp]));
+        sum += value < 128 ? value : 256 - value;
+    }
+    return sum;
+}
+
+template <int Filter>
+void applyFilter(const uchar *row, const uchar *prior, int rowBytes, int bpp, uchar *out)
+{
+    for (int i = 0; i < bpp && i < rowBytes; ++i) {
+        out[i] = static_cast<uchar>(row[i] - predict<Filter>(0, prior[i], 0));
+    }
+    for (int i = bpp; i < rowBytes; ++i) {
+        out[i] = static_cast<uchar>(row[i] - predict<Filter>(row[i - bpp], prior[i], prior[i - bpp]));
+    }
+}
+
+// 对一行滤波并写入 out（首字节为滤波类型）
+// 按滤波结果的有符号绝对值之和最小选择滤波器（libpng 的启发式）
+void filterRow(const uchar *row, const uchar *prior, int rowBytes, int bpp, uchar *out)
+{
+    typedef quint64 (*CostFunction)(const uchar*, const uchar*, int, int, quint64);
+    typedef void (*ApplyFunction)(const uchar*, const uchar*, int, int, uchar*);
+    static const CostFunction costs[] = {
+        filterCost<FilterNone>, filterCost<FilterSub>, filterCost<FilterUp>,
+        filterCost<FilterAverage>, filterCost<FilterPaeth>
+    };
+    static const ApplyFunction filters[] = {
+        applyFilter<FilterNone>, applyFilter<FilterSub>, applyFilter<FilterUp>,
+        applyFilter<FilterAverage>, applyFilter<FilterPaeth>
+    };
+
+    int bestFilter = FilterNone;
+    quint64 bestSum = ~quint64(0);
+    for (int filter = FilterNone; filter <= FilterPaeth; ++filter) {
+        const quint64 sum = costs[filter](row, prior, rowBytes, bpp, bestSum);
+        if (sum < bestSum) {
+            bestSum = sum;
+            bestFilter = filter;
+        }
+    }
+
+    out[0] = static_cast<uchar>(bestFilter);
+    filters[bestFilter](row, prior, rowBytes, bpp, out + 1);
+}
+
+// 压缩后的行组；连续相同行组成的行组按行数共享同一份结果
+struct EncodedGroup {
+    int firstRow;
+    int rowCount;
+    bool repeatRun;
+    std::vector<uchar> data;
+    quint32 crc;
+    quint32 adler;
+    quint64 rawLength;
+};
+
+} // namespace
+
+PngWriter::PngWriter(int compressionLevel)
+    : m_compressionLevel(qBound(0, compressionLevel, 9))
+{
+}
+
+bool PngWriter::write(const QImage &image, QIODevice *device,
+                      const std::atomic<bool> *cancelled,
+                      const ProgressCallback &progress)
+{
+    m_errorString.clear();
+    if (image.isNull()) {
+        m_errorString = "没有可写入的图像";
+        return false;
+    }
+
+    // 内存中的字节顺序即为 PNG 的 RGB/RGBA 顺序
+    const bool alpha = image.hasAlphaChannel();
+    const QImage source = image.convertToFormat(alpha ? QImage::Format_RGBA8888
+                                                      : QImage::Format_RGB888);
+    const int width = source.width();
+    const int height = source.height();
+    const int bpp = alpha ? 4 : 3;
+    const int rowBytes = width * bpp;
+    const size_t filteredRowBytes = static_cast<size_t>(rowBytes) + 1;
+    const uchar *bits = source.constBits();
+    const ptrdiff_t stride = source.bytesPerLine();
+
+    // 标记与上一行完全相同的行
+    std::vector<uchar> repeated(height, 0);
+    parallelFor((height + REPEAT_SCAN_ROWS - 1) / REPEAT_SCAN_ROWS, [&](int block) {
+        const int first = qMax(1, block * REPEAT_SCAN_ROWS);
+        const int last = qMin(height, (block + 1) * REPEAT_SCAN_ROWS);
+        for (int y = first; y < last; ++y) {
+            repeated[y] = std::memcmp(bits + y * stride, bits + (y - 1) * stride, rowBytes) == 0;
+        }
+    });
+
+    // 划分行组：全部由重复行组成的行组滤波后内容只取决于行数，共享编码结果
+    const int rowsPerGroup = static_cast<int>(qMax<size_t>(1, TARGET_GROUP_BYTES / filteredRowBytes));
+    std::vector<EncodedGroup> encoded;
+    std::vector<int> groupSlots;
+    QHash<int, int> repeatSlots;
+    for (int firstRow = 0; firstRow < height; firstRow += rowsPerGroup) {
+        const int rowCount = qMin(rowsPerGroup, height - firstRow);
+        bool repeatRun = true;
+        for (int y = firstRow; y < firstRow + rowCount && repeatRun; ++y) {
+            repeatRun = repeated[y] != 0;
+        }
+        int slot = repeatRun ? repeatSlots.value(rowCount, -1) : -1;
+        if (slot < 0) {
+            slot = static_cast<int>(encoded.size());
+            EncodedGroup group;
+            group.firstRow = firstRow;
+            group.rowCount = rowCount;
+            group.repeatRun = repeatRun;
+            group.crc = 0;
+            group.adler = 1;
+            group.rawLength = 0;
+            encoded.push_back(group);
+            if (repeatRun) {
+                repeatSlots.insert(rowCount, slot);
+            }
+        }
+        groupSlots.push_back(slot);
+    }
+
+    // 各行组独立滤波、压缩并计算校验和
+    const DeflateEncoder encoder(m_compressionLevel);
+    const std::vector<uchar> zeroRow(rowBytes, 0);
+    QMutex progressMutex;
+    int done = 0;
+    const int total = static_cast<int>(encoded.size());
+    parallelFor(total, [&](int index) {
+        if (cancelled && cancelled->load()) {
+            return;
+        }
+        EncodedGroup &group = encoded[index];
+        std::vector<uchar> filtered(filteredRowBytes * group.rowCount, 0);
+        for (int i = 0; i < group.rowCount; ++i) {
+            const int y = group.firstRow + i;
+            uchar *out = filtered.data() + filteredRowBytes * i;
+            if (group.repeatRun || repeated[y]) {
+                // 与上一行相同：Up 滤波后全为零
+                out[0] = FilterUp;
+                continue;
+            }
+            const uchar *prior = y > 0 ? bits + (y - 1) * stride : zeroRow.data();
+            filterRow(bits + y * stride, prior, rowBytes, bpp, out);
+        }
+
+        encoder.compressSegment(filtered.data(), filtered.size(), group.data);
+        group.adler = DeflateEncoder::adler32(filtered.data(), filtered.size());
+        group.rawLength = filtered.size();
+        group.crc = chunkCrc("IDAT", group.data.data(), group.data.size());
+
+        if (progress) {
+            QMutexLocker locker(&progressMutex);
+            progress(++done, total);
+        }
+    });
+
+    if (cancelled && cancelled->load()) {
+        m_errorString = "导出已取消";
+        return false;
+    }
+
+    // 依次写出各数据块
+    bool ok = true;
+    const auto writeChunk = [&](const char *type, const uchar *data, size_t size, quint32 crc) {
+        uchar header[8];
+        qToBigEndian<quint32>(static_cast<quint32>(size), header);
+        std::memcpy(header + 4, type, 4);
+        uchar trailer[4];
+        qToBigEndian<quint32>(crc, trailer);
+        ok = ok &&
+             device->write(reinterpret_cast<const char*>(header), 8) == 8 &&
+             (size == 0 || device->write(reinterpret_cast<const char*>(data), size) ==
+                           static_cast<qint64>(size)) &&
+             device->write(reinterpret_cast<const char*>(trailer), 4) == 4;
+    };
+    const auto writeSmallChunk = [&](const char *type, const uchar *data, size_t size) {
+        writeChunk(type, data, size, chunkCrc(type, data, size));
+    };
+
+    ok = device->write(reinterpret_cast<const char*>(PNG_SIGNATURE), 8) == 8;
+
+    uchar header[13];
+    qToBigEndian<quint32>(static_cast<quint32>(width), header);
+    qToBigEndian<quint32>(static_cast<quint32>(height), header + 4);
+    header[8] = 8;                  // 位深度
+    header[9] = alpha ? 6 : 2;      // 颜色类型：RGBA 或 RGB
+    header[10] = 0;                 // 压缩方法
+    header[11] = 0;                 // 滤波方法
+    header[12] = 0;                 // 不隔行
+    writeSmallChunk("IHDR", header, sizeof(header));
+
+    if (image.dotsPerMeterX() > 0 && image.dotsPerMeterY() > 0) {
+        uchar physical[9];
+        qToBigEndian<quint32>(static_cast<quint32>(image.dotsPerMeterX()), physical);
+        qToBigEndian<quint32>(static_cast<quint32>(image.dotsPerMeterY()), physical + 4);
+        physical[8] = 1;            // 单位：米
+        writeSmallChunk("pHYs", physical, sizeof(physical));
+    }
+
+    // zlib 流头、各行组的压缩数据与结尾分别放在独立的 IDAT 中，
+    // 行组的 CRC 已在压缩时算好，共享的行组直接重复写出
+    uchar zlibHeader[2];
+    qToBigEndian<quint16>(DeflateEncoder::zlibHeader(m_compressionLevel), zlibHeader);
+    writeSmallChunk("IDAT", zlibHeader, sizeof(zlibHeader));
+
+    quint32 adler = 1;
+    for (int slot : groupSlots) {
+        const EncodedGroup &group = encoded[slot];
+        writeChunk("IDAT", group.data.data(), group.data.size(), group.crc);
+        adler = DeflateEncoder::adler32Combine(adler, group.adler, group.rawLength);
+    }
+
+    std::vector<uchar> trailer;
+    DeflateEncoder::appendFinalBlock(trailer);
+    trailer.resize(trailer.size() + 4);
+    qToBigEndian<quint32>(adler, trailer.data() + trailer.size() - 4);
+    writeSmallChunk("IDAT", trailer.data(), trailer.size());
+    writeSmallChunk("IEND", nullptr, 0);
+
+    if (!ok) {
+        m_errorString = device->errorString();
+    }
+    return ok;
+}
@@ -0,0 +1,39 @@
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <QImage>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+class QIODevice;
+
+// 并行 PNG 编码
+// 图像按行分组，各组的滤波与 deflate 压缩在线程池中独立进行，
+// 输出拼接为一个 zlib 流（校验和由各组的 adler32 合并得到）。
+// 与上一行完全相同的行（纯色背景）组成的行组内容一致，只压缩一次并重复使用
+class PngWriter
+{
+public:
+    // 参数为已完成与总共的行组数
+    typedef std::function<void(int done, int total)> ProgressCallback;
+
+    explicit PngWriter(int compressionLevel = 6);
+
+    // 压缩级别 0-9
+    void setCompressionLevel(int level) { m_compressionLevel = qBound(0, level, 9); }
+    int compressionLevel() const { return m_compressionLevel; }
+
+    // 写入 8 位 RGB（无 alpha）或 RGBA 图像；cancelled 置位后尽快返回 false
+    bool write(const QImage &image, QIODevice *device,
+               const std::atomic<bool> *cancelled = nullptr,
+               const ProgressCallback &progress = ProgressCallback());
+
+    QString errorString() const { return m_errorString; }
+
+private:
+    int m_compressionLevel;
+    QString m_errorString;
+};
+
+#endif // PNGWRITER_H
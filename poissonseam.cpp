@@ -0,0 +1,278 @@
+#include "poissonseam.h"
+#include "parallelfor.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// 边带描述：d 为离接缝的距离（0 紧邻源图），t 为沿边缘的位置
+struct SeamBand {
+    QRgb *origin;           // (d = 0, t = 0) 处的像素
+    ptrdiff_t outward;      // d 增加一步的指针偏移
+    ptrdiff_t along;        // t 增加一步的指针偏移
+    int depth;              // 参与求解的边带宽度
+    int length;             // 沿边缘的长度
+    int innerBegin;         // 与源图相邻的 t 范围 [innerBegin, innerEnd)
+    int innerEnd;
+    bool deepSource;        // 源图在向内方向上至少两个像素
+    bool pinnedBegin;       // t = -1 / t = length 处为已知修正量（Dirichlet 边界），否则为 Neumann 边界
+    bool pinnedEnd;
+};
+
+inline int channelOf(QRgb pixel, int channel)
+{
+    return static_cast<int>((pixel >> (24 - 8 * channel)) & 0xff);
+}
+
+// 外侧恒为 Dirichlet 边界，预条件后的条件数随边带宽度平方增长，CG 迭代次数与宽度成正比
+constexpr int MAX_ITERATIONS = 200;
+constexpr int ITERATIONS_PER_DEPTH = 8;
+constexpr double TOLERANCE = 1e-3;
+
+class BandSolver
+{
+public:
+    explicit BandSolver(const SeamBand &band)
+        : m_band(band)
+        , m_count(static_cast<size_t>(band.depth) * band.length)
+        , m_diagonal(m_count)
+    {
+        for (int d = 0; d < band.depth; ++d) {
+            for (int t = 0; t < band.length; ++t) {
+                int neighbours = 0;
+                neighbours += t > 0 || band.pinnedBegin ? 1 : 0;
+                neighbours += t + 1 < band.length || band.pinnedEnd ? 1 : 0;
+                neighbours += d > 0 || isInner(t) ? 1 : 0;
+                // 外侧为剩余的填充像素或画布边缘，两者都保持填充不变（c = 0）
+                neighbours += 1;
+                m_diagonal[index(d, t)] = static_cast<float>(qMax(1, neighbours));
+            }
+        }
+    }
+    
+    // 求解单个通道的修正量 c；beginValues / endValues 为两端固定边界上各深度的修正量，
+    // 达到迭代上限仍未满足容差时 converged 置为 false
+    std::vector<float> solve(int channel, const std::vector<float> &beginValues,
+                             const std::vector<float> &endValues, bool *converged) const
+    {
+        std::vector<float> b(m_count, 0.0f);
+        *converged = true;
+        
+        for (int d = 0; d < m_band.depth; ++d) {
+            if (m_band.pinnedBegin) {
+                b[index(d, 0)] += beginValues[d];
+            }
+            if (m_band.pinnedEnd) {
+                b[index(d, m_band.length - 1)] += endValues[d];
+            }
+        }
+        for (int t = m_band.innerBegin; t < m_band.innerEnd; ++t) {
+            const QRgb *edge = m_band.origin - m_band.outward + t * m_band.along;
+            const QRgb *inside = m_band.deepSource ? edge - m_band.outward : edge;
+            const QRgb fill = m_band.origin[t * m_band.along];
+            
+            // 源图沿接缝向外线性外推的值与填充值之差
+            const float value = static_cast<float>(2 * channelOf(*edge, channel) -
+                                                   channelOf(*inside, channel) -
+                                                   channelOf(fill, channel));
+            b[index(0, t)] += value;
+        }
+        const double bNorm = dot(b, b);
+        
+        std::vector<float> x(m_count, 0.0f);
+        if (bNorm == 0.0) {
+            return x;
+        }
+        
+        // 预条件共轭梯度（Jacobi 预条件）
+        std::vector<float> r = b;
+        std::vector<float> z(m_count);
+        std::vector<float> p(m_count);
+        std::vector<float> q(m_count);
+        
+        for (size_t i = 0; i < m_count; ++i) {
+            z[i] = r[i] / m_diagonal[i];
+        }
+        p = z;
+        double rz = dot(r, z);
+        const double threshold = TOLERANCE * TOLERANCE * bNorm;
+        
+        *converged = false;
+        const int maxIterations = qMax(MAX_ITERATIONS, ITERATIONS_PER_DEPTH * m_band.depth);
+        for (int iteration = 0; iteration < maxIterations; ++iteration) {
+            apply(p, q);
+            const double alpha = rz / dot(p, q);
+            double rr = 0.0;
+            for (size_t i = 0; i < m_count; ++i) {
+                x[i] += static_cast<float>(alpha * p[i]);
+                r[i] -= static_cast<float>(alpha * q[i]);
+                rr += static_cast<double>(r[i]) * r[i];
+            }
+            if (rr < threshold) {
+                *converged = true;
+                break;
+            }
+            
+            for (size_t i = 0; i < m_count; ++i) {
+                z[i] = r[i] / m_diagonal[i];
+            }
+            const double rzNext = dot(r, z);
+            const double beta = rzNext / rz;
+            rz = rzNext;
+            for (size_t i = 0; i < m_count; ++i) {
+                p[i] = z[i] + static_cast<float>(beta * p[i]);
+            }
+        }
+        
+        return x;
+    }
+    
+    void write(const std::vector<float> corrections[4]) const
+    {
+        for (int d = 0; d < m_band.depth; ++d) {
+            QRgb *line = m_band.origin + d * m_band.outward;
+            for (int t = 0; t < m_band.length; ++t) {
+                QRgb &pixel = line[t * m_band.along];
+                QRgb result = 0;
+                for (int c = 0; c < 4; ++c) {
+                    const float value = channelOf(pixel, c) + corrections[c][index(d, t)];
+                    const int clamped = qBound(0, static_cast<int>(std::lround(value)), 255);
+                    result |= static_cast<QRgb>(clamped) << (24 - 8 * c);
+                }
+                pixel = result;
+            }
+        }
+    }
+    
+private:
+    size_t index(int d, int t) const
+    {
+        return static_cast<size_t>(d) * m_band.length + t;
+    }
+    
+    bool isInner(int t) const
+    {
+        return t >= m_band.innerBegin && t < m_band.innerEnd;
+    }
+    
+    // q = A p，A 为边带上带边界条件的离散拉普拉斯矩阵
+    void apply(const std::vector<float> &p, std::vector<float> &q) const
+    {
+        const int length = m_band.length;
+        for (int d = 0; d < m_band.depth; ++d) {
+            const size_t row = static_cast<size_t>(d) * length;
+            for (int t = 0; t < length; ++t) {
+                const size_t i = row + t;
+                float sum = m_diagonal[i] * p[i];
+                if (t > 0) sum -= p[i - 1];
+                if (t + 1 < length) sum -= p[i + 1];
+                if (d > 0) sum -= p[i - length];
+                if (d + 1 < m_band.depth) sum -= p[i + length];
+                q[i] = sum;
+            }
+        }
+    }
+    
+    static double dot(const std::vector<float> &a, const std::vector<float> &b)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            sum += static_cast<double>(a[i]) * b[i];
+        }
+        return sum;
+    }
+    
+    const SeamBand m_band;
+    const size_t m_count;
+    std::vector<float> m_diagonal;
+};
+
+} // namespace
+
+bool PoissonSeamBlend::blend(QImage &canvas, const QRect &sourceRect, int bandWidth)
+{
+    if (sourceRect.isEmpty() || bandWidth <= 0) {
+        return true;
+    }
+    
+    const ptrdiff_t stride = canvas.bytesPerLine() / static_cast<int>(sizeof(QRgb));
+    QRgb *topLine = reinterpret_cast<QRgb*>(canvas.scanLine(sourceRect.top()));
+    QRgb *bottomLine = reinterpret_cast<QRgb*>(canvas.scanLine(sourceRect.bottom()));
+    
+    const int top = sourceRect.top();
+    const int bottom = canvas.height() - sourceRect.bottom() - 1;
+    const int left = sourceRect.left();
+    const int right = canvas.width() - sourceRect.right() - 1;
+    const bool pinTop = qMin(bandWidth, top) > 0;
+    const bool pinBottom = qMin(bandWidth, bottom) > 0;
+    
+    // 上下边带横跨整个画布宽度，使修正量平滑扩散到四角；
+    // 左右边带的两端固定为上下边带在四角处的解，角上不再出现台阶
+    const SeamBand bands[4] = {
+        { topLine - stride, -stride, 1, qMin(bandWidth, top), canvas.width(),
+          sourceRect.left(), sourceRect.right() + 1, sourceRect.height() > 1, false, false },
+        { bottomLine + stride, stride, 1, qMin(bandWidth, bottom), canvas.width(),
+          sourceRect.left(), sourceRect.right() + 1, sourceRect.height() > 1, false, false },
+        { topLine + sourceRect.left() - 1, -1, stride, qMin(bandWidth, left), sourceRect.height(),
+          0, sourceRect.height(), sourceRect.width() > 1, pinTop, pinBottom },
+        { topLine + sourceRect.right() + 1, 1, stride, qMin(bandWidth, right), sourceRect.height(),
+          0, sourceRect.height(), sourceRect.width() > 1, pinTop, pinBottom }
+    };
+    // 左右边带深度 d 处所在的列
+    const int sideColumn[2] = { sourceRect.left() - 1, sourceRect.right() + 1 };
+    const int sideStep[2] = { -1, 1 };
+    
+    // 先求解全部边带与通道，再统一写回，避免读写冲突
+    std::vector<float> corrections[4][4];
+    bool converged[4][4];
+    const std::vector<float> none;
+    
+    // 第一阶段：上下边带
+    parallelFor(8, [&](int task) {
+        const int i = task / 4;
+        const int c = task % 4;
+        converged[i][c] = true;
+        if (bands[i].depth > 0 && bands[i].length > 0) {
+            corrections[i][c] = BandSolver(bands[i]).solve(c, none, none, &converged[i][c]);
+        }
+    });
+    
+    // 第二阶段：左右边带，两端取上下边带紧邻源图一行（d = 0）在同一列的修正量
+    parallelFor(8, [&](int task) {
+        const int i = 2 + task / 4;
+        const int c = task % 4;
+        const SeamBand &band = bands[i];
+        converged[i][c] = true;
+        if (band.depth <= 0 || band.length <= 0) {
+            return;
+        }
+        std::vector<float> beginValues(band.pinnedBegin ? band.depth : 0);
+        std::vector<float> endValues(band.pinnedEnd ? band.depth : 0);
+        for (int d = 0; d < band.depth; ++d) {
+            const size_t column = static_cast<size_t>(sideColumn[i - 2] + sideStep[i - 2] * d);
+            if (band.pinnedBegin) {
+                beginValues[d] = corrections[0][c][column];
+            }
+            if (band.pinnedEnd) {
+                endValues[d] = corrections[1][c][column];
+            }
+        }
+        corrections[i][c] = BandSolver(band).solve(c, beginValues, endValues, &converged[i][c]);
+    });
+    
+    // 未收敛的近似解不写回
+    for (int i = 0; i < 4; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            if (!converged[i][c]) {
+                return false;
+            }
+        }
+    }
+    
+    parallelFor(4, [&bands, &corrections](int i) {
+        if (bands[i].depth > 0 && bands[i].length > 0) {
+            BandSolver(bands[i]).write(corrections[i]);
+        }
+    });
+    return true;
+}
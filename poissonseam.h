@@ -0,0 +1,22 @@
+#ifndef POISSONSEAM_H
+#define POISSONSEAM_H
+
+#include <QImage>
+#include <QRect>
+
+// 泊松无缝接缝融合
+// 在紧邻源图、宽 bandWidth 的边带内求解 ∇²f = div v：
+// 边带内部的引导梯度取自填充内容，跨接缝处取源图向外延续的梯度；
+// 内侧以源图、外侧以填充内容为边界（边距不比边带宽时外侧即画布边缘，该处保持填充不变）；
+// 上下边带横跨整个画布，两端为 Neumann 边界，左右边带的两端固定为上下边带在四角处的解，四角连续。
+// 外侧恒为 Dirichlet 边界，迭代次数只随边带宽度增长，与边距长度无关。
+// 令 f = 填充 + c，c 满足调和方程，只在接缝处有源项，用预条件共轭梯度求解。
+// 先并行求解上下边带的四个通道，再并行求解左右边带。
+class PoissonSeamBlend
+{
+public:
+    // 有边带在迭代上限内未达到容差时返回 false，画布保持不变
+    static bool blend(QImage &canvas, const QRect &sourceRect, int bandWidth);
+};
+
+#endif // POISSONSEAM_H
@@ -0,0 +1,344 @@
+#include "resampler.h"
+#include "parallelfor.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// 系数定点精度：权重之和为 1 << COEFFICIENT_SHIFT，单个权重可超过 1（Lanczos 正瓣）
+constexpr int COEFFICIENT_SHIFT = 14;
+constexpr int COEFFICIENT_ONE = 1 << COEFFICIENT_SHIFT;
+constexpr int ROUNDING = 1 << (COEFFICIENT_SHIFT - 1);
+constexpr int ROWS_PER_TASK = 32;
+constexpr double PI = 3.14159265358979323846;
+
+double sinc(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= PI;
+    return std::sin(x) / x;
+}
+
+double filterSupport(Resampler::Filter filter)
+{
+    switch (filter) {
+    case Resampler::Box:
+        return 0.5;
+    case Resampler::Bilinear:
+        return 1.0;
+    case Resampler::Bicubic:
+        return 2.0;
+    case Resampler::Lanczos3:
+        break;
+    }
+    return 3.0;
+}
+
+double filterWeight(Resampler::Filter filter, double x)
+{
+    switch (filter) {
+    case Resampler::Box:
+        return x >= -0.5 && x < 0.5 ? 1.0 : 0.0;
+    case Resampler::Bilinear:
+        x = std::fabs(x);
+        return x < 1.0 ? 1.0 - x : 0.0;
+    case Resampler::Bicubic: {
+        const double a = -0.5;
+        x = std::fabs(x);
+        if (x < 1.0) {
+            return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        }
+        if (x < 2.0) {
+            return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+        }
+        return 0.0;
+    }
+    case Resampler::Lanczos3:
+        break;
+    }
+    return std::fabs(x) < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+// 一个方向上的全部滤波系数：输出 i 使用输入 [start[i], start[i] + count[i])，
+// 权重存放在 weights[i * stride ...]
+struct Coefficients {
+    std::vector<int> start;
+    std::vector<int> count;
+    std::vector<qint16> weights;
+    int stride;
+
+    Coefficients(int inSize, int outSize, Resampler::Filter filter)
+        : start(outSize)
+        , count(outSize)
+        , stride(0)
+    {
+        const double scale = static_cast<double>(inSize) / outSize;
+        const double filterScale = qMax(scale, 1.0);
+        const double support = filterSupport(filter) * filterScale;
+        stride = static_cast<int>(std::ceil(support)) * 2 + 1;
+        weights.assign(static_cast<size_t>(outSize) * stride, 0);
+
+        std::vector<double> taps(stride);
+        for (int i = 0; i < outSize; ++i) {
+            const double center = (i + 0.5) * scale;
+            const int first = qMax(static_cast<int>(center - support + 0.5), 0);
+            const int last = qMin(static_cast<int>(center + support + 0.5), inSize);
+            const int n = qMin(qMax(last - first, 1), stride);
+
+            double total = 0.0;
+            for (int k = 0; k < n; ++k) {
+                taps[k] = filterWeight(filter, (first + k - center + 0.5) / filterScale);
+                total += taps[k];
+            }
+            if (total == 0.0) {
+                // 极端缩放下窗口内权重全为 0 时退化为最近邻
+                taps[0] = total = 1.0;
+                for (int k = 1; k < n; ++k) {
+                    taps[k] = 0.0;
+                }
+            }
+
+            // 量化后把舍入误差补到最大权重上，保证权重和精确等于 1
+            qint16 *w = weights.data() + static_cast<size_t>(i) * stride;
+            int sum = 0;
+            int largest = 0;
+            for (int k = 0; k < n; ++k) {
+                w[k] = static_cast<qint16>(qRound(taps[k] / total * COEFFICIENT_ONE));
+                sum += w[k];
+                if (w[k] > w[largest]) {
+                    largest = k;
+                }
+            }
+            w[largest] = static_cast<qint16>(w[largest] + COEFFICIENT_ONE - sum);
+
+            start[i] = first;
+            count[i] = n;
+        }
+    }
+};
+
+inline quint32 clampChannel(int value)
+{
+    return static_cast<quint32>(qBound(0, value >> COEFFICIENT_SHIFT, 255));
+}
+
+// 水平一遍：一行源像素 → 一行输出像素
+void resampleRow(const quint32 *src, quint32 *dst, int outWidth, const Coefficients &c)
+{
+    for (int x = 0; x < outWidth; ++x) {
+        const quint32 *p = src + c.start[x];
+        const qint16 *w = c.weights.data() + static_cast<size_t>(x) * c.stride;
+        const int n = c.count[x];
+#ifdef RESAMPLER_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        __m128i acc = _mm_set1_epi32(ROUNDING);
+        int k = 0;
+        for (; k + 1 < n; k += 2) {
+            // 交错两个像素的字节，使 madd 一次完成两个抽头的乘加：[b0 b1 g0 g1 r0 r1 a0 a1]
+            const __m128i pair = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(p[k])),
+                                                   _mm_cvtsi32_si128(static_cast<int>(p[k + 1])));
+            const __m128i weight = _mm_set1_epi32((static_cast<int>(w[k + 1]) << 16) |
+                                                  static_cast<quint16>(w[k]));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(pair, zero), weight));
+        }
+        if (k < n) {
+            const __m128i single = _mm_unpacklo_epi16(
+                _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(p[k])), zero), zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(single, _mm_set1_epi32(static_cast<quint16>(w[k]))));
+        }
+        acc = _mm_srai_epi32(acc, COEFFICIENT_SHIFT);
+        acc = _mm_packs_epi32(acc, acc);
+        dst[x] = static_cast<quint32>(_mm_cvtsi128_si32(_mm_packus_epi16(acc, acc)));
+#else
+        int b = ROUNDING, g = ROUNDING, r = ROUNDING, a = ROUNDING;
+        for (int k = 0; k < n; ++k) {
+            b += static_cast<int>(p[k] & 0xff) * w[k];
+            g += static_cast<int>((p[k] >> 8) & 0xff) * w[k];
+            r += static_cast<int>((p[k] >> 16) & 0xff) * w[k];
+            a += static_cast<int>(p[k] >> 24) * w[k];
+        }
+        dst[x] = clampChannel(b) | (clampChannel(g) << 8) | (clampChannel(r) << 16) | (clampChannel(a) << 24);
+#endif
+    }
+}
+
+// 垂直一遍：若干输入行按同一组权重加权求和为一行输出
+void resampleColumn(const quint32 *const *rows, const qint16 *w, int n, quint32 *dst, int width)
+{
+    int x = 0;
+#ifdef RESAMPLER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 4 <= width; x += 4) {
+        __m128i acc0 = _mm_set1_epi32(ROUNDING);
+        __m128i acc1 = acc0;
+        __m128i acc2 = acc0;
+        __m128i acc3 = acc0;
+        int k = 0;
+        for (; k + 1 < n; k += 2) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + x));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k + 1] + x));
+            const __m128i weight = _mm_set1_epi32((static_cast<int>(w[k + 1]) << 16) |
+                                                  static_cast<quint16>(w[k]));
+            const __m128i lo = _mm_unpacklo_epi8(a, b);
+            const __m128i hi = _mm_unpackhi_epi8(a, b);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weight));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weight));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weight));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weight));
+        }
+        if (k < n) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + x));
+            const __m128i weight = _mm_set1_epi32(static_cast<quint16>(w[k]));
+            const __m128i lo = _mm_unpacklo_epi8(a, zero);
+            const __m128i hi = _mm_unpackhi_epi8(a, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(lo, zero), weight));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(lo, zero), weight));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(hi, zero), weight));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(hi, zero), weight));
+        }
+        const __m128i first = _mm_packs_epi32(_mm_srai_epi32(acc0, COEFFICIENT_SHIFT),
+                                              _mm_srai_epi32(acc1, COEFFICIENT_SHIFT));
+        const __m128i second = _mm_packs_epi32(_mm_srai_epi32(acc2, COEFFICIENT_SHIFT),
+                                               _mm_srai_epi32(acc3, COEFFICIENT_SHIFT));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(first, second));
+    }
+#endif
+    for (; x < width; ++x) {
+        int b = ROUNDING, g = ROUNDING, r = ROUNDING, a = ROUNDING;
+        for (int k = 0; k < n; ++k) {
+            const quint32 p = rows[k][x];
+            b += static_cast<int>(p & 0xff) * w[k];
+            g += static_cast<int>((p >> 8) & 0xff) * w[k];
+            r += static_cast<int>((p >> 16) & 0xff) * w[k];
+            a += static_cast<int>(p >> 24) * w[k];
+        }
+        dst[x] = clampChannel(b) | (clampChannel(g) << 8) | (clampChannel(r) << 16) | (clampChannel(a) << 24);
+    }
+}
+
+// 预乘格式中振铃可能使颜色分量超过 alpha，需要截断回合法范围
+void clampPremultiplied(quint32 *line, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        const quint32 p = line[x];
+        const quint32 a = p >> 24;
+        const quint32 r = qMin((p >> 16) & 0xff, a);
+        const quint32 g = qMin((p >> 8) & 0xff, a);
+        const quint32 b = qMin(p & 0xff, a);
+        line[x] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+} // namespace
+
+QImage Resampler::resize(const QImage &source, const QSize &size, Filter filter)
+{
+    if (source.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+
+    const QImage::Format format = source.hasAlphaChannel()
+        ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    const QImage input = source.convertToFormat(format);
+    const int inWidth = input.width();
+    const int inHeight = input.height();
+    const int outWidth = size.width();
+    const int outHeight = size.height();
+    if (inWidth == outWidth && inHeight == outHeight) {
+        return input;
+    }
+
+    const auto row = [](const QImage &image, int y) {
+        return reinterpret_cast<const quint32*>(image.constScanLine(y));
+    };
+
+    // 水平一遍：只处理垂直方向会用到的源行；宽度不变时直接使用源图
+    QImage horizontal;
+    int firstRow = 0;
+    if (inWidth != outWidth) {
+        const Coefficients columns(inWidth, outWidth, filter);
+        int lastRow = inHeight;
+        if (inHeight != outHeight) {
+            const Coefficients rows(inHeight, outHeight, filter);
+            firstRow = rows.start.front();
+            lastRow = rows.start.back() + rows.count.back();
+        }
+        horizontal = QImage(outWidth, lastRow - firstRow, format);
+        if (horizontal.isNull()) {
+            return QImage();
+        }
+        uchar *bits = horizontal.bits();
+        const qsizetype bytesPerLine = horizontal.bytesPerLine();
+        const bool premultiplied = format == QImage::Format_ARGB32_Premultiplied;
+        const int rowCount = lastRow - firstRow;
+        const int tasks = (rowCount + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+        parallelFor(tasks, [&](int task) {
+            const int end = qMin(rowCount, (task + 1) * ROWS_PER_TASK);
+            for (int y = task * ROWS_PER_TASK; y < end; ++y) {
+                quint32 *dst = reinterpret_cast<quint32*>(bits + y * bytesPerLine);
+                resampleRow(row(input, firstRow + y), dst, outWidth, columns);
+                if (premultiplied) {
+                    clampPremultiplied(dst, outWidth);
+                }
+            }
+        });
+    } else {
+        horizontal = input;
+    }
+
+    if (inHeight == outHeight) {
+        return horizontal;
+    }
+
+    // 垂直一遍
+    const Coefficients rows(inHeight, outHeight, filter);
+    QImage result(outWidth, outHeight, format);
+    if (result.isNull()) {
+        return QImage();
+    }
+    uchar *bits = result.bits();
+    const qsizetype bytesPerLine = result.bytesPerLine();
+    const bool premultiplied = format == QImage::Format_ARGB32_Premultiplied;
+    const int tasks = (outHeight + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    parallelFor(tasks, [&](int task) {
+        std::vector<const quint32*> taps(rows.stride);
+        const int end = qMin(outHeight, (task + 1) * ROWS_PER_TASK);
+        for (int y = task * ROWS_PER_TASK; y < end; ++y) {
+            const int n = rows.count[y];
+            for (int k = 0; k < n; ++k) {
+                taps[k] = row(horizontal, rows.start[y] + k - firstRow);
+            }
+            quint32 *dst = reinterpret_cast<quint32*>(bits + y * bytesPerLine);
+            resampleColumn(taps.data(), rows.weights.data() + static_cast<size_t>(y) * rows.stride,
+                           n, dst, outWidth);
+            if (premultiplied) {
+                clampPremultiplied(dst, outWidth);
+            }
+        }
+    });
+
+    return result;
+}
+
+const char *Resampler::filterName(Filter filter)
+{
+    switch (filter) {
+    case Box:
+        return "box";
+    case Bilinear:
+        return "bilinear";
+    case Bicubic:
+        return "bicubic";
+    case Lanczos3:
+        break;
+    }
+    return "lanczos3";
+}
@@ -0,0 +1,26 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QImage>
+#include <QSize>
+
+// 可分离重采样引擎
+// 为每个输出行/列预先计算定点滤波系数，先水平后垂直两遍卷积；
+// 两遍均以 SSE2 乘加指令同时处理四个通道，按行分块在线程池中并行。
+// 带 alpha 的图像在预乘空间中滤波，结果为 ARGB32_Premultiplied；其余为 RGB32
+class Resampler
+{
+public:
+    enum Filter {
+        Box,        // 盒式（面积平均）
+        Bilinear,   // 三角形（双线性）
+        Bicubic,    // Keys 三次卷积（a = -0.5）
+        Lanczos3    // Lanczos，3 瓣
+    };
+
+    static QImage resize(const QImage &source, const QSize &size, Filter filter = Lanczos3);
+
+    static const char *filterName(Filter filter);
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,138 @@
+#include "variantexporter.h"
+#include "imageprocessor.h"
+#include "parallelfor.h"
+#include <QDir>
+#include <QSet>
+#include <QRegularExpression>
+#include <atomic>
+
+VariantExporter::VariantExporter(const ImageProcessor *processor)
+    : m_processor(processor)
+    , m_nameTemplate(defaultNameTemplate())
+    , m_format("png")
+    , m_encoderSettings(ImageExporter::defaultEncoderSettings())
+{
+}
+
+QVector<VariantExporter::Variant> VariantExporter::exportVariants(const OrientedImage &source,
+                                                                const QString &baseName,
+                                                                const QColor &backgroundColor,
+                                                                const QStringList &ratios,
+                                                                const QString &outputDirectory,
+                                                                const std::atomic<bool> *cancelled,
+                                                                const ImageExporter::ProgressCallback &progress) const
+{
+    QVector<Variant> variants(ratios.size());
+    if (source.isNull() || ratios.isEmpty()) {
+        return variants;
+    }
+    
+    // 统一转换一次，各版本渲染时不再重复转换格式；方向仍作为元数据，在合成时一并完成
+    const OrientedImage prepared(source.hasAlphaChannel()
+                                 ? source.storedImage().convertToFormat(QImage::Format_ARGB32)
+                                 : source.storedImage().convertToFormat(QImage::Format_RGB32),
+                                 source.transformation());
+    
+    // 先在当前线程计算所有扩展量并确定文件名
+    QVector<ImageProcessor::ExpansionValues> expansions(ratios.size());
+    QSet<QString> usedPaths;
+    for (int i = 0; i < ratios.size(); ++i) {
+        Variant &variant = variants[i];
+        variant.ratio = ratios[i];
+        variant.success = false;
+        
+        ImageProcessor::ExpansionValues &expansion = expansions[i];
+        expansion = m_processor->calculateSmartExpansion(prepared.size(), ratios[i], "center");
+        if (expansion.alreadySatisfied) {
+            // 源图已是该比例，按原尺寸导出
+            expansion.isValid = true;
+        }
+        if (!expansion.isValid) {
+            variant.errorMessage = expansion.errorMessage;
+            continue;
+        }
+        
+        variant.size = QSize(prepared.width() + expansion.left + expansion.right,
+                             prepared.height() + expansion.top + expansion.bottom);
+        const QString fileName = formatName(m_nameTemplate, baseName, ratios[i], variant.size, i + 1);
+        variant.filePath = QDir(outputDirectory).filePath(fileName + "." + m_format);
+        
+        // 模板不含区分版本的占位符或比例写法不同但标签相同（16:9 与 16/9）时文件名会重复，
+        // 多个线程写同一文件会互相破坏，重复的名称依次加序号后缀
+        // （不区分大小写比较，兼容不区分大小写的文件系统）
+        for (int n = 2; usedPaths.contains(QDir::cleanPath(variant.filePath).toLower()); ++n) {
+            variant.filePath = QDir(outputDirectory).filePath(
+                QString("%1_%2.%3").arg(fileName).arg(n).arg(m_format));
+        }
+        usedPaths.insert(QDir::cleanPath(variant.filePath).toLower());
+    }
+    
+    // 各版本的渲染与编码互不依赖，并行执行
+    std::atomic<int> finished(0);
+    const auto report = [&]() {
+        const int done = ++finished;
+        if (progress) {
+            progress(static_cast<int>(done * 100 / ratios.size()),
+                     QString("版本 %1/%2").arg(done).arg(ratios.size()));
+        }
+    };
+    parallelFor(ratios.size(), [&](int i) {
+        Variant &variant = variants[i];
+        const ImageProcessor::ExpansionValues &expansion = expansions[i];
+        if (!expansion.isValid) {
+            report();
+            return;
+        }
+        if (cancelled && cancelled->load()) {
+            variant.errorMessage = "导出已取消";
+            report();
+            return;
+        }
+        
+        const QImage result = m_processor->renderExpansion(prepared, backgroundColor,
+                                                           expansion.top, expansion.bottom,
+                                                           expansion.left, expansion.right);
+        if (result.isNull()) {
+            variant.errorMessage = "渲染失败";
+        } else if (!ImageExporter::write(result, variant.filePath, m_encoderSettings,
+                                         &variant.errorMessage, cancelled)) {
+            if (!cancelled || !cancelled->load()) {
+                variant.errorMessage = "无法写入文件：" + variant.filePath + "（" + variant.errorMessage + "）";
+            }
+        } else {
+            variant.success = true;
+        }
+        report();
+    });
+    
+    return variants;
+}
+
+QStringList VariantExporter::parseRatioList(const QString &text)
+{
+    QStringList ratios;
+    const QStringList parts = text.split(QRegularExpression("[,;\\s]+"));
+    for (const QString &part : parts) {
+        const QString ratio = part.trimmed();
+        if (!ratio.isEmpty() && !ratios.contains(ratio)) {
+            ratios.append(ratio);
+        }
+    }
+    return ratios;
+}
+
+QString VariantExporter::formatName(const QString &nameTemplate, const QString &baseName,
+                                    const QString &ratio, const QSize &size, int index)
+{
+    // 比例中的分隔符不能出现在文件名里
+    QString ratioLabel = ratio;
+    ratioLabel.replace(QRegularExpression("[:/]"), "x");
+    
+    QString name = nameTemplate;
+    name.replace("{name}", baseName);
+    name.replace("{ratio}", ratioLabel);
+    name.replace("{width}", QString::number(size.width()));
+    name.replace("{height}", QString::number(size.height()));
+    name.replace("{index}", QString::number(index));
+    return name;
+}
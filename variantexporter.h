@@ -0,0 +1,71 @@
+#ifndef VARIANTEXPORTER_H
+#define VARIANTEXPORTER_H
+
+#include <QImage>
+#include <QColor>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "imageexporter.h"
+#include "orientedimage.h"
+
+class ImageProcessor;
+
+// 多比例版本导出
+// 源图只解码、转换一次，各目标比例的扩展量由智能比例计算得到，
+// 渲染与编码在线程池中并行执行，共享同一份源图数据
+class VariantExporter
+{
+public:
+    // 单个版本的导出结果
+    struct Variant {
+        QString ratio;
+        QString filePath;
+        QSize size;
+        bool success;
+        QString errorMessage;
+    };
+    
+    explicit VariantExporter(const ImageProcessor *processor);
+    
+    // 文件名模板，可用占位符：{name} 源文件名、{ratio} 比例（如 16x9）、
+    // {width} {height} 输出尺寸、{index} 序号（从 1 开始）
+    void setNameTemplate(const QString &nameTemplate) { m_nameTemplate = nameTemplate; }
+    QString nameTemplate() const { return m_nameTemplate; }
+    
+    // 输出格式后缀（png、jpg 等）
+    void setFormat(const QString &suffix) { m_format = suffix; }
+    QString format() const { return m_format; }
+    
+    void setEncoderSettings(const ImageExporter::EncoderSettings &settings) { m_encoderSettings = settings; }
+    ImageExporter::EncoderSettings encoderSettings() const { return m_encoderSettings; }
+    
+    // 可在任意线程调用；cancelled 置位后跳过尚未开始的版本并中止正在写入的文件，
+    // progress 按已完成的版本数报告（在工作线程中调用）
+    QVector<Variant> exportVariants(const OrientedImage &source,
+                                    const QString &baseName,
+                                    const QColor &backgroundColor,
+                                    const QStringList &ratios,
+                                    const QString &outputDirectory,
+                                    const std::atomic<bool> *cancelled = nullptr,
+                                    const ImageExporter::ProgressCallback &progress
+                                        = ImageExporter::ProgressCallback()) const;
+    
+    // 解析以逗号、分号或空白分隔的比例列表
+    static QStringList parseRatioList(const QString &text);
+    
+    static QString formatName(const QString &nameTemplate, const QString &baseName,
+                              const QString &ratio, const QSize &size, int index);
+    
+    static const char *defaultNameTemplate() { return "{name}_{ratio}"; }
+    static const char *defaultRatios() { return "1:1, 4:5, 16:9, 9:16"; }
+
+private:
+    const ImageProcessor *m_processor;
+    QString m_nameTemplate;
+    QString m_format;
+    ImageExporter::EncoderSettings m_encoderSettings;
+};
+
+#endif // VARIANTEXPORTER_H